@@ -21,10 +21,13 @@
  * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
  * THE SOFTWARE.
  */
+#include <algorithm>
 #include <cctype>
+#include <mutex>
 
 #include <graphene/app/api.hpp>
 #include <graphene/app/api_access.hpp>
+#include <graphene/app/api_thread_pool.hpp>
 #include <graphene/app/application.hpp>
 #include <graphene/app/impacted.hpp>
 #include <graphene/chain/database.hpp>
@@ -37,6 +40,7 @@
 #include <graphene/chain/withdraw_permission_object.hpp>
 #include <graphene/chain/worker_object.hpp>
 
+#include <fc/crypto/base64.hpp>
 #include <fc/crypto/hex.hpp>
 #include <fc/smart_ref_impl.hpp>
 #include <fc/thread/future.hpp>
@@ -79,6 +83,12 @@ namespace graphene { namespace app {
        if( api_name == "database_api" )
        {
           _database_api = std::make_shared< database_api >( std::ref( *_app.chain_database() ) );
+          if( auto pool = _app.api_threads() )
+             // validate_transaction() applies the transaction in an undo session, so it needs the write lock
+             pool->wrap( *_database_api, { "set_subscribe_callback", "set_pending_transaction_callback",
+                                           "set_block_applied_callback", "cancel_all_subscriptions",
+                                           "subscribe_to_market", "unsubscribe_from_market",
+                                           "validate_transaction" } );
        }
        else if( api_name == "block_api" )
        {
@@ -91,6 +101,8 @@ namespace graphene { namespace app {
        else if( api_name == "history_api" )
        {
           _history_api = std::make_shared< history_api >( _app );
+          if( auto pool = _app.api_threads() )
+             pool->wrap( *_history_api );
        }
        else if( api_name == "network_node_api" )
        {
@@ -103,6 +115,8 @@ namespace graphene { namespace app {
        else if( api_name == "asset_api" )
        {
           _asset_api = std::make_shared< asset_api >( std::ref( *_app.chain_database() ) );
+          if( auto pool = _app.api_threads() )
+             pool->wrap( *_asset_api );
        }
        else if( api_name == "debug_api" )
        {
@@ -110,12 +124,41 @@ namespace graphene { namespace app {
           if( _app.get_plugin( "debug_witness" ) )
              _debug_api = std::make_shared< graphene::debug_witness::debug_api >( std::ref(_app) );
        }
+       else if( api_name == "profiler_api" )
+       {
+          _profiler_api = std::make_shared< profiler_api >( std::ref( *_app.chain_database() ) );
+       }
        return;
     }
 
     // block_api
+
+    /** the thread reading the streamed blocks of every connection, it runs while any block_api is alive */
+    static std::shared_ptr<fc::thread> shared_block_stream_thread()
+    {
+       static std::mutex                mutex;
+       static std::weak_ptr<fc::thread> shared;
+       std::lock_guard<std::mutex> guard( mutex );
+       std::shared_ptr<fc::thread> result = shared.lock();
+       if( !result )
+       {
+          result = std::shared_ptr<fc::thread>( new fc::thread( "block stream" ), []( fc::thread* t ) {
+             t->quit();
+             delete t;
+          } );
+          shared = result;
+       }
+       return result;
+    }
+
     block_api::block_api(graphene::chain::database& db) : _db(db) { }
-    block_api::~block_api() { }
+    block_api::~block_api()
+    {
+       // the streams refer to this api, so they have to stop before it goes away
+       for( auto& stream : _streams )
+          if( !stream.ready() )
+             stream.cancel_and_wait( "block_api destroyed" );
+    }
 
     vector<optional<signed_block>> block_api::get_blocks(uint32_t block_num_from, uint32_t block_num_to)const
     {
@@ -127,6 +170,119 @@ namespace graphene { namespace app {
        return res;
     }
 
+    void block_api::stream_blocks( block_stream_callback callback, uint32_t block_num_from, uint32_t block_num_to,
+                                   const block_stream_options& options )
+    {
+       FC_ASSERT( block_num_to >= block_num_from );
+       FC_ASSERT( options.encoding == "json" || options.encoding == "hex" || options.encoding == "base64",
+                  "Unknown encoding ${e}", ("e", options.encoding) );
+       FC_ASSERT( options.max_chunk_blocks > 0 && options.max_chunk_blocks <= 1000 );
+       if( options.include_operations )
+          _db.get_index_type<operation_history_index>(); // throws without the account history plugin
+
+       if( !_stream_thread )
+          _stream_thread = shared_block_stream_thread();
+       _streams.erase( std::remove_if( _streams.begin(), _streams.end(),
+                                       []( const fc::future<void>& f ) { return f.ready(); } ),
+                       _streams.end() );
+       fc::thread* origin = &fc::thread::current();
+       _streams.push_back( _stream_thread->async( [this,origin,callback,block_num_from,block_num_to,options]() {
+          stream_block_range( origin, callback, block_num_from, block_num_to, options );
+       }, "Stream blocks" ) );
+    }
+
+    /** the operations applied by a block, found by bisecting the ids as they are numbered in the order of the blocks */
+    static vector<operation_history_object> operations_of_block( const database& db, uint32_t block_num )
+    {
+       const auto& idx = db.get_index_type<operation_history_index>().indices().get<by_id>();
+       vector<operation_history_object> result;
+       if( idx.empty() )
+          return result;
+       uint64_t lo = 0;
+       uint64_t hi = idx.rbegin()->id.instance() + 1;
+       while( lo < hi )
+       {
+          const uint64_t mid = lo + ( hi - lo ) / 2;
+          auto itr = idx.lower_bound( operation_history_id_type( mid ) );
+          if( itr == idx.end() || itr->block_num >= block_num )
+             hi = mid;
+          else
+             lo = itr->id.instance() + 1;
+       }
+       for( auto itr = idx.lower_bound( operation_history_id_type( lo ) ); itr != idx.end() && itr->block_num == block_num; ++itr )
+          result.push_back( *itr );
+       return result;
+    }
+
+    void block_api::stream_block_range( fc::thread* origin, block_stream_callback callback, uint32_t block_num_from,
+                                        uint32_t block_num_to, const block_stream_options& options )
+    {
+       uint32_t block_num = block_num_from;
+       try
+       {
+          while( block_num != 0 )
+          {
+             block_stream_chunk chunk;
+             chunk.first_block_num = block_num;
+             vector< vector<char> > packed_blocks;
+             {
+                // only the bytes are copied under the lock, decoding and encoding them waits until it is released
+                auto lock = _db.lock_for_reading();
+                const uint32_t last = std::min( block_num_to, _db.head_block_num() );
+                uint64_t bytes = 0;
+                while( block_num <= last && packed_blocks.size() < options.max_chunk_blocks
+                       && ( packed_blocks.empty() || bytes < options.max_chunk_bytes ) )
+                {
+                   auto packed = _db.fetch_packed_block_by_number( block_num );
+                   if( !packed.valid() )
+                      break;
+                   bytes += packed->size;
+                   packed_blocks.emplace_back( packed->data, packed->data + packed->size );
+                   if( options.include_operations )
+                      chunk.operations.push_back( operations_of_block( _db, block_num ) );
+                   ++block_num;
+                }
+                if( packed_blocks.empty() || block_num > last )
+                   block_num = 0;
+                chunk.next_block_num = block_num;
+             }
+
+             for( const auto& packed : packed_blocks )
+             {
+                if( options.encoding == "json" )
+                   chunk.blocks.emplace_back( fc::raw::unpack<signed_block>( packed ) );
+                else if( options.encoding == "hex" )
+                   chunk.blocks.emplace_back( fc::to_hex( packed.data(), packed.size() ) );
+                else
+                   chunk.blocks.emplace_back( fc::base64_encode( (const unsigned char*)packed.data(), packed.size() ) );
+             }
+
+             bool more = origin->async( [callback,&chunk]() { return callback( fc::variant( chunk ) ); },
+                                        "Send block chunk" ).wait();
+             if( !more )
+                break;
+          }
+       }
+       catch( const fc::canceled_exception& )
+       {
+          throw;
+       }
+       catch( const fc::exception& e )
+       {
+          wlog( "Block stream stopped at block ${n}: ${e}", ("n", block_num)("e", e.to_detail_string()) );
+          block_stream_chunk chunk;
+          chunk.first_block_num = block_num;
+          chunk.error = e.to_string();
+          try
+          {
+             origin->async( [callback,&chunk]() { callback( fc::variant( chunk ) ); }, "Send block stream error" ).wait();
+          }
+          catch( const fc::exception& )
+          {
+          }
+       }
+    }
+
     network_broadcast_api::network_broadcast_api(application& a):_app(a)
     {
        _applied_block_connection = _app.chain_database()->applied_block.connect([this](const signed_block& b){ on_applied_block(b); });
@@ -156,6 +312,7 @@ namespace graphene { namespace app {
     void network_broadcast_api::broadcast_transaction(const signed_transaction& trx)
     {
        trx.validate();
+       trx.cache_digests( _app.chain_database()->get_chain_id() );
        _app.chain_database()->push_transaction(trx);
        _app.p2p_node()->broadcast_transaction(trx);
     }
@@ -172,6 +329,7 @@ namespace graphene { namespace app {
 
     void network_broadcast_api::broadcast_block( const signed_block& b )
     {
+       b.cache_digests( _app.chain_database()->get_chain_id() );
        _app.chain_database()->push_block(b);
        _app.p2p_node()->broadcast( net::block_message( b ));
     }
@@ -179,6 +337,7 @@ namespace graphene { namespace app {
     void network_broadcast_api::broadcast_transaction_with_callback(confirmation_callback cb, const signed_transaction& trx)
     {
        trx.validate();
+       trx.cache_digests( _app.chain_database()->get_chain_id() );
        _callbacks[trx.id()] = cb;
        _app.chain_database()->push_transaction(trx);
        _app.p2p_node()->broadcast_transaction(trx);
@@ -268,6 +427,31 @@ namespace graphene { namespace app {
        return *_debug_api;
     }
 
+    fc::api<profiler_api> login_api::profiler() const
+    {
+       FC_ASSERT(_profiler_api);
+       return *_profiler_api;
+    }
+
+    // profiler_api
+    profiler_api::profiler_api(graphene::chain::database& db) : _db(db) { }
+    profiler_api::~profiler_api() { }
+
+    chain_profile profiler_api::get_chain_profile()const
+    {
+       return _db.profiler().report();
+    }
+
+    void profiler_api::enable_profiling( bool enable )
+    {
+       _db.enable_profiling( enable );
+    }
+
+    void profiler_api::reset_profile()
+    {
+       _db.profiler().reset();
+    }
+
     vector<order_history_object> history_api::get_fill_order_history( asset_id_type a, asset_id_type b, uint32_t limit  )const
     {
        FC_ASSERT(_app.chain_database());
@@ -345,7 +529,7 @@ namespace graphene { namespace app {
        {
           if( node->operation_id.instance.value <= start.instance.value ) {
 
-             if(node->operation_id(db).op.which() == operation_id)
+             if( node->op_type == operation_id )
                result.push_back( node->operation_id(db) );
              }
           if( node->next == account_transaction_history_id_type() )
@@ -354,7 +538,7 @@ namespace graphene { namespace app {
        }
        if( stop.instance.value == 0 && result.size() < limit ) {
           const account_transaction_history_object head = account_transaction_history_id_type()(db);
-          if( head.account == account && head.operation_id(db).op.which() == operation_id )
+          if( head.account == account && head.op_type == operation_id )
              result.push_back(head.operation_id(db));
        }
        return result;
@@ -395,6 +579,79 @@ namespace graphene { namespace app {
        return result;
     }
 
+    account_history_page history_api::get_account_history_by_sequence( account_id_type account,
+                                                                       uint32_t start,
+                                                                       unsigned limit,
+                                                                       flat_set<uint16_t> operation_types ) const
+    {
+       FC_ASSERT( _app.chain_database() );
+       const auto& db = *_app.chain_database();
+       FC_ASSERT( limit <= 100 );
+       account_history_page page;
+       if( start == 0 )
+          start = std::numeric_limits<uint32_t>::max();
+       const auto& hist_idx = db.get_index_type<account_transaction_history_index>().indices();
+
+       if( operation_types.empty() )
+       {
+          const auto& by_seq_idx = hist_idx.get<by_seq>();
+          auto itr = by_seq_idx.upper_bound( boost::make_tuple( account, start ) );
+          while( itr != by_seq_idx.begin() )
+          {
+             --itr;
+             if( itr->account != account )
+                break;
+             if( page.operations.size() == limit )
+             {
+                page.next = itr->sequence;
+                break;
+             }
+             page.operations.push_back( itr->operation_id(db) );
+          }
+          return page;
+       }
+
+       // one cursor per requested type in the by_op_type index, merged by sequence number, so skipped operations
+       // are never looked up
+       const auto& by_type_idx = hist_idx.get<by_op_type>();
+       vector<decltype(by_type_idx.begin())> cursors;
+       cursors.reserve( operation_types.size() );
+       for( uint16_t type : operation_types )
+          cursors.push_back( by_type_idx.upper_bound( boost::make_tuple( account, type, start ) ) );
+       auto previous = [&]( size_t i ) -> const account_transaction_history_object* {
+          if( cursors[i] == by_type_idx.begin() )
+             return nullptr;
+          const auto& entry = *std::prev( cursors[i] );
+          if( entry.account != account || entry.op_type != *operation_types.nth( i ) )
+             return nullptr;
+          return &entry;
+       };
+       while( true )
+       {
+          const account_transaction_history_object* newest = nullptr;
+          size_t newest_cursor = 0;
+          for( size_t i = 0; i < cursors.size(); ++i )
+          {
+             const auto* entry = previous( i );
+             if( entry && ( !newest || entry->sequence > newest->sequence ) )
+             {
+                newest = entry;
+                newest_cursor = i;
+             }
+          }
+          if( !newest )
+             break;
+          if( page.operations.size() == limit )
+          {
+             page.next = newest->sequence;
+             break;
+          }
+          page.operations.push_back( newest->operation_id(db) );
+          --cursors[newest_cursor];
+       }
+       return page;
+    }
+
     flat_set<uint32_t> history_api::get_market_history_buckets()const
     {
        auto hist = _app.get_plugin<market_history_plugin>( "market_history" );
@@ -502,32 +759,28 @@ namespace graphene { namespace app {
     asset_api::asset_api(graphene::chain::database& db) : _db(db) { }
     asset_api::~asset_api() { }
 
+    const asset_holder_index& asset_api::holder_index() const {
+      const auto& idx = dynamic_cast<const primary_index<account_balance_index>&>( _db.get_index_type<account_balance_index>() );
+      return idx.get_secondary_index<asset_holder_index>();
+    }
+
     vector<account_asset_balance> asset_api::get_asset_holders( asset_id_type asset_id, uint32_t start, uint32_t limit ) const {
       FC_ASSERT(limit <= 100);
 
-      const auto& bal_idx = _db.get_index_type< account_balance_index >().indices().get< by_asset_balance >();
-      auto range = bal_idx.equal_range( boost::make_tuple( asset_id ) );
+      const auto& holders = holder_index().holders( asset_id );
 
       vector<account_asset_balance> result;
+      if( start >= holders.size() )
+         return result;
 
-      uint32_t index = 0;
-      for( const account_balance_object& bal : boost::make_iterator_range( range.first, range.second ) )
+      for( auto itr = holders.nth( start ); itr != holders.end() && result.size() < limit; ++itr )
       {
-        if( result.size() >= limit )
-            break;
-
-        if( bal.balance.value == 0 )
-            continue;
-
-        if( index++ < start )
-            continue;
-
-        const auto account = _db.find(bal.owner);
+        const auto& account = itr->owner(_db);
 
         account_asset_balance aab;
-        aab.name       = account->name;
-        aab.account_id = account->id;
-        aab.amount     = bal.balance.value;
+        aab.name       = account.name;
+        aab.account_id = account.id;
+        aab.amount     = itr->balance.value;
 
         result.push_back(aab);
       }
@@ -536,35 +789,19 @@ namespace graphene { namespace app {
     }
     // get number of asset holders.
     int asset_api::get_asset_holders_count( asset_id_type asset_id ) const {
-
-      const auto& bal_idx = _db.get_index_type< account_balance_index >().indices().get< by_asset_balance >();
-      auto range = bal_idx.equal_range( boost::make_tuple( asset_id ) );
-
-      int count = boost::distance(range) - 1;
-
-      return count;
+      return holder_index().holders( asset_id ).size();
     }
     // function to get vector of system assets with holders count.
     vector<asset_holders> asset_api::get_all_asset_holders() const {
 
       vector<asset_holders> result;
 
-      vector<asset_id_type> total_assets;
+      const auto& index = holder_index();
       for( const asset_object& asset_obj : _db.get_index_type<asset_index>().indices() )
       {
-        const auto& dasset_obj = asset_obj.dynamic_asset_data_id(_db);
-
-        asset_id_type asset_id;
-        asset_id = dasset_obj.id;
-
-        const auto& bal_idx = _db.get_index_type< account_balance_index >().indices().get< by_asset_balance >();
-        auto range = bal_idx.equal_range( boost::make_tuple( asset_id ) );
-
-        int count = boost::distance(range) - 1;
-
         asset_holders ah;
-        ah.asset_id       = asset_id;
-        ah.count     = count;
+        ah.asset_id  = asset_obj.id;
+        ah.count     = index.holders( asset_obj.id ).size();
 
         result.push_back(ah);
       }
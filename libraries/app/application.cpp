@@ -23,6 +23,7 @@
  */
 #include <graphene/app/api.hpp>
 #include <graphene/app/api_access.hpp>
+#include <graphene/app/api_thread_pool.hpp>
 #include <graphene/app/application.hpp>
 #include <graphene/app/plugin.hpp>
 
@@ -121,6 +122,13 @@ namespace detail {
          _p2p_network->load_configuration(data_dir / "p2p");
          _p2p_network->set_node_delegate(this);
 
+         if( _options->count("p2p-io-threads") && _options->at("p2p-io-threads").as<uint32_t>() > 0 )
+         {
+            uint32_t num_threads = _options->at("p2p-io-threads").as<uint32_t>();
+            ilog( "Doing p2p socket I/O on ${n} threads", ("n", num_threads) );
+            _p2p_network->set_io_thread_count( num_threads );
+         }
+
          if( _options->count("seed-node") )
          {
             auto seeds = _options->at("seed-node").as<vector<string>>();
@@ -392,6 +400,12 @@ namespace detail {
          if( _options->count("replay-blockchain") )
             _chain_db->wipe( _data_dir / "blockchain", false );
 
+         if( _options->count("profile-chain") )
+         {
+            ilog( "Collecting per operation and per block timings, see profiler_api" );
+            _chain_db->enable_profiling( true );
+         }
+
          try
          {
             _chain_db->open( _data_dir / "blockchain", initial_state, GRAPHENE_CURRENT_DB_VERSION );
@@ -408,6 +422,17 @@ namespace detail {
             _force_validate = true;
          }
 
+         if( _options->count("recent-transactions-cache-mb") )
+            _chain_db->recent_transactions().set_max_bytes(
+                  uint64_t( _options->at("recent-transactions-cache-mb").as<uint32_t>() ) * 1024 * 1024 );
+
+         if( _options->count("api-threads") && _options->at("api-threads").as<uint32_t>() > 0 )
+         {
+            uint32_t num_threads = _options->at("api-threads").as<uint32_t>();
+            ilog( "Serving read-only API calls from ${n} threads", ("n", num_threads) );
+            _api_threads = std::make_shared<api_thread_pool>( *_chain_db, num_threads );
+         }
+
          if( _options->count("api-access") ) {
 
             if(fc::exists(_options->at("api-access").as<boost::filesystem::path>()))
@@ -488,6 +513,8 @@ namespace detail {
       virtual bool handle_block(const graphene::net::block_message& blk_msg, bool sync_mode,
                                 std::vector<fc::uint160_t>& contained_transaction_message_ids) override
       { try {
+         // the block is final once received, hash it and its transactions once for pushing, relaying and plugins
+         blk_msg.block.cache_digests( _chain_db->get_chain_id() );
 
          auto latency = fc::time_point::now() - blk_msg.block.timestamp;
          if (!sync_mode || blk_msg.block.block_num() % 10000 == 0)
@@ -555,6 +582,7 @@ namespace detail {
             trx_count = 0;
          }
 
+         transaction_message.trx.cache_digests( _chain_db->get_chain_id() );
          _chain_db->push_transaction( transaction_message.trx );
       } FC_CAPTURE_AND_RETHROW( (transaction_message) ) }
 
@@ -643,7 +671,7 @@ namespace detail {
             // ilog("Serving up block #${num}", ("num", opt_block->block_num()));
             return block_message(std::move(*opt_block));
          }
-         return trx_message( _chain_db->get_recent_transaction( id.item_hash ) );
+         return trx_message( *_chain_db->get_recent_transaction( id.item_hash ) );
       } FC_CAPTURE_AND_RETHROW( (id) ) }
 
       virtual chain_id_type get_chain_id()const override
@@ -891,6 +919,7 @@ namespace detail {
       api_access _apiaccess;
 
       std::shared_ptr<graphene::chain::database>            _chain_db;
+      std::shared_ptr<api_thread_pool>                      _api_threads;
       std::shared_ptr<graphene::net::node>                  _p2p_network;
       std::shared_ptr<fc::http::websocket_server>      _websocket_server;
       std::shared_ptr<fc::http::websocket_tls_server>  _websocket_tls_server;
@@ -914,6 +943,7 @@ application::~application()
       my->_p2p_network->close();
       my->_p2p_network.reset();
    }
+   my->_api_threads.reset();
    if( my->_chain_db )
    {
       my->_chain_db->close();
@@ -925,6 +955,8 @@ void application::set_program_options(boost::program_options::options_descriptio
 {
    configuration_file_options.add_options()
          ("p2p-endpoint", bpo::value<string>(), "Endpoint for P2P node to listen on")
+         ("p2p-io-threads", bpo::value<uint32_t>()->default_value(0),
+          "Number of threads doing the socket I/O, encryption and framing of P2P connections, 0 to do it on the P2P thread")
          ("seed-node,s", bpo::value<vector<string>>()->composing(), "P2P nodes to connect to on startup (may specify multiple times)")
          ("seed-nodes", bpo::value<string>()->composing(), "JSON array of P2P nodes to connect to on startup")
          ("checkpoint,c", bpo::value<vector<string>>()->composing(), "Pairs of [BLOCK_NUM,BLOCK_ID] that should be enforced as checkpoints.")
@@ -936,6 +968,10 @@ void application::set_program_options(boost::program_options::options_descriptio
          ("dbg-init-key", bpo::value<string>(), "Block signing key to use for init witnesses, overrides genesis file")
          ("api-access", bpo::value<boost::filesystem::path>(), "JSON file specifying API permissions")
          ("plugins", bpo::value<string>(), "Space-separated list of plugins to activate")
+         ("api-threads", bpo::value<uint32_t>()->default_value(0),
+          "Number of threads serving read-only API calls while blocks are applied, 0 to serve them from the main thread")
+         ("recent-transactions-cache-mb", bpo::value<uint32_t>()->default_value(64),
+          "Size limit in MiB of the transaction bodies kept for get_recent_transaction_by_id and peers, 0 to keep none")
          ;
    command_line_options.add(configuration_file_options);
    command_line_options.add_options()
@@ -946,6 +982,7 @@ void application::set_program_options(boost::program_options::options_descriptio
          ("replay-blockchain", "Rebuild object graph by replaying all blocks")
          ("resync-blockchain", "Delete all blocks and re-sync with network from scratch")
          ("force-validate", "Force validation of all transactions")
+         ("profile-chain", "Collect per operation and per block phase timings from startup, including the replay")
          ("genesis-timestamp", bpo::value<uint32_t>(), "Replace timestamp from genesis.json with current time plus this many seconds (experts only!)")
          ("version,v", "Display version information")
          ;
@@ -1046,6 +1083,11 @@ std::shared_ptr<chain::database> application::chain_database() const
    return my->_chain_db;
 }
 
+std::shared_ptr<api_thread_pool> application::api_threads() const
+{
+   return my->_api_threads;
+}
+
 void application::set_block_production(bool producing_blocks)
 {
    my->_is_block_producer = producing_blocks;
@@ -39,6 +39,7 @@
 
 #include <cfenv>
 #include <iostream>
+#include <mutex>
 
 #define GET_REQUIRED_FEES_MAX_RECURSION 4
 
@@ -85,6 +86,7 @@ class database_api_impl : public std::enable_shared_from_this<database_api_impl>
       // Accounts
       vector<optional<account_object>> get_accounts(const vector<account_id_type>& account_ids)const;
       std::map<string,full_account> get_full_accounts( const vector<string>& names_or_ids, bool subscribe );
+      full_accounts_page get_full_accounts_fields( const vector<string>& names_or_ids, uint32_t fields, uint32_t max_bytes )const;
       optional<account_object> get_account_by_name( string name )const;
       vector<account_id_type> get_account_references( account_id_type account_id )const;
       vector<optional<account_object>> lookup_account_names(const vector<string>& account_names)const;
@@ -112,6 +114,8 @@ class database_api_impl : public std::enable_shared_from_this<database_api_impl>
       vector<optional<bid_request_object>> get_bid_requests(const vector<bid_request_id_type>& bid_request_ids)const;
       vector<bid_request_object> list_bid_requests(const string& lower_bound_name, optional<vector<asset_id_type>> assets, uint32_t limit)const;
       vector<bid_request_object> list_bid_requests_by_provider (account_id_type provider_acc)const;
+      vector<bid_request_object> list_bid_requests_by_provider_paged(account_id_type provider_acc, bid_request_id_type start, uint32_t limit)const;
+      vector<bid_request_object> list_bid_requests_by_asset(asset_id_type asset_id, bid_request_id_type start, uint32_t limit)const;
       vector<bid_request_object> list_bid_requests_by_requester (account_id_type requester_acc)const;
       vector<optional<bid_request_object>> lookup_bid_request_names(const vector<string>& names_or_ids)const;
 
@@ -174,6 +178,7 @@ class database_api_impl : public std::enable_shared_from_this<database_api_impl>
          if( !_subscribe_callback )
             return;
 
+         std::lock_guard<std::mutex> guard( _subscription_mutex );
          if( !is_subscribed_to_item(i) )
          {
             idump((i));
@@ -227,6 +232,8 @@ class database_api_impl : public std::enable_shared_from_this<database_api_impl>
       bool _notify_remove_create = false;
       mutable fc::bloom_filter _subscribe_filter;
       std::set<account_id_type> _subscribed_accounts;
+      /// Guards the two above against concurrent queries served from the api_thread_pool
+      mutable std::mutex _subscription_mutex;
       std::function<void(const fc::variant&)> _subscribe_callback;
       std::function<void(const fc::variant&)> _pending_trx_callback;
       std::function<void(const fc::variant&)> _block_applied_callback;
@@ -419,7 +426,7 @@ processed_transaction database_api::get_transaction( uint32_t block_num, uint32_
 optional<signed_transaction> database_api::get_recent_transaction_by_id( const transaction_id_type& id )const
 {
    try {
-      return my->_db.get_recent_transaction( id );
+      return *my->_db.get_recent_transaction( id );
    } catch ( ... ) {
       return optional<signed_transaction>();
    }
@@ -621,7 +628,6 @@ std::map<string,full_account> database_api::get_full_accounts( const vector<stri
 
 std::map<std::string, full_account> database_api_impl::get_full_accounts( const vector<std::string>& names_or_ids, bool subscribe)
 {
-   idump((names_or_ids));
    std::map<std::string, full_account> results;
 
    for (const std::string& account_name_or_id : names_or_ids)
@@ -641,10 +647,16 @@ std::map<std::string, full_account> database_api_impl::get_full_accounts( const
 
       if( subscribe )
       {
-         if(_subscribed_accounts.size() < 100) {
-            _subscribed_accounts.insert( account->get_id() );
-            subscribe_to_item( account->id );
+         bool added = false;
+         {
+            std::lock_guard<std::mutex> guard( _subscription_mutex );
+            if(_subscribed_accounts.size() < 100) {
+               _subscribed_accounts.insert( account->get_id() );
+               added = true;
+            }
          }
+         if( added )
+            subscribe_to_item( account->id );
       }
 
       // fc::mutable_variant_object full_account;
@@ -709,6 +721,138 @@ std::map<std::string, full_account> database_api_impl::get_full_accounts( const
    return results;
 }
 
+full_accounts_page database_api::get_full_accounts_fields( const vector<string>& names_or_ids, uint32_t fields, uint32_t max_bytes )const
+{
+   return my->get_full_accounts_fields( names_or_ids, fields, max_bytes );
+}
+
+/** converts the objects of a range to variants, adding their packed size to bytes */
+template<typename Range>
+static fc::variants objects_to_variants( const Range& range, uint64_t& bytes )
+{
+   fc::variants result;
+   for( const auto& obj : range )
+   {
+      bytes += fc::raw::pack_size( obj );
+      result.emplace_back( obj );
+   }
+   return result;
+}
+
+full_accounts_page database_api_impl::get_full_accounts_fields( const vector<string>& names_or_ids, uint32_t fields, uint32_t max_bytes )const
+{
+   FC_ASSERT( names_or_ids.size() <= 1000, "Only 1000 accounts can be queried at a time" );
+
+   const auto& accounts_by_name = _db.get_index_type<account_index>().indices().get<by_name>();
+   const auto& balances_by_account = _db.get_index_type<account_balance_index>().indices().get<by_account_asset>();
+   const auto& vesting_by_account = _db.get_index_type<vesting_balance_index>().indices().get<by_account>();
+   const auto& orders_by_account = _db.get_index_type<limit_order_index>().indices().get<by_account>();
+   const auto& assets_by_issuer = _db.get_index_type<asset_index>().indices().get<by_issuer>();
+   const auto& withdraws_by_from = _db.get_index_type<withdraw_permission_index>().indices().get<by_from>();
+   const auto& proposals_by_account = dynamic_cast<const primary_index<proposal_index>&>( _db.get_index_type<proposal_index>() )
+                                         .get_secondary_index<graphene::chain::required_approval_index>()._account_to_proposals;
+   // accounts polled together mostly vote for the same witnesses and committee members
+   flat_map<vote_id_type, variant> looked_up_votes;
+
+   full_accounts_page page;
+   uint64_t bytes = 0;
+   for( size_t i = 0; i < names_or_ids.size(); ++i )
+   {
+      const string& account_name_or_id = names_or_ids[i];
+      const account_object* account = nullptr;
+      if( !account_name_or_id.empty() && std::isdigit(account_name_or_id[0]) )
+         account = _db.find(fc::variant(account_name_or_id).as<account_id_type>());
+      else
+      {
+         auto itr = accounts_by_name.find(account_name_or_id);
+         if( itr != accounts_by_name.end() )
+            account = &*itr;
+      }
+      if( account == nullptr )
+         continue;
+
+      uint64_t account_bytes = 0;
+      fc::mutable_variant_object acnt;
+      if( fields & full_account_account )
+      {
+         account_bytes += fc::raw::pack_size( *account );
+         acnt( "account", *account );
+      }
+      if( fields & full_account_statistics )
+      {
+         const auto& stats = account->statistics(_db);
+         account_bytes += fc::raw::pack_size( stats );
+         acnt( "statistics", stats );
+      }
+      if( fields & full_account_registrar_name )
+         acnt( "registrar_name", account->registrar(_db).name );
+      if( fields & full_account_votes )
+      {
+         vector<vote_id_type> missing;
+         for( const auto& vote : account->options.votes )
+            if( looked_up_votes.find( vote ) == looked_up_votes.end() )
+               missing.push_back( vote );
+         if( !missing.empty() )
+         {
+            auto found = lookup_vote_ids( missing );
+            for( size_t v = 0; v < missing.size(); ++v )
+               looked_up_votes[missing[v]] = std::move( found[v] );
+         }
+         fc::variants votes;
+         votes.reserve( account->options.votes.size() );
+         for( const auto& vote : account->options.votes )
+            votes.push_back( looked_up_votes[vote] );
+         account_bytes += 64 * votes.size();
+         acnt( "votes", std::move( votes ) );
+      }
+      if( fields & full_account_balances )
+         acnt( "balances", objects_to_variants( boost::make_iterator_range(
+                              balances_by_account.equal_range( boost::make_tuple( account->id ) ) ), account_bytes ) );
+      if( fields & full_account_vesting_balances )
+         acnt( "vesting_balances", objects_to_variants( boost::make_iterator_range(
+                                      vesting_by_account.equal_range( account->id ) ), account_bytes ) );
+      if( fields & full_account_limit_orders )
+         acnt( "limit_orders", objects_to_variants( boost::make_iterator_range(
+                                  orders_by_account.equal_range( account->id ) ), account_bytes ) );
+      if( fields & full_account_proposals )
+      {
+         fc::variants proposals;
+         auto itr = proposals_by_account.find( account->id );
+         if( itr != proposals_by_account.end() )
+         {
+            proposals.reserve( itr->second.size() );
+            for( auto proposal_id : itr->second )
+            {
+               const auto& proposal = proposal_id(_db);
+               account_bytes += fc::raw::pack_size( proposal );
+               proposals.emplace_back( proposal );
+            }
+         }
+         acnt( "proposals", std::move( proposals ) );
+      }
+      if( fields & full_account_assets )
+      {
+         fc::variants assets;
+         for( const asset_object& asset : boost::make_iterator_range( assets_by_issuer.equal_range( account->id ) ) )
+            assets.emplace_back( asset.id );
+         account_bytes += 8 * assets.size();
+         acnt( "assets", std::move( assets ) );
+      }
+      if( fields & full_account_withdraws )
+         acnt( "withdraws", objects_to_variants( boost::make_iterator_range(
+                               withdraws_by_from.equal_range( account->id ) ), account_bytes ) );
+
+      if( !page.accounts.empty() && bytes + account_bytes > max_bytes )
+      {
+         page.remaining.assign( names_or_ids.begin() + i, names_or_ids.end() );
+         break;
+      }
+      bytes += account_bytes;
+      page.accounts[account_name_or_id] = std::move( acnt );
+   }
+   return page;
+}
+
 optional<account_object> database_api::get_account_by_name( string name )const
 {
    return my->get_account_by_name( name );
@@ -1091,31 +1235,55 @@ vector<bid_request_object> database_api::list_bid_requests(const string& lower_b
 vector<bid_request_object> database_api_impl::list_bid_requests(const string& lower_bound_name, optional<vector<asset_id_type>> assets, uint32_t limit)const
 {
     FC_ASSERT(limit <= 1000);
-    const auto &bid_request_by_name = _db.get_index_type<bid_request_index>().indices().get<by_name>();
+    const auto& idx = _db.get_index_type<bid_request_index>();
+    const auto &bid_request_by_name = idx.indices().get<by_name>();
     vector<bid_request_object> result;
     result.reserve(limit);
 
-    auto itr = bid_request_by_name.lower_bound(lower_bound_name);
-
-    if (lower_bound_name == "")
-        itr = bid_request_by_name.begin();
-
     if (assets.valid())
     {
-        for (; limit && itr != bid_request_by_name.end(); itr++)
+        const auto& refs = dynamic_cast<const primary_index<bid_request_index>&>(idx).get_secondary_index<bid_request_member_index>();
+
+        // merge the per asset sets, which are ordered by name, starting at lower_bound_name
+        typedef set< pair<string, bid_request_id_type> >::const_iterator name_iterator;
+        vector< pair<name_iterator, name_iterator> > cursors;
+        for( auto aid : *assets )
         {
-            for( auto aid : *assets )
+            auto itr = refs.requests_by_asset_name.find( aid );
+            if( itr == refs.requests_by_asset_name.end() )
+                continue;
+            auto begin = itr->second.lower_bound( std::make_pair( lower_bound_name, bid_request_id_type() ) );
+            if( begin != itr->second.end() )
+                cursors.emplace_back( begin, itr->second.end() );
+        }
+
+        while( limit && !cursors.empty() )
+        {
+            auto next = cursors.begin();
+            for( auto itr = cursors.begin() + 1; itr != cursors.end(); ++itr )
+                if( *itr->first < *next->first )
+                    next = itr;
+            const auto entry = *next->first;
+            result.emplace_back( entry.second(_db) );
+            --limit;
+
+            // a request listing several of the assets shows up in several sets
+            for( auto itr = cursors.begin(); itr != cursors.end(); )
             {
-                if(  itr->assets.find( aid) != itr->assets.end() )
-                {
-                    result.emplace_back(*itr);
-                    limit--;
-                }
+                if( *itr->first == entry && ++itr->first == itr->second )
+                    itr = cursors.erase( itr );
+                else
+                    ++itr;
             }
         }
     }
     else
     {
+        auto itr = bid_request_by_name.lower_bound(lower_bound_name);
+
+        if (lower_bound_name == "")
+            itr = bid_request_by_name.begin();
+
         for (; limit && itr != bid_request_by_name.end(); itr++)
         {
             result.emplace_back(*itr);
@@ -1133,21 +1301,67 @@ vector<bid_request_object> database_api::list_bid_requests_by_provider (account_
 
 vector<bid_request_object> database_api_impl::list_bid_requests_by_provider (account_id_type provider_acc)const
 {
-    const auto &bid_request_by_id = _db.get_index_type<bid_request_index>().indices().get<by_id>();
+    const auto& idx = _db.get_index_type<bid_request_index>();
+    const auto& refs = dynamic_cast<const primary_index<bid_request_index>&>(idx).get_secondary_index<bid_request_member_index>();
     vector<bid_request_object> result;
 
-    auto itr = bid_request_by_id.begin();;
-    for (; itr != bid_request_by_id.end(); itr++)
+    auto itr = refs.requests_by_provider.find( provider_acc );
+    if( itr != refs.requests_by_provider.end() )
     {
-        if(itr->providers.find(provider_acc) != itr->providers.end() )
-        {
-            result.emplace_back(*itr);
-        }
+        result.reserve( itr->second.size() );
+        for( auto id : itr->second )
+            result.emplace_back( id(_db) );
     }
 
     return result;
 }
 
+vector<bid_request_object> database_api::list_bid_requests_by_provider_paged(account_id_type provider_acc, bid_request_id_type start, uint32_t limit)const
+{
+   return my->list_bid_requests_by_provider_paged( provider_acc, start, limit );
+}
+
+vector<bid_request_object> database_api_impl::list_bid_requests_by_provider_paged(account_id_type provider_acc, bid_request_id_type start, uint32_t limit)const
+{
+    FC_ASSERT( limit <= 1000 );
+    const auto& idx = _db.get_index_type<bid_request_index>();
+    const auto& refs = dynamic_cast<const primary_index<bid_request_index>&>(idx).get_secondary_index<bid_request_member_index>();
+    vector<bid_request_object> result;
+
+    auto requests = refs.requests_by_provider.find( provider_acc );
+    if( requests == refs.requests_by_provider.end() )
+        return result;
+
+    result.reserve( std::min<size_t>( limit, requests->second.size() ) );
+    for( auto itr = requests->second.lower_bound( start ); limit && itr != requests->second.end(); ++itr, --limit )
+        result.emplace_back( (*itr)(_db) );
+
+    return result;
+}
+
+vector<bid_request_object> database_api::list_bid_requests_by_asset(asset_id_type asset_id, bid_request_id_type start, uint32_t limit)const
+{
+   return my->list_bid_requests_by_asset( asset_id, start, limit );
+}
+
+vector<bid_request_object> database_api_impl::list_bid_requests_by_asset(asset_id_type asset_id, bid_request_id_type start, uint32_t limit)const
+{
+    FC_ASSERT( limit <= 1000 );
+    const auto& idx = _db.get_index_type<bid_request_index>();
+    const auto& refs = dynamic_cast<const primary_index<bid_request_index>&>(idx).get_secondary_index<bid_request_member_index>();
+    vector<bid_request_object> result;
+
+    auto requests = refs.requests_by_asset.find( asset_id );
+    if( requests == refs.requests_by_asset.end() )
+        return result;
+
+    result.reserve( std::min<size_t>( limit, requests->second.size() ) );
+    for( auto itr = requests->second.lower_bound( start ); limit && itr != requests->second.end(); ++itr, --limit )
+        result.emplace_back( (*itr)(_db) );
+
+    return result;
+}
+
 vector<bid_request_object> database_api::list_bid_requests_by_requester (account_id_type requester_acc)const
 {
    return my->list_bid_requests_by_requester( requester_acc);
@@ -38,11 +38,13 @@
 #include <fc/optional.hpp>
 #include <fc/crypto/elliptic.hpp>
 #include <fc/network/ip.hpp>
+#include <fc/thread/thread.hpp>
 
 #include <boost/container/flat_set.hpp>
 
 #include <functional>
 #include <map>
+#include <memory>
 #include <string>
 #include <vector>
 
@@ -82,6 +84,12 @@ namespace graphene { namespace app {
       asset_id_type   asset_id;
       int             count;
    };
+
+   struct account_history_page
+   {
+      vector<operation_history_object> operations;
+      uint32_t                         next = 0; ///< sequence number to pass as start for the next page, 0 at the end
+   };
    
    /**
     * @brief The history_api class implements the RPC API for account history
@@ -138,6 +146,23 @@ namespace graphene { namespace app {
                                                                         unsigned limit = 100,
                                                                         uint32_t start = 0) const;
 
+         /**
+          * @brief Get a page of operations relevant to the specified account, walking the account's sequence
+          * numbers in the history index instead of the linked list, so the cost of a page does not grow with
+          * its depth.
+          * @param account The account whose history should be queried
+          * @param start Sequence number of the most recent operation to retrieve, 0 starts with the most recent
+          * operation of the account. Pass the next member of the previous page to continue.
+          * @param limit Maximum number of operations to retrieve (must not exceed 100)
+          * @param operation_types When not empty, only operations of these types are returned
+          * ( 0 = transfer , 1 = limit order create, ...)
+          * @return The operations, ordered from most recent to oldest, and the cursor of the next page
+          */
+         account_history_page get_account_history_by_sequence( account_id_type account,
+                                                                uint32_t start = 0,
+                                                                unsigned limit = 100,
+                                                                flat_set<uint16_t> operation_types = flat_set<uint16_t>() ) const;
+
          vector<order_history_object> get_fill_order_history( asset_id_type a, asset_id_type b, uint32_t limit )const;
          vector<bucket_object> get_market_history( asset_id_type a, asset_id_type b, uint32_t bucket_seconds,
                                                    fc::time_point_sec start, fc::time_point_sec end )const;
@@ -146,19 +171,66 @@ namespace graphene { namespace app {
            application& _app;
    };
 
+   struct block_stream_options
+   {
+      /** "json" sends the blocks as objects, "hex" and "base64" send their fc::raw packed bytes */
+      string   encoding = "json";
+      /** add the operations applied by each block, as recorded by the account history plugin */
+      bool     include_operations = false;
+      uint32_t max_chunk_blocks = 100;
+      /** the packed size of the blocks of a chunk, a chunk holds at least one block */
+      uint32_t max_chunk_bytes = 1024*1024;
+   };
+
+   struct block_stream_chunk
+   {
+      uint32_t                                  first_block_num = 0;
+      /** signed_block objects, or strings of the encoded packed blocks */
+      vector<variant>                           blocks;
+      /** when requested, the operations of each of the blocks */
+      vector< vector<operation_history_object> > operations;
+      /** the block the next chunk starts with, 0 when this chunk ends the stream */
+      uint32_t                                  next_block_num = 0;
+      /** set when the stream ended because of an error */
+      optional<string>                          error;
+   };
+
    /**
     * @brief Block api
     */
    class block_api
    {
    public:
+      typedef std::function<bool(variant/*block_stream_chunk*/)> block_stream_callback;
+
       block_api(graphene::chain::database& db);
       ~block_api();
 
       vector<optional<signed_block>> get_blocks(uint32_t block_num_from, uint32_t block_num_to)const;
 
+      /**
+       * @brief Sends a range of blocks to a callback, in chunks bounded in blocks and bytes
+       * @param callback Called with each @ref block_stream_chunk. Its result is waited for before the next chunk
+       * is read, so a slow client slows the stream down instead of piling chunks up; false stops the stream.
+       * @param block_num_from The first block to send
+       * @param block_num_to The last block to send, the stream ends earlier at the head block
+       * @param options Encoding of the blocks, operations, and chunk sizes
+       *
+       * Returns as soon as the stream has started.  Irreversible blocks are read straight from the block store.
+       */
+      void stream_blocks( block_stream_callback callback, uint32_t block_num_from, uint32_t block_num_to,
+                          const block_stream_options& options );
+
    private:
+      void stream_block_range( fc::thread* origin, block_stream_callback callback, uint32_t block_num_from,
+                               uint32_t block_num_to, const block_stream_options& options );
+
       graphene::chain::database& _db;
+      /** reads the streamed blocks, so that waiting on the clients does not hold up the calling thread; it is
+       *  shared by all connections */
+      std::shared_ptr<fc::thread> _stream_thread;
+      /** the streams still running, waited for on destruction */
+      vector< fc::future<void> >  _streams;
    };
 
 
@@ -315,6 +387,28 @@ namespace graphene { namespace app {
          int get_asset_holders_count( asset_id_type asset_id )const;
          vector<asset_holders> get_all_asset_holders() const;
 
+      private:
+         const asset_holder_index& holder_index() const;
+
+         graphene::chain::database& _db;
+   };
+
+   /**
+    * @brief Per operation type and per block phase timings of the chain, see graphene::chain::chain_profiler
+    */
+   class profiler_api
+   {
+      public:
+         profiler_api(graphene::chain::database& db);
+         ~profiler_api();
+
+         /// @brief Everything measured since profiling was enabled or last reset
+         chain_profile get_chain_profile()const;
+         /// @brief Start or stop collecting timings; what was collected so far is kept
+         void enable_profiling( bool enable );
+         /// @brief Discard everything measured so far
+         void reset_profile();
+
       private:
          graphene::chain::database& _db;
    };
@@ -356,6 +450,8 @@ namespace graphene { namespace app {
          fc::api<asset_api> asset()const;
          /// @brief Retrieve the debug API (if available)
          fc::api<graphene::debug_witness::debug_api> debug()const;
+         /// @brief Retrieve the profiler API
+         fc::api<profiler_api> profiler()const;
 
          /// @brief Called to enable an API, not reflected.
          void enable_api( const string& api_name );
@@ -370,6 +466,7 @@ namespace graphene { namespace app {
          optional< fc::api<crypto_api> > _crypto_api;
          optional< fc::api<asset_api> > _asset_api;
          optional< fc::api<graphene::debug_witness::debug_api> > _debug_api;
+         optional< fc::api<profiler_api> > _profiler_api;
    };
 
 }}  // graphene::app
@@ -383,19 +480,24 @@ FC_REFLECT( graphene::app::verify_range_proof_rewind_result,
 //FC_REFLECT_TYPENAME( fc::ecc::compact_signature );
 //FC_REFLECT_TYPENAME( fc::ecc::commitment_type );
 
+FC_REFLECT( graphene::app::block_stream_options, (encoding)(include_operations)(max_chunk_blocks)(max_chunk_bytes) );
+FC_REFLECT( graphene::app::block_stream_chunk, (first_block_num)(blocks)(operations)(next_block_num)(error) );
 FC_REFLECT( graphene::app::account_asset_balance, (name)(account_id)(amount) );
 FC_REFLECT( graphene::app::asset_holders, (asset_id)(count) );
+FC_REFLECT( graphene::app::account_history_page, (operations)(next) );
 
 FC_API(graphene::app::history_api,
        (get_account_history)
        (get_account_history_operations)
        (get_relative_account_history)
+       (get_account_history_by_sequence)
        (get_fill_order_history)
        (get_market_history)
        (get_market_history_buckets)
      )
 FC_API(graphene::app::block_api,
        (get_blocks)
+       (stream_blocks)
      )
 FC_API(graphene::app::network_broadcast_api,
        (broadcast_transaction)
@@ -427,6 +529,11 @@ FC_API(graphene::app::asset_api,
 	   (get_asset_holders_count)
        (get_all_asset_holders)
      )
+FC_API(graphene::app::profiler_api,
+       (get_chain_profile)
+       (enable_profiling)
+       (reset_profile)
+     )
 FC_API(graphene::app::login_api,
        (login)
        (block)
@@ -437,4 +544,5 @@ FC_API(graphene::app::login_api,
        (crypto)
        (asset)
        (debug)
+       (profiler)
      )
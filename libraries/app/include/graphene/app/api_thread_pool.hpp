@@ -0,0 +1,103 @@
+/*
+ * Copyright (c) 2015 Cryptonomex, Inc., and contributors.
+ *
+ * The MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#pragma once
+
+#include <graphene/chain/database.hpp>
+
+#include <fc/api.hpp>
+#include <fc/thread/thread.hpp>
+
+#include <atomic>
+#include <memory>
+#include <set>
+#include <string>
+#include <vector>
+
+namespace graphene { namespace app {
+
+   /**
+    *  @brief Serves read-only API calls on a pool of threads, concurrently with block application
+    *
+    *  wrap() rewires the methods of an API so that a call, which arrives on the thread that applies blocks, runs on
+    *  one of the pool's threads under database::lock_for_reading() while the calling task yields.  A slow query thus
+    *  no longer holds up block handling, and only waits for (or delays) the block being applied.
+    *
+    *  Methods that change per-connection state read by the other methods, such as subscriptions, or that reach
+    *  database::write_lock, such as validate_transaction(), must be named in @p exclusive: they keep running on
+    *  the calling thread, with the state locked exclusively.
+    */
+   class api_thread_pool : public std::enable_shared_from_this<api_thread_pool>
+   {
+      public:
+         api_thread_pool( graphene::chain::database& db, uint32_t num_threads );
+         ~api_thread_pool();
+
+         template<typename Api>
+         void wrap( fc::api<Api>& api, const std::set<std::string>& exclusive = std::set<std::string>() )
+         {
+            api->visit( wrap_visitor{ shared_from_this(), exclusive } );
+         }
+
+         /** Runs f on a pool thread under the read lock and returns its result */
+         template<typename Functor>
+         auto run( Functor&& f ) -> decltype( f() )
+         {
+            graphene::chain::database& db = _db;
+            return _threads[ _next++ % _threads.size() ]->async( [&db,&f]() {
+               auto lock = db.lock_for_reading();
+               return f();
+            }, "api call" ).wait();
+         }
+
+         graphene::chain::database& db()const { return _db; }
+
+      private:
+         struct wrap_visitor
+         {
+            std::shared_ptr<api_thread_pool> pool;
+            const std::set<std::string>&     exclusive;
+
+            template<typename R, typename... Args>
+            void operator()( const char* name, std::function<R(Args...)>& method )const
+            {
+               std::function<R(Args...)> inner = method;
+               std::shared_ptr<api_thread_pool> p = pool;
+               if( exclusive.count( name ) )
+                  method = [p,inner]( Args... args ) -> R {
+                     graphene::chain::database::write_lock lock( p->db() );
+                     return inner( args... );
+                  };
+               else
+                  method = [p,inner]( Args... args ) -> R {
+                     return p->run( [&]() -> R { return inner( args... ); } );
+                  };
+            }
+         };
+
+         graphene::chain::database&                 _db;
+         std::vector< std::unique_ptr<fc::thread> > _threads;
+         std::atomic<uint32_t>                      _next;
+   };
+
+} } // graphene::app
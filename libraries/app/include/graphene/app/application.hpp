@@ -34,6 +34,7 @@ namespace graphene { namespace app {
    using std::string;
 
    class abstract_plugin;
+   class api_thread_pool;
 
    class application
    {
@@ -80,6 +81,8 @@ namespace graphene { namespace app {
 
          net::node_ptr                    p2p_node();
          std::shared_ptr<chain::database> chain_database()const;
+         /// The pool serving read-only API calls, null unless enabled with api-threads
+         std::shared_ptr<api_thread_pool> api_threads()const;
 
          void set_block_production(bool producing_blocks);
          fc::optional< api_access_info > get_api_access_info( const string& username )const;
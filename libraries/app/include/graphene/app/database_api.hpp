@@ -260,6 +260,22 @@ class database_api
        */
       std::map<string,full_account> get_full_accounts( const vector<string>& names_or_ids, bool subscribe );
 
+      /**
+       * @brief Fetch selected objects relevant to the specified accounts
+       * @param names_or_ids Each item must be the name or ID of an account to retrieve
+       * @param fields Bitwise or of @ref full_account_field values, selecting the members of @ref full_account to return
+       * @param max_bytes Approximate cap on the size of the response, measured as the packed size of the objects
+       * @return The selected members for each account, and the names or IDs left for a further call once the cap is
+       * reached.  At least one account is returned whatever its size.
+       *
+       * Unlike @ref get_full_accounts this does not subscribe to the accounts, and it is meant for clients polling
+       * many accounts at once: the indexes are looked up once for the whole batch and the objects are converted to
+       * variants straight from the database.  Unknown names and IDs are ignored.
+       */
+      full_accounts_page get_full_accounts_fields( const vector<string>& names_or_ids,
+                                                   uint32_t fields = full_account_all,
+                                                   uint32_t max_bytes = 1024*1024 )const;
+
       optional<account_object> get_account_by_name( string name )const;
 
       /**
@@ -386,6 +402,24 @@ class database_api
        */
       vector<bid_request_object> list_bid_requests_by_provider (account_id_type provider_acc)const;
 
+      /**
+       * @brief Get a page of the bid requests addressed to specified service provider
+       * @param provider_acc account ID of service provider
+       * @param start lowest bid request ID to return; pass the ID following the last one received to get the next page
+       * @param limit Maximum number of bid requests to fetch (must not exceed 1000)
+       * @return The bid requests found, ordered by ID
+       */
+      vector<bid_request_object> list_bid_requests_by_provider_paged(account_id_type provider_acc, bid_request_id_type start, uint32_t limit)const;
+
+      /**
+       * @brief Get a page of the bid requests addressed to specified asset
+       * @param asset_id ID of the asset
+       * @param start lowest bid request ID to return; pass the ID following the last one received to get the next page
+       * @param limit Maximum number of bid requests to fetch (must not exceed 1000)
+       * @return The bid requests found, ordered by ID
+       */
+      vector<bid_request_object> list_bid_requests_by_asset(asset_id_type asset_id, bid_request_id_type start, uint32_t limit)const;
+
       /**
        * @brief Get a list of bid requests created by specified user
        * @param requester_acc account ID of bid request creator
@@ -721,6 +755,7 @@ FC_API(graphene::app::database_api,
    // Accounts
    (get_accounts)
    (get_full_accounts)
+   (get_full_accounts_fields)
    (get_account_by_name)
    (get_account_references)
    (lookup_account_names)
@@ -748,6 +783,8 @@ FC_API(graphene::app::database_api,
    (get_bid_requests)
    (list_bid_requests)
    (list_bid_requests_by_provider)
+   (list_bid_requests_by_provider_paged)
+   (list_bid_requests_by_asset)
    (list_bid_requests_by_requester)
    (lookup_bid_request_names)
 
@@ -45,6 +45,30 @@ namespace graphene { namespace app {
       vector<withdraw_permission_object> withdraws;
    };
 
+   /** bits of the field mask of database_api::get_full_accounts_fields(), one per member of full_account */
+   enum full_account_field
+   {
+      full_account_account          = 1 << 0,
+      full_account_statistics       = 1 << 1,
+      full_account_registrar_name   = 1 << 2,
+      full_account_votes            = 1 << 3,
+      full_account_balances         = 1 << 4,
+      full_account_vesting_balances = 1 << 5,
+      full_account_limit_orders     = 1 << 6,
+      full_account_proposals        = 1 << 7,
+      full_account_assets           = 1 << 8,
+      full_account_withdraws        = 1 << 9,
+      full_account_all              = ( 1 << 10 ) - 1
+   };
+
+   struct full_accounts_page
+   {
+      /** the selected members of full_account for each account found, by the name or id it was requested with */
+      map<string, fc::variant_object> accounts;
+      /** the requested names and ids that were left out because the response reached its size cap */
+      vector<string>                  remaining;
+   };
+
 } }
 
 FC_REFLECT( graphene::app::full_account,
@@ -59,3 +83,19 @@ FC_REFLECT( graphene::app::full_account,
             (assets)
             (withdraws)
           )
+
+FC_REFLECT_ENUM( graphene::app::full_account_field,
+                 (full_account_account)
+                 (full_account_statistics)
+                 (full_account_registrar_name)
+                 (full_account_votes)
+                 (full_account_balances)
+                 (full_account_vesting_balances)
+                 (full_account_limit_orders)
+                 (full_account_proposals)
+                 (full_account_assets)
+                 (full_account_withdraws)
+                 (full_account_all)
+               )
+
+FC_REFLECT( graphene::app::full_accounts_page, (accounts)(remaining) )
@@ -27,6 +27,8 @@
 #include <graphene/chain/hardfork.hpp>
 #include <fc/uint128.hpp>
 
+#include <boost/thread/locks.hpp>
+
 namespace graphene { namespace chain {
 
 void account_balance_object::adjust_balance(const asset& delta)
@@ -75,13 +77,13 @@ void account_statistics_object::process_fees(const account_object& a, database&
 void account_statistics_object::pay_fee( account_id_type from, asset fee, asset ufee, database& d )
 {
   if( fee.amount > 0 ){
-    d.adjust_balance( GRAPHENE_UMT_FEE_POOL_ACCOUNT, fee);
+    d.credit_fee_pool( fee );
     if( fee.asset_id == asset_id_type()){
       total_fees += fee.amount;
     }
   }
   if( ufee.amount > 0){
-    d.adjust_balance( GRAPHENE_UMT_FEE_POOL_ACCOUNT, ufee);
+    d.credit_fee_pool( ufee );
     if( ufee.asset_id == GRAPHENE_SDR_ASSET_ID){
       total_ufees += ufee.amount;
     }
@@ -255,4 +257,92 @@ void account_referrer_index::object_modified( const object& after  )
 {
 }
 
+void asset_holder_index::object_inserted( const object& obj )
+{
+   assert( dynamic_cast<const account_balance_object*>(&obj) ); // for debug only
+   const account_balance_object& b = static_cast<const account_balance_object&>(obj);
+   balance_changed( b, b.balance );
+}
+
+void asset_holder_index::object_removed( const object& obj )
+{
+   assert( dynamic_cast<const account_balance_object*>(&obj) ); // for debug only
+   balance_changed( static_cast<const account_balance_object&>(obj), 0 );
+}
+
+void asset_holder_index::object_modified( const object& after )
+{
+   object_inserted( after );
+}
+
+void asset_holder_index::balance_changed( const account_balance_object& b, share_type balance )
+{
+   boost::lock_guard<boost::mutex> guard( _mutex );
+   if( _holders.find( b.asset_type ) != _holders.end() )
+      _changed[b.asset_type][b.owner] = balance;
+}
+
+const asset_holder_index::holder_set& asset_holder_index::holders( asset_id_type asset )const
+{
+   boost::lock_guard<boost::mutex> guard( _mutex );
+   auto itr = _holders.find( asset );
+   if( itr == _holders.end() )
+   {
+      assert( balances != nullptr );
+      itr = _holders.emplace( asset, holder_set() ).first;
+      const auto& by_asset = balances->indices().get<by_asset_account>();
+      for( auto b = by_asset.lower_bound( boost::make_tuple( asset ) );
+           b != by_asset.end() && b->asset_type == asset; ++b )
+         if( b->balance != 0 )
+            itr->second.insert( holder{ b->balance, b->owner } );
+      return itr->second;
+   }
+
+   auto changed = _changed.find( asset );
+   if( changed == _changed.end() )
+      return itr->second;
+   auto& by_owner_idx = itr->second.get<by_owner>();
+   for( const auto& change : changed->second )
+   {
+      auto h = by_owner_idx.find( change.first );
+      if( h == by_owner_idx.end() )
+      {
+         if( change.second != 0 )
+            itr->second.insert( holder{ change.second, change.first } );
+      }
+      else if( change.second == 0 )
+         by_owner_idx.erase( h );
+      else
+         by_owner_idx.modify( h, [&change]( holder& o ) { o.balance = change.second; } );
+   }
+   _changed.erase( changed );
+   return itr->second;
+}
+
+void temp_account_balance_index::object_inserted( const object& obj )
+{
+   assert( dynamic_cast<const account_balance_object*>(&obj) ); // for debug only
+   const account_balance_object& b = static_cast<const account_balance_object&>(obj);
+   if( b.owner == GRAPHENE_TEMP_ACCOUNT && b.balance != 0 )
+      ++nonzero_balances;
+}
+
+void temp_account_balance_index::object_removed( const object& obj )
+{
+   assert( dynamic_cast<const account_balance_object*>(&obj) ); // for debug only
+   const account_balance_object& b = static_cast<const account_balance_object&>(obj);
+   if( b.owner == GRAPHENE_TEMP_ACCOUNT && b.balance != 0 )
+      --nonzero_balances;
+}
+
+void temp_account_balance_index::about_to_modify( const object& before )
+{
+   object_removed( before );
+}
+
+void temp_account_balance_index::object_modified( const object& after )
+{
+   object_inserted( after );
+}
+
 } } // graphene::chain
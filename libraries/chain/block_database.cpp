@@ -23,9 +23,12 @@
  */
 #include <graphene/chain/block_database.hpp>
 #include <graphene/chain/protocol/fee_schedule.hpp>
+#include <fc/interprocess/file_mapping.hpp>
 #include <fc/io/raw.hpp>
 #include <fc/smart_ref_impl.hpp>
 
+#include <limits>
+
 namespace graphene { namespace chain {
 
 struct index_entry
@@ -39,42 +42,277 @@ FC_REFLECT( graphene::chain::index_entry, (block_pos)(block_size)(block_id) );
 
 namespace graphene { namespace chain {
 
+namespace {
+   const uint32_t entries_per_segment_bits = 16;
+   const uint32_t entries_per_segment      = 1u << entries_per_segment_bits;
+   const uint32_t max_segments             = 1u << (32 - entries_per_segment_bits);
+   /** the blocks file is grown and mapped with room for further blocks, so that it is rarely remapped */
+   const uint64_t min_mapping_size         = 64*1024*1024;
+   /** number of index entries changed in memory before they are written to the index file */
+   const uint32_t index_write_interval     = 256;
+}
+
+struct block_database::mapped_blocks
+{
+   mapped_blocks( const fc::path& p, uint64_t cap )
+   : file( p.generic_string().c_str(), fc::read_write ),
+     region( file, fc::read_write, 0, cap ),
+     capacity( cap ) {}
+
+   char* data()const { return (char*)region.get_address(); }
+
+   fc::file_mapping  file;
+   fc::mapped_region region;
+   uint64_t          capacity;
+};
+
+block_database::block_database()
+: _segments( new std::atomic<index_entry*>[max_segments] ),
+  _index_size( 0 ),
+  _index_seq( 0 ),
+  _mapping( nullptr ),
+  _blocks_size( 0 )
+{
+   for( uint32_t i = 0; i < max_segments; ++i )
+      _segments[i] = nullptr;
+}
+
+block_database::~block_database()
+{
+   close();
+}
+
 void block_database::open( const fc::path& dbdir )
 { try {
    fc::create_directories(dbdir);
    _block_num_to_pos.exceptions(std::ios_base::failbit | std::ios_base::badbit);
-   _blocks.exceptions(std::ios_base::failbit | std::ios_base::badbit);
 
    _index_filename = dbdir / "index";
+   _blocks_filename = dbdir / "blocks";
    if( !fc::exists( _index_filename ) )
    {
      _block_num_to_pos.open( _index_filename.generic_string().c_str(), std::fstream::binary | std::fstream::in | std::fstream::out | std::fstream::trunc);
-     _blocks.open( (dbdir/"blocks").generic_string().c_str(), std::fstream::binary | std::fstream::in | std::fstream::out | std::fstream::trunc);
+     std::ofstream blocks( _blocks_filename.generic_string().c_str(), std::ofstream::binary | std::ofstream::out | std::ofstream::trunc );
+     FC_ASSERT( blocks, "Unable to create ${f}", ("f", _blocks_filename) );
    }
    else
    {
+     FC_ASSERT( fc::exists( _blocks_filename ), "Missing ${f}", ("f", _blocks_filename) );
      _block_num_to_pos.open( _index_filename.generic_string().c_str(), std::fstream::binary | std::fstream::in | std::fstream::out );
-     _blocks.open( (dbdir/"blocks").generic_string().c_str(), std::fstream::binary | std::fstream::in | std::fstream::out );
    }
+
+   // load the whole index, from now on the index file is only written
+   const uint32_t entries = fc::file_size( _index_filename ) / sizeof(index_entry);
+   _block_num_to_pos.seekg( 0 );
+   for( uint32_t first = 0; first < entries; first += entries_per_segment )
+   {
+      index_entry* segment = new index_entry[entries_per_segment]();
+      _segments[first >> entries_per_segment_bits] = segment;
+      _block_num_to_pos.read( (char*)segment, sizeof(index_entry) * std::min( entries - first, entries_per_segment ) );
+   }
+   _index_size = entries;
+   _dirty_begin = _dirty_end = 0;
+
+   // after an unclean shutdown the file still has the room it was grown by, the blocks end where the index says
+   uint64_t blocks_end = 0;
+   for( uint32_t n = 0; n < entries; ++n )
+   {
+      const index_entry& e = _segments[n >> entries_per_segment_bits].load()[n & (entries_per_segment - 1)];
+      if( e.block_size > 0 )
+         blocks_end = std::max( blocks_end, e.block_pos + e.block_size );
+   }
+   _blocks_size = std::min<uint64_t>( blocks_end, fc::file_size( _blocks_filename ) );
+   map_blocks( _blocks_size );
 } FC_CAPTURE_AND_RETHROW( (dbdir) ) }
 
 bool block_database::is_open()const
 {
-  return _blocks.is_open();
+  return _block_num_to_pos.is_open();
 }
 
 void block_database::close()
 {
-  _blocks.close();
+  const bool was_open = is_open();
+  if( was_open )
+     flush();
   _block_num_to_pos.close();
+
+  _mapping = nullptr;
+  _mappings.clear();
+  // give back the room the file was grown by
+  if( was_open && fc::file_size( _blocks_filename ) > _blocks_size.load() )
+     fc::resize_file( _blocks_filename, _blocks_size.load() );
+  _index_size = 0;
+  _blocks_size = 0;
+  for( uint32_t i = 0; i < max_segments; ++i )
+  {
+     delete[] _segments[i].load();
+     _segments[i] = nullptr;
+  }
 }
 
 void block_database::flush()
 {
-  _blocks.flush();
+  if( !_mappings.empty() )
+     _mappings.back()->region.flush();
+  write_index();
   _block_num_to_pos.flush();
 }
 
+void block_database::map_blocks( uint64_t min_size )
+{
+   const mapped_blocks* current = _mapping.load();
+   if( current != nullptr && current->capacity >= min_size )
+      return;
+   // the file is grown before it is mapped, so that the whole mapping is backed by the file
+   uint64_t capacity = min_size + std::max( min_mapping_size, min_size / 4 );
+   const uint64_t file_size = fc::file_size( _blocks_filename );
+   if( file_size < capacity )
+      fc::resize_file( _blocks_filename, capacity );
+   else
+      capacity = file_size;
+   _mappings.emplace_back( new mapped_blocks( _blocks_filename, capacity ) );
+   _mapping.store( _mappings.back().get(), std::memory_order_release );
+}
+
+bool block_database::read_entry( uint32_t block_num, index_entry& e )const
+{
+   while( true )
+   {
+      const uint64_t seq = _index_seq.load( std::memory_order_acquire );
+      if( seq & 1 )
+         continue;
+      if( block_num >= _index_size.load( std::memory_order_acquire ) )
+         return false;
+      const index_entry* segment = _segments[block_num >> entries_per_segment_bits].load( std::memory_order_acquire );
+      e = segment ? segment[block_num & (entries_per_segment - 1)] : index_entry();
+      std::atomic_thread_fence( std::memory_order_acquire );
+      if( _index_seq.load( std::memory_order_relaxed ) == seq )
+         return true;
+   }
+}
+
+void block_database::write_entry( uint32_t block_num, const index_entry& e )const
+{
+   auto& segment_ptr = _segments[block_num >> entries_per_segment_bits];
+   index_entry* segment = segment_ptr.load();
+   if( segment == nullptr )
+   {
+      segment = new index_entry[entries_per_segment]();
+      segment_ptr.store( segment, std::memory_order_release );
+   }
+   index_entry& slot = segment[block_num & (entries_per_segment - 1)];
+
+   if( block_num < _index_size.load() )
+   {
+      // readers may be copying this entry right now
+      _index_seq.fetch_add( 1, std::memory_order_relaxed );
+      std::atomic_thread_fence( std::memory_order_release );
+      slot = e;
+      _index_seq.fetch_add( 1, std::memory_order_release );
+   }
+   else
+   {
+      slot = e;
+      _index_size.store( block_num + 1, std::memory_order_release );
+   }
+
+   if( _dirty_begin == _dirty_end )
+   {
+      _dirty_begin = block_num;
+      _dirty_end = block_num + 1;
+   }
+   else
+   {
+      _dirty_begin = std::min( _dirty_begin, block_num );
+      _dirty_end = std::max( _dirty_end, block_num + 1 );
+   }
+   if( _dirty_end - _dirty_begin >= index_write_interval )
+      write_index();
+}
+
+void block_database::write_index()const
+{
+   if( _dirty_begin == _dirty_end )
+      return;
+   _block_num_to_pos.seekp( sizeof( index_entry ) * int64_t(_dirty_begin) );
+   for( uint32_t n = _dirty_begin; n < _dirty_end; )
+   {
+      const uint32_t offset = n & (entries_per_segment - 1);
+      const uint32_t count = std::min( _dirty_end - n, entries_per_segment - offset );
+      const index_entry* segment = _segments[n >> entries_per_segment_bits].load();
+      if( segment != nullptr )
+         _block_num_to_pos.write( (const char*)(segment + offset), sizeof(index_entry) * count );
+      else
+      {
+         const std::vector<index_entry> empty( count );
+         _block_num_to_pos.write( (const char*)empty.data(), sizeof(index_entry) * count );
+      }
+      n += count;
+   }
+   _block_num_to_pos.flush();
+   _dirty_begin = _dirty_end = 0;
+}
+
+void block_database::truncate_index( uint32_t size )const
+{
+   const uint32_t old_size = _index_size.load();
+   if( size >= old_size )
+      return;
+
+   _index_seq.fetch_add( 1, std::memory_order_relaxed );
+   std::atomic_thread_fence( std::memory_order_release );
+   _index_size.store( size, std::memory_order_relaxed );
+   for( uint32_t n = size; n < old_size; ++n )
+   {
+      index_entry* segment = _segments[n >> entries_per_segment_bits].load();
+      if( segment != nullptr )
+         segment[n & (entries_per_segment - 1)] = index_entry();
+   }
+   _index_seq.fetch_add( 1, std::memory_order_release );
+
+   _dirty_end = std::min( _dirty_end, size );
+   if( _dirty_begin >= _dirty_end )
+      _dirty_begin = _dirty_end = 0;
+   write_index();
+   fc::resize_file( _index_filename, sizeof(index_entry) * uint64_t(size) );
+}
+
+optional<signed_block> block_database::read_block( const index_entry& e )const
+{
+   if( e.block_size == 0 || e.block_pos + e.block_size > _blocks_size.load( std::memory_order_acquire ) )
+      return optional<signed_block>();
+   const mapped_blocks* mapping = _mapping.load( std::memory_order_acquire );
+   if( mapping == nullptr || e.block_pos + e.block_size > mapping->capacity )
+      return optional<signed_block>();
+
+   // unpacked straight from the mapping
+   fc::datastream<const char*> ds( mapping->data() + e.block_pos, e.block_size );
+   signed_block result;
+   fc::raw::unpack( ds, result );
+   FC_ASSERT( result.id() == e.block_id );
+   return result;
+}
+
+optional<packed_block_view> block_database::read_packed_block( const index_entry& e )const
+{
+   if( e.block_size == 0 || e.block_pos + e.block_size > _blocks_size.load( std::memory_order_acquire ) )
+      return optional<packed_block_view>();
+   const mapped_blocks* mapping = _mapping.load( std::memory_order_acquire );
+   if( mapping == nullptr || e.block_pos + e.block_size > mapping->capacity )
+      return optional<packed_block_view>();
+
+   // the header is a prefix of the packed block, it is enough to check the id
+   packed_block_view result;
+   result.data = mapping->data() + e.block_pos;
+   result.size = e.block_size;
+   fc::datastream<const char*> ds( result.data, result.size );
+   signed_block_header header;
+   fc::raw::unpack( ds, header );
+   FC_ASSERT( header.id() == e.block_id );
+   return result;
+}
+
 void block_database::store( const block_id_type& _id, const signed_block& b )
 {
    block_id_type id = _id;
@@ -83,33 +321,29 @@ void block_database::store( const block_id_type& _id, const signed_block& b )
       id = b.id();
       elog( "id argument of block_database::store() was not initialized for block ${id}", ("id", id) );
    }
-   _block_num_to_pos.seekp( sizeof( index_entry ) * int64_t(block_header::num_from_id(id)) );
    index_entry e;
-   _blocks.seekp( 0, _blocks.end );
-   auto vec = fc::raw::pack( b );
-   e.block_pos  = _blocks.tellp();
-   e.block_size = vec.size();
+   e.block_pos  = _blocks_size.load();
+   e.block_size = fc::raw::pack_size( b );
    e.block_id   = id;
-   _blocks.write( vec.data(), vec.size() );
-   _block_num_to_pos.write( (char*)&e, sizeof(e) );
+
+   // packed straight into the mapping, readers do not look past _blocks_size
+   map_blocks( e.block_pos + e.block_size );
+   fc::datastream<char*> ds( _mapping.load()->data() + e.block_pos, e.block_size );
+   fc::raw::pack( ds, b );
+   _blocks_size.store( e.block_pos + e.block_size, std::memory_order_release );
+   write_entry( block_header::num_from_id(id), e );
 }
 
 void block_database::remove( const block_id_type& id )
 { try {
    index_entry e;
-   int64_t index_pos = sizeof(e) * int64_t(block_header::num_from_id(id));
-   _block_num_to_pos.seekg( 0, _block_num_to_pos.end );
-   if ( _block_num_to_pos.tellg() <= index_pos )
+   if( !read_entry( block_header::num_from_id(id), e ) )
       FC_THROW_EXCEPTION(fc::key_not_found_exception, "Block ${id} not contained in block database", ("id", id));
 
-   _block_num_to_pos.seekg( index_pos );
-   _block_num_to_pos.read( (char*)&e, sizeof(e) );
-
    if( e.block_id == id )
    {
       e.block_size = 0;
-      _block_num_to_pos.seekp( sizeof(e) * int64_t(block_header::num_from_id(id)) );
-      _block_num_to_pos.write( (char*)&e, sizeof(e) );
+      write_entry( block_header::num_from_id(id), e );
    }
 } FC_CAPTURE_AND_RETHROW( (id) ) }
 
@@ -119,12 +353,8 @@ bool block_database::contains( const block_id_type& id )const
       return false;
 
    index_entry e;
-   int64_t index_pos = sizeof(e) * int64_t(block_header::num_from_id(id));
-   _block_num_to_pos.seekg( 0, _block_num_to_pos.end );
-   if ( _block_num_to_pos.tellg() < int64_t(index_pos + sizeof(e)) )
+   if( !read_entry( block_header::num_from_id(id), e ) )
       return false;
-   _block_num_to_pos.seekg( index_pos );
-   _block_num_to_pos.read( (char*)&e, sizeof(e) );
 
    return e.block_id == id && e.block_size > 0;
 }
@@ -133,14 +363,9 @@ block_id_type block_database::fetch_block_id( uint32_t block_num )const
 {
    assert( block_num != 0 );
    index_entry e;
-   int64_t index_pos = sizeof(e) * int64_t(block_num);
-   _block_num_to_pos.seekg( 0, _block_num_to_pos.end );
-   if ( _block_num_to_pos.tellg() <= index_pos )
+   if( !read_entry( block_num, e ) )
       FC_THROW_EXCEPTION(fc::key_not_found_exception, "Block number ${block_num} not contained in block database", ("block_num", block_num));
 
-   _block_num_to_pos.seekg( index_pos );
-   _block_num_to_pos.read( (char*)&e, sizeof(e) );
-
    FC_ASSERT( e.block_id != block_id_type(), "Empty block_id in block_database (maybe corrupt on disk?)" );
    return e.block_id;
 }
@@ -150,23 +375,12 @@ optional<signed_block> block_database::fetch_optional( const block_id_type& id )
    try
    {
       index_entry e;
-      int64_t index_pos = sizeof(e) * int64_t(block_header::num_from_id(id));
-      _block_num_to_pos.seekg( 0, _block_num_to_pos.end );
-      if ( _block_num_to_pos.tellg() <= index_pos )
+      if( !read_entry( block_header::num_from_id(id), e ) )
          return {};
 
-      _block_num_to_pos.seekg( index_pos );
-      _block_num_to_pos.read( (char*)&e, sizeof(e) );
-
       if( e.block_id != id ) return optional<signed_block>();
 
-      vector<char> data( e.block_size );
-      _blocks.seekg( e.block_pos );
-      if (e.block_size)
-         _blocks.read( data.data(), e.block_size );
-      auto result = fc::raw::unpack<signed_block>(data);
-      FC_ASSERT( result.id() == e.block_id );
-      return result;
+      return read_block( e );
    }
    catch (const fc::exception&)
    {
@@ -182,20 +396,10 @@ optional<signed_block> block_database::fetch_by_number( uint32_t block_num )cons
    try
    {
       index_entry e;
-      int64_t index_pos = sizeof(e) * int64_t(block_num);
-      _block_num_to_pos.seekg( 0, _block_num_to_pos.end );
-      if ( _block_num_to_pos.tellg() <= index_pos )
+      if( !read_entry( block_num, e ) )
          return {};
 
-      _block_num_to_pos.seekg( index_pos, _block_num_to_pos.beg );
-      _block_num_to_pos.read( (char*)&e, sizeof(e) );
-
-      vector<char> data( e.block_size );
-      _blocks.seekg( e.block_pos );
-      _blocks.read( data.data(), e.block_size );
-      auto result = fc::raw::unpack<signed_block>(data);
-      FC_ASSERT( result.id() == e.block_id );
-      return result;
+      return read_block( e );
    }
    catch (const fc::exception&)
    {
@@ -206,38 +410,55 @@ optional<signed_block> block_database::fetch_by_number( uint32_t block_num )cons
    return optional<signed_block>();
 }
 
-optional<index_entry> block_database::last_index_entry()const {
+optional<packed_block_view> block_database::fetch_packed_by_number( uint32_t block_num )const
+{
    try
    {
       index_entry e;
+      if( !read_entry( block_num, e ) )
+         return {};
 
-      _block_num_to_pos.seekg( 0, _block_num_to_pos.end );
-      std::streampos pos = _block_num_to_pos.tellg();
-      if( pos < long(sizeof(index_entry)) )
-         return optional<index_entry>();
+      return read_packed_block( e );
+   }
+   catch (const fc::exception&)
+   {
+   }
+   catch (const std::exception&)
+   {
+   }
+   return optional<packed_block_view>();
+}
 
-      pos -= pos % sizeof(index_entry);
+vector<packed_block_view> block_database::fetch_packed_range( uint32_t first, uint32_t last )const
+{
+   vector<packed_block_view> result;
+   if( last < first )
+      return result;
+   result.reserve( std::min<uint64_t>( uint64_t(last) - first + 1, _index_size.load() ) );
+   for( uint32_t block_num = first; block_num <= last; ++block_num )
+   {
+      auto view = fetch_packed_by_number( block_num );
+      if( !view.valid() )
+         break;
+      result.push_back( *view );
+      if( block_num == std::numeric_limits<uint32_t>::max() )
+         break;
+   }
+   return result;
+}
 
-      _blocks.seekg( 0, _block_num_to_pos.end );
-      const std::streampos blocks_size = _blocks.tellg();
-      while( pos > 0 )
+optional<index_entry> block_database::last_index_entry()const {
+   try
+   {
+      uint32_t size = _index_size.load();
+      while( size > 0 )
       {
-         pos -= sizeof(index_entry);
-         _block_num_to_pos.seekg( pos );
-         _block_num_to_pos.read( (char*)&e, sizeof(e) );
-         if( _block_num_to_pos.gcount() == sizeof(e) && e.block_size > 0
-                && int64_t(e.block_pos + e.block_size) <= blocks_size )
+         index_entry e;
+         if( read_entry( size - 1, e ) && e.block_size > 0 )
             try
             {
-               vector<char> data( e.block_size );
-               _blocks.seekg( e.block_pos );
-               _blocks.read( data.data(), e.block_size );
-               if( _blocks.gcount() == long(e.block_size) )
-               {
-                  const signed_block block = fc::raw::unpack<signed_block>(data);
-                  if( block.id() == e.block_id )
-                     return e;
-               }
+               if( read_block( e ).valid() )
+                  return e;
             }
             catch (const fc::exception&)
             {
@@ -245,7 +466,8 @@ optional<index_entry> block_database::last_index_entry()const {
             catch (const std::exception&)
             {
             }
-         fc::resize_file( _index_filename, pos );
+         --size;
+         truncate_index( size );
       }
    }
    catch (const fc::exception&)
@@ -0,0 +1,127 @@
+/*
+ * Copyright (c) 2015 Cryptonomex, Inc., and contributors.
+ *
+ * The MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#include <graphene/chain/chain_profiler.hpp>
+#include <graphene/chain/protocol/operations.hpp>
+
+namespace graphene { namespace chain {
+
+namespace {
+   struct operation_name_visitor
+   {
+      typedef string result_type;
+
+      template<typename Operation>
+      string operator()( const Operation& )const
+      {
+         string name = fc::get_typename<Operation>::name();
+         const auto ns = name.rfind( "::" );
+         if( ns != string::npos )
+            name = name.substr( ns + 2 );
+         const string suffix = "_operation";
+         if( name.size() > suffix.size() && name.compare( name.size() - suffix.size(), suffix.size(), suffix ) == 0 )
+            name.resize( name.size() - suffix.size() );
+         return name;
+      }
+   };
+}
+
+void latency_histogram::record( const fc::microseconds& elapsed )
+{
+   const uint64_t us = std::max<int64_t>( elapsed.count(), 0 );
+   ++count;
+   total_us += us;
+   max_us = std::max( max_us, us );
+
+   uint32_t bucket = 0;
+   while( bucket + 1 < num_buckets && (uint64_t(1) << bucket) <= us )
+      ++bucket;
+   if( buckets.size() <= bucket )
+      buckets.resize( bucket + 1 );
+   ++buckets[bucket];
+}
+
+void chain_profiler::enable( bool e )
+{
+   if( e && !_enabled && _since == fc::time_point() )
+      _since = fc::time_point::now();
+   _enabled = e;
+}
+
+void chain_profiler::reset()
+{
+   _since = _enabled ? fc::time_point::now() : fc::time_point();
+   _first_block_num = 0;
+   _last_block_num = 0;
+   _operations.clear();
+   _blocks = block_profile();
+}
+
+fc::time_point chain_profiler::lap( latency_histogram block_profile::* phase, const fc::time_point& start )
+{
+   if( !_enabled )
+      return start;
+   const auto now = fc::time_point::now();
+   (_blocks.*phase).record( now - start );
+   return now;
+}
+
+void chain_profiler::record_block( uint32_t block_num, const fc::time_point& start )
+{
+   if( !_enabled )
+      return;
+   _blocks.total.record( fc::time_point::now() - start );
+   if( _first_block_num == 0 )
+      _first_block_num = block_num;
+   _last_block_num = block_num;
+}
+
+operation_profile& chain_profiler::operation_stats( int which )
+{
+   FC_ASSERT( which >= 0 );
+   if( _operations.size() <= size_t(which) )
+      _operations.resize( which + 1 );
+   return _operations[which];
+}
+
+chain_profile chain_profiler::report()const
+{
+   chain_profile result;
+   result.enabled = _enabled;
+   result.since = _since;
+   result.first_block_num = _first_block_num;
+   result.last_block_num = _last_block_num;
+   result.blocks = _blocks;
+   for( size_t which = 0; which < _operations.size(); ++which )
+   {
+      const operation_profile& p = _operations[which];
+      if( p.evaluate.count == 0 )
+         continue;
+      graphene::chain::operation op;
+      op.set_which( which );
+      result.operations[ op.visit( operation_name_visitor() ) ] = p;
+   }
+   return result;
+}
+
+} } // graphene::chain
@@ -33,11 +33,16 @@ namespace graphene { namespace chain {
 
 asset database::get_balance(account_id_type owner, asset_id_type asset_id) const
 {
-   auto& index = get_index_type<account_balance_index>().indices().get<by_account_asset>();
+   auto& index = get_index_type<account_balance_index>().indices().get<by_owner_asset>();
    auto itr = index.find(boost::make_tuple(owner, asset_id));
-   if( itr == index.end() )
-      return asset(0, asset_id);
-   return itr->get_balance();
+   asset result = itr == index.end() ? asset(0, asset_id) : itr->get_balance();
+   if( owner == GRAPHENE_UMT_FEE_POOL_ACCOUNT )
+   {
+      auto pending = _pending_fee_pool.find( asset_id );
+      if( pending != _pending_fee_pool.end() )
+         result.amount += pending->second;
+   }
+   return result;
 }
 
 asset database::get_balance(const account_object& owner, const asset_object& asset_obj) const
@@ -54,8 +59,10 @@ void database::adjust_balance(account_id_type account, asset delta )
 { try {
    if( delta.amount == 0 )
       return;
+   if( account == GRAPHENE_UMT_FEE_POOL_ACCOUNT )
+      flush_fee_pool();
 
-   auto& index = get_index_type<account_balance_index>().indices().get<by_account_asset>();
+   auto& index = get_index_type<account_balance_index>().indices().get<by_owner_asset>();
    auto itr = index.find(boost::make_tuple(account, delta.asset_id));
    if(itr == index.end())
    {
@@ -78,6 +85,39 @@ void database::adjust_balance(account_id_type account, asset delta )
 
 } FC_CAPTURE_AND_RETHROW( (account)(delta) ) }
 
+void database::credit_fee_pool( const asset& fee )
+{
+   if( fee.amount == 0 )
+      return;
+   if( _accumulate_fee_pool )
+   {
+      auto pending = _pending_fee_pool.find( fee.asset_id );
+      if( pending != _pending_fee_pool.end() )
+      {
+         pending->second += fee.amount;
+         return;
+      }
+      // the first credit in an asset creates the balance object right away, so object ids are allocated as before
+      auto& index = get_index_type<account_balance_index>().indices().get<by_owner_asset>();
+      if( index.find( boost::make_tuple( GRAPHENE_UMT_FEE_POOL_ACCOUNT, fee.asset_id ) ) != index.end() )
+      {
+         _pending_fee_pool.emplace( fee.asset_id, fee.amount );
+         return;
+      }
+   }
+   adjust_balance( GRAPHENE_UMT_FEE_POOL_ACCOUNT, fee );
+}
+
+void database::flush_fee_pool()
+{
+   if( _pending_fee_pool.empty() )
+      return;
+   flat_map<asset_id_type,share_type> pending;
+   std::swap( pending, _pending_fee_pool );
+   for( const auto& credit : pending )
+      adjust_balance( GRAPHENE_UMT_FEE_POOL_ACCOUNT, asset( credit.second, credit.first ) );
+}
+
 optional< vesting_balance_id_type > database::deposit_lazy_vesting(
    const optional< vesting_balance_id_type >& ovbid,
    share_type amount, uint32_t req_vesting_seconds,
@@ -38,6 +38,10 @@
 #include <graphene/chain/evaluator.hpp>
 
 #include <fc/smart_ref_impl.hpp>
+#include <fc/thread/thread.hpp>
+#include <fc/thread/thread_specific.hpp>
+
+#include <thread>
 
 namespace graphene { namespace chain {
 
@@ -71,6 +75,9 @@ optional<signed_block> database::fetch_block_by_id( const block_id_type& id )con
 
 optional<signed_block> database::fetch_block_by_number( uint32_t num )const
 {
+   // irreversible blocks cannot be on another fork, no need to ask the fork database
+   if( num <= get_dynamic_global_properties().last_irreversible_block_num )
+      return _block_id_to_block.fetch_by_number(num);
    auto results = _fork_db.fetch_block_by_number(num);
    if( results.size() == 1 )
       return results[0]->data;
@@ -79,12 +86,26 @@ optional<signed_block> database::fetch_block_by_number( uint32_t num )const
    return optional<signed_block>();
 }
 
-const signed_transaction& database::get_recent_transaction(const transaction_id_type& trx_id) const
+optional<packed_block_view> database::fetch_packed_block_by_number( uint32_t num )const
+{
+   if( num <= get_dynamic_global_properties().last_irreversible_block_num )
+      return _block_id_to_block.fetch_packed_by_number(num);
+   auto block = fetch_block_by_number(num);
+   if( !block.valid() )
+      return optional<packed_block_view>();
+   packed_block_view result;
+   auto packed = std::make_shared< const vector<char> >( fc::raw::pack( *block ) );
+   result.data = packed->data();
+   result.size = packed->size();
+   result.owner = std::move( packed );
+   return result;
+}
+
+std::shared_ptr<const signed_transaction> database::get_recent_transaction(const transaction_id_type& trx_id) const
 {
-   auto& index = get_index_type<transaction_index>().indices().get<by_trx_id>();
-   auto itr = index.find(trx_id);
-   FC_ASSERT(itr != index.end());
-   return itr->trx;
+   auto trx = _recent_transactions.find(trx_id);
+   FC_ASSERT(trx, "Transaction ${id} is not among the recent transactions", ("id", trx_id));
+   return trx;
 }
 
 std::vector<block_id_type> database::get_block_ids_on_fork(block_id_type head_of_fork) const
@@ -114,6 +135,10 @@ std::vector<block_id_type> database::get_block_ids_on_fork(block_id_type head_of
 bool database::push_block(const signed_block& new_block, uint32_t skip)
 {
 //   idump((new_block.block_num())(new_block.id())(new_block.timestamp)(new_block.previous));
+   if( !(skip & (skip_transaction_signatures | skip_authority_check)) )
+      precompute_signature_keys( new_block.transactions );
+
+   write_lock lock( *this );
    bool result;
    detail::with_skip_flags( *this, skip, [&]()
    {
@@ -218,6 +243,7 @@ bool database::_push_block(const signed_block& new_block)
  */
 processed_transaction database::push_transaction( const signed_transaction& trx, uint32_t skip )
 { try {
+   write_lock lock( *this );
    processed_transaction result;
    detail::with_skip_flags( *this, skip, [&]()
    {
@@ -253,6 +279,7 @@ processed_transaction database::_push_transaction( const signed_transaction& trx
 
 processed_transaction database::validate_transaction( const signed_transaction& trx )
 {
+   write_lock lock( *this );
    auto session = _undo_db.start_undo_session();
    return _apply_transaction( trx );
 }
@@ -266,6 +293,7 @@ processed_transaction database::push_proposal(const proposal_object& proposal)
    processed_transaction ptrx(proposal.proposed_transaction);
    eval_state._trx = &ptrx;
    size_t old_applied_ops_size = _applied_ops.size();
+   auto old_pending_fee_pool = _pending_fee_pool;
 
    try {
       auto session = _undo_db.start_undo_session(true);
@@ -276,6 +304,7 @@ processed_transaction database::push_proposal(const proposal_object& proposal)
    } catch ( const fc::exception& e ) {
       {
          _applied_ops.resize( old_applied_ops_size );
+         _pending_fee_pool = std::move( old_pending_fee_pool );
       }
       elog( "e", ("e",e.to_detail_string() ) );
       throw;
@@ -292,6 +321,7 @@ signed_block database::generate_block(
    uint32_t skip /* = 0 */
    )
 { try {
+   write_lock lock( *this );
    signed_block result;
    detail::with_skip_flags( *this, skip, [&]()
    {
@@ -385,11 +415,14 @@ signed_block database::_generate_block(
 
    pending_block.previous = head_block_id();
    pending_block.timestamp = when;
+   for( const auto& trx : pending_block.transactions )
+      trx.cache_digests( get_chain_id() );
    pending_block.transaction_merkle_root = pending_block.calculate_merkle_root();
    pending_block.witness = witness_id;
 
    if( !(skip & skip_witness_signature) )
       pending_block.sign( block_signing_private_key );
+   pending_block.cache_id();
 
    // TODO:  Move this to _push_block() so session is restored.
    if( !(skip & skip_block_size_check) )
@@ -408,6 +441,7 @@ signed_block database::_generate_block(
  */
 void database::pop_block()
 { try {
+   write_lock lock( *this );
    _pending_tx_session.reset();
    auto head_id = head_block_id();
    optional<signed_block> head_block = fetch_block_by_id( head_id );
@@ -420,6 +454,46 @@ void database::pop_block()
 
 } FC_CAPTURE_AND_RETHROW() }
 
+namespace {
+   /** write_lock nesting per database, counted per fc task: the tasks of a thread share it and take turns, so a
+    *  per thread count would let a task in while another one is suspended halfway through a push */
+   fc::task_specific_ptr< flat_map<const database*, uint32_t> > write_lock_depth;
+}
+
+database::write_lock::write_lock( database& db ) : _db( db )
+{
+   if( !write_lock_depth.get() )
+      write_lock_depth.reset( new flat_map<const database*, uint32_t>() );
+   if( write_lock_depth->find( &_db ) == write_lock_depth->end() )
+   {
+      // yields while another task holds it, even one of this thread, which the boost mutexes would deadlock on.
+      // The depth is only counted once the lock is held, waiting may be canceled
+      _db._writer_mutex.lock();
+      _db._writer_gate.lock();
+      _db._state_mutex.lock();
+   }
+   ++(*write_lock_depth)[&_db];
+}
+
+database::write_lock::~write_lock()
+{
+   auto depth = write_lock_depth->find( &_db );
+   if( --depth->second == 0 )
+   {
+      write_lock_depth->erase( depth );
+      _db._state_mutex.unlock();
+      _db._writer_gate.unlock();
+      _db._writer_mutex.unlock();
+   }
+}
+
+boost::shared_lock<boost::shared_mutex> database::lock_for_reading()const
+{
+   // wait behind a writer that is waiting for the current readers
+   boost::lock_guard<boost::mutex> gate( _writer_gate );
+   return boost::shared_lock<boost::shared_mutex>( _state_mutex );
+}
+
 void database::clear_pending()
 { try {
    assert( (_pending_tx.size() == 0) || _pending_tx_session.valid() );
@@ -470,7 +544,19 @@ void database::apply_block( const signed_block& next_block, uint32_t skip )
 
    detail::with_skip_flags( *this, skip, [&]()
    {
-      _apply_block( next_block );
+      _applying_block = true;
+      try
+      {
+         _apply_block( next_block );
+      }
+      catch( ... )
+      {
+         // the caller undoes the block, drop the fee pool credits it accumulated
+         _applying_block = false;
+         _pending_fee_pool.clear();
+         throw;
+      }
+      _applying_block = false;
    } );
    return;
 }
@@ -479,9 +565,11 @@ void database::_apply_block( const signed_block& next_block )
 { try {
    uint32_t next_block_num = next_block.block_num();
    uint32_t skip = get_node_properties().skip_flags;
+   const auto block_start = _profiler.now();
    _applied_ops.clear();
 
-   FC_ASSERT( (skip & skip_merkle_check) || next_block.transaction_merkle_root == next_block.calculate_merkle_root(), "", ("next_block.transaction_merkle_root",next_block.transaction_merkle_root)("calc",next_block.calculate_merkle_root())("next_block",next_block)("id",next_block.id()) );
+   FC_ASSERT( (skip & skip_merkle_check) || next_block.transaction_merkle_root ==
+              ( _replay_block && &_replay_block->block == &next_block ? _replay_block->merkle_root : next_block.calculate_merkle_root() ), "", ("next_block.transaction_merkle_root",next_block.transaction_merkle_root)("calc",next_block.calculate_merkle_root())("next_block",next_block)("id",next_block.id()) );
 
    const witness_object& signing_witness = validate_block_header(skip, next_block);
    const auto& global_props = get_global_properties();
@@ -491,6 +579,8 @@ void database::_apply_block( const signed_block& next_block )
    _current_block_num    = next_block_num;
    _current_trx_in_block = 0;
 
+   auto phase_start = _profiler.now();
+
    for( const auto& trx : next_block.transactions )
    {
       /* We do not need to push the undo state for each transaction
@@ -502,22 +592,30 @@ void database::_apply_block( const signed_block& next_block )
       apply_transaction( trx, skip );
       ++_current_trx_in_block;
    }
+   flush_fee_pool();
+   phase_start = _profiler.lap( &block_profile::transactions, phase_start );
 
    update_global_dynamic_data(next_block);
    update_signing_witness(signing_witness, next_block);
    update_last_irreversible_block();
+   phase_start = _profiler.lap( &block_profile::block_updates, phase_start );
 
    // Are we at the maintenance interval?
    if( maint_needed )
+   {
       perform_chain_maintenance(next_block, global_props);
+      phase_start = _profiler.lap( &block_profile::maintenance, phase_start );
+   }
 
    create_block_summary(next_block);
    clear_expired_transactions();
+   clear_expired_signature_keys();
    clear_expired_proposals();
    clear_expired_orders();
    clear_expired_bids();
    clear_expired_bid_requests();
    update_withdraw_permissions();
+   phase_start = _profiler.lap( &block_profile::clear_expired, phase_start );
 
    // n.b., update_maintenance_flag() happens this late
    // because get_slot_time() / get_slot_at_time() is needed above
@@ -528,12 +626,17 @@ void database::_apply_block( const signed_block& next_block )
    update_witness_schedule();
    if( !_node_property_object.debug_updates.empty() )
       apply_debug_updates();
+   flush_fee_pool();
+   phase_start = _profiler.lap( &block_profile::witness_schedule, phase_start );
 
    // notify observers that the block has been applied
    applied_block( next_block ); //emit
    _applied_ops.clear();
+   phase_start = _profiler.lap( &block_profile::applied_block, phase_start );
 
    notify_changed_objects();
+   _profiler.lap( &block_profile::notify_changed_objects, phase_start );
+   _profiler.record_block( next_block_num, block_start );
 } FC_CAPTURE_AND_RETHROW( (next_block.block_num()) )  }
 
 
@@ -556,7 +659,6 @@ processed_transaction database::_apply_transaction(const signed_transaction& trx
       trx.validate();
 
    auto& trx_idx = get_mutable_index_type<transaction_index>();
-   const chain_id_type& chain_id = get_chain_id();
    auto trx_id = trx.id();
    FC_ASSERT( (skip & skip_transaction_dupe_check) ||
               trx_idx.indices().get<by_trx_id>().find(trx_id) == trx_idx.indices().get<by_trx_id>().end() );
@@ -564,11 +666,15 @@ processed_transaction database::_apply_transaction(const signed_transaction& trx
    const chain_parameters& chain_parameters = get_global_properties().parameters;
    eval_state._trx = &trx;
 
+   flat_set<public_key_type> signature_keys;
+   bool recovered_signature_keys = false;
    if( !(skip & (skip_transaction_signatures | skip_authority_check) ) )
    {
       auto get_active = [&]( account_id_type id ) { return &id(*this).active; };
       auto get_owner  = [&]( account_id_type id ) { return &id(*this).owner;  };
-      trx.verify_authority( chain_id, get_active, get_owner, get_global_properties().parameters.max_authority_depth );
+      signature_keys = signature_keys_of( trx, trx_id, recovered_signature_keys );
+      graphene::chain::verify_authority( trx.operations, signature_keys, get_active, get_owner,
+                                         get_global_properties().parameters.max_authority_depth );
    }
 
    //Skip all manner of expiration and TaPoS checking if we're on block 1; It's impossible that the transaction is
@@ -590,12 +696,16 @@ processed_transaction database::_apply_transaction(const signed_transaction& trx
       FC_ASSERT( now <= trx.expiration, "", ("now",now)("trx.exp",trx.expiration) );
    }
 
+   // only now the expiration is known to be near, so the cache entry cannot outlive the transaction by much
+   if( recovered_signature_keys )
+      cache_signature_keys( trx, trx_id, std::move( signature_keys ) );
+
    //Insert transaction into unique transactions database.
    if( !(skip & skip_transaction_dupe_check) )
    {
       create<transaction_object>([&](transaction_object& transaction) {
          transaction.trx_id = trx_id;
-         transaction.trx = trx;
+         transaction.expiration = trx.expiration;
       });
    }
 
@@ -604,17 +714,30 @@ processed_transaction database::_apply_transaction(const signed_transaction& trx
    //Finally process the operations
    processed_transaction ptrx(trx);
    _current_op_in_trx = 0;
-   for( const auto& op : ptrx.operations )
+   try
    {
-      eval_state.operation_results.emplace_back(apply_operation(eval_state, op));
-      ++_current_op_in_trx;
+      for( const auto& op : ptrx.operations )
+      {
+         eval_state.operation_results.emplace_back(apply_operation(eval_state, op));
+         ++_current_op_in_trx;
+      }
+   }
+   catch( ... )
+   {
+      if( !_applying_block )
+         _pending_fee_pool.clear();
+      throw;
    }
    ptrx.operation_results = std::move(eval_state.operation_results);
+   if( !_applying_block )
+      flush_fee_pool();
 
    //Make sure the temp account has no non-zero balances
-   const auto& index = get_index_type<account_balance_index>().indices().get<by_account_asset>();
-   auto range = index.equal_range( boost::make_tuple( GRAPHENE_TEMP_ACCOUNT ) );
-   std::for_each(range.first, range.second, [](const account_balance_object& b) { FC_ASSERT(b.balance == 0); });
+   FC_ASSERT( _temp_account_balances->nonzero_balances == 0 );
+
+   // kept only once the transaction applied, a failed one leaves no transaction_object behind to be looked up by
+   if( !(skip & skip_transaction_dupe_check) )
+      _recent_transactions.add( trx_id, trx );
 
    return ptrx;
 } FC_CAPTURE_AND_RETHROW( (trx) ) }
@@ -667,6 +790,118 @@ void database::create_block_summary(const signed_block& next_block)
    });
 }
 
+void database::enable_profiling( bool enable )
+{
+   _profiler.enable( enable );
+   _undo_db.count_changes( enable );
+}
+
+namespace {
+   /** transactions whose recovered keys are cached at most, so that junk transactions cannot grow the cache */
+   const size_t max_signature_keys = 1 << 17;
+   /** below this many signatures a block's keys are recovered on the calling thread */
+   const size_t min_parallel_signatures = 8;
+}
+
+void database::precompute_signature_keys( const vector<processed_transaction>& trxs )
+{
+   typedef std::pair<transaction_id_type, signature_keys> recovered_keys;
+
+   vector<const processed_transaction*> todo;
+   size_t num_signatures = 0;
+   for( const auto& trx : trxs )
+   {
+      if( trx.signatures.empty() )
+         continue;
+      todo.push_back( &trx );
+      num_signatures += trx.signatures.size();
+   }
+   if( todo.empty() || _signature_keys.size() >= max_signature_keys )
+      return;
+
+   const chain_id_type& chain_id = get_chain_id();
+   auto recover = [&todo,&chain_id]( size_t begin, size_t end ) {
+      vector<recovered_keys> result;
+      result.reserve( end - begin );
+      for( size_t i = begin; i < end; ++i )
+      {
+         const processed_transaction& trx = *todo[i];
+         try {
+            result.emplace_back( trx.id(), signature_keys{ trx.signatures, trx.get_signature_keys( chain_id ), trx.expiration } );
+         } catch( const fc::exception& ) {
+            // invalid signatures are reported when the transaction is applied
+         }
+      }
+      return result;
+   };
+
+   vector< vector<recovered_keys> > results;
+   if( num_signatures < min_parallel_signatures )
+      results.push_back( recover( 0, todo.size() ) );
+   else
+   {
+      if( _signature_threads.empty() )
+      {
+         const size_t num_threads = std::max( 1u, std::thread::hardware_concurrency() );
+         for( size_t i = 0; i < num_threads; ++i )
+            _signature_threads.emplace_back( new fc::thread( "signatures " + fc::to_string( uint64_t(i) ) ) );
+      }
+      const size_t num_tasks = std::min( _signature_threads.size(), todo.size() );
+      vector< fc::future< vector<recovered_keys> > > tasks;
+      for( size_t t = 0; t < num_tasks; ++t )
+      {
+         const size_t begin = todo.size() * t / num_tasks;
+         const size_t end = todo.size() * (t + 1) / num_tasks;
+         tasks.push_back( _signature_threads[t]->async( [&recover,begin,end]() { return recover( begin, end ); },
+                                                        "recover signature keys" ) );
+      }
+      for( auto& task : tasks )
+      {
+         try {
+            results.push_back( task.wait() );
+         } catch( ... ) {
+            // the keys are recovered again when the transactions are applied
+         }
+      }
+   }
+
+   // the block is not validated yet, so its transactions may claim any expiration; the entries are kept no longer
+   // than a valid transaction could live
+   const fc::time_point_sec latest_expiration = head_block_time()
+                                                + get_global_properties().parameters.maximum_time_until_expiration;
+   for( auto& batch : results )
+      for( auto& r : batch )
+      {
+         if( _signature_keys.size() >= max_signature_keys )
+            return;
+         if( _signature_keys.find( r.first ) != _signature_keys.end() )
+            continue;
+         r.second.expiration = std::min( r.second.expiration, latest_expiration );
+         _signature_keys_by_expiration.emplace( r.second.expiration, r.first );
+         _signature_keys.emplace( r.first, std::move( r.second ) );
+      }
+}
+
+flat_set<public_key_type> database::signature_keys_of( const signed_transaction& trx, const transaction_id_type& trx_id,
+                                                       bool& recovered )const
+{
+   auto itr = _signature_keys.find( trx_id );
+   if( itr != _signature_keys.end() && itr->second.signatures == trx.signatures )
+      return itr->second.keys;
+
+   recovered = true;
+   return trx.get_signature_keys( get_chain_id() );
+}
+
+void database::cache_signature_keys( const signed_transaction& trx, const transaction_id_type& trx_id,
+                                     flat_set<public_key_type> keys )
+{
+   if( _signature_keys.size() >= max_signature_keys || _signature_keys.find( trx_id ) != _signature_keys.end() )
+      return;
+   _signature_keys_by_expiration.emplace( trx.expiration, trx_id );
+   _signature_keys.emplace( trx_id, signature_keys{ trx.signatures, std::move( keys ), trx.expiration } );
+}
+
 void database::add_checkpoints( const flat_map<uint32_t,block_id_type>& checkpts )
 {
    for( const auto& i : checkpts )
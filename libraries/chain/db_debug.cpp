@@ -172,6 +172,7 @@ void database::apply_debug_updates()
 
 void database::debug_update( const fc::variant_object& update )
 {
+   write_lock lock( *this );
    block_id_type head_id = head_block_id();
    auto it = _node_property_object.debug_updates.find( head_id );
    if( it == _node_property_object.debug_updates.end() )
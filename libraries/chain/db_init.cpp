@@ -175,7 +175,7 @@ void database::initialize_indexes()
 
    add_index< primary_index<committee_member_index> >();
    add_index< primary_index<witness_index> >();
-   add_index< primary_index<limit_order_index > >();
+   auto limit_order_idx = add_index< primary_index<limit_order_index > >();
 
    auto prop_index = add_index< primary_index<proposal_index > >();
    prop_index->add_secondary_index<required_approval_index>();
@@ -186,12 +186,19 @@ void database::initialize_indexes()
    add_index< primary_index<blinded_balance_index> >();
 
    add_index< primary_index<service_index> >();
-   add_index< primary_index<bid_request_index> >();
-   add_index< primary_index<bid_index> >();
+   auto bid_request_idx = add_index< primary_index<bid_request_index> >();
+   auto bid_request_expiry = bid_request_idx->add_secondary_index< expiry_index<bid_request_object> >();
+   bid_request_idx->add_secondary_index<bid_request_member_index>();
+   auto bid_idx = add_index< primary_index<bid_index> >();
+   auto bid_expiry = bid_idx->add_secondary_index< expiry_index<bid_object> >();
+   bid_idx->add_secondary_index<bid_request_ref_index>()->bid_requests = bid_request_expiry;
+   limit_order_idx->add_secondary_index<bid_order_ref_index>()->bids = bid_expiry;
 
    //Implementation object indexes
    add_index< primary_index<transaction_index                             > >();
-   add_index< primary_index<account_balance_index                         > >();
+   auto bal_index = add_index< primary_index<account_balance_index        > >();
+   bal_index->add_secondary_index<asset_holder_index>()->balances = bal_index;
+   _temp_account_balances = bal_index->add_secondary_index<temp_account_balance_index>();
    add_index< primary_index<simple_index<global_property_object          >> >();
    add_index< primary_index<simple_index<dynamic_global_property_object  >> >();
    add_index< primary_index<simple_index<account_statistics_object       >> >();
@@ -350,19 +350,19 @@ void update_top_n_authorities( database& db )
 
          const top_holders_special_authority& tha = auth.get< top_holders_special_authority >();
          vote_counter vc;
-         const auto& bal_idx = db.get_index_type< account_balance_index >().indices().get< by_asset_balance >();
+         const auto& bal_idx = dynamic_cast<const primary_index<account_balance_index>&>(
+                                  db.get_index_type< account_balance_index >() );
          uint8_t num_needed = tha.num_top_holders;
          if( num_needed == 0 )
             return;
 
          // find accounts
-         const auto range = bal_idx.equal_range( boost::make_tuple( tha.asset ) );
-         for( const account_balance_object& bal : boost::make_iterator_range( range.first, range.second ) )
+         const auto& holders = bal_idx.get_secondary_index< asset_holder_index >().holders( tha.asset );
+         for( const asset_holder_index::holder& h : holders )
          {
-             assert( bal.asset_type == tha.asset );
-             if( bal.owner == acct.id )
+             if( h.owner == acct.id )
                 continue;
-             vc.add( bal.owner, bal.balance.value );
+             vc.add( h.owner, h.balance.value );
              --num_needed;
              if( num_needed == 0 )
                 break;
@@ -393,8 +393,9 @@ void distribute_umt_fee( database& db )
   asset_id_type umt_asset_id = GRAPHENE_UMT_ASSET_ID;
   account_id_type umt_fee_pool_id (6);
 
-  const auto& bal_idx = db.get_index_type< account_balance_index >().indices().get< by_asset_balance >();
-  auto range = bal_idx.equal_range( boost::make_tuple( umt_asset_id ) );
+  // the holders index only has non-zero balances, no need to walk the empty ones
+  const auto& bal_idx = dynamic_cast<const primary_index<account_balance_index>&>( db.get_index_type< account_balance_index >() );
+  const auto& holders = bal_idx.get_secondary_index< asset_holder_index >().holders( umt_asset_id );
 
   struct account_umt_balance
   {
@@ -403,23 +404,21 @@ void distribute_umt_fee( database& db )
   };
   
   vector<account_umt_balance> allumt;
+  allumt.reserve( holders.size() );
   share_type umt_fee_to_distribute = 0;
   share_type umt_sum_amount = 0;
   
-  for( const account_balance_object& bal : boost::make_iterator_range( range.first, range.second ) )
+  for( const asset_holder_index::holder& h : holders )
   {
-    if( bal.balance.value == 0 )
-        continue;
-
     // don't count umt fee pool
-    if( bal.owner == umt_fee_pool_id){
-      umt_fee_to_distribute = bal.balance.value;
+    if( h.owner == umt_fee_pool_id){
+      umt_fee_to_distribute = h.balance.value;
       continue;
     }
 
     account_umt_balance aumt;
-    aumt.account_id = bal.owner;
-    aumt.amount     = bal.balance.value;
+    aumt.account_id = h.owner;
+    aumt.amount     = h.balance.value;
     allumt.push_back(aumt);
     
     umt_sum_amount += aumt.amount;
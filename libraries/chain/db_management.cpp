@@ -28,13 +28,100 @@
 #include <graphene/chain/protocol/fee_schedule.hpp>
 
 #include <fc/io/fstream.hpp>
+#include <fc/thread/thread.hpp>
 
+#include <deque>
 #include <fstream>
 #include <functional>
 #include <iostream>
+#include <thread>
 
 namespace graphene { namespace chain {
 
+namespace {
+   /**
+    *  Reads blocks [first, last] from the block database and decodes and hashes them on worker threads, keeping
+    *  up to a fixed window of blocks ready ahead of the one being applied.
+    */
+   class replay_pipeline
+   {
+      public:
+         replay_pipeline( const block_database& blocks, const chain_id_type& chain_id, uint32_t first, uint32_t last )
+            : _blocks( blocks ), _chain_id( chain_id ), _next( first ), _last( last )
+         {
+            const size_t num_threads = std::max( 1u, std::thread::hardware_concurrency() );
+            for( size_t i = 0; i < num_threads; ++i )
+               _threads.emplace_back( new fc::thread( "replay " + fc::to_string( uint64_t(i) ) ) );
+            fill();
+         }
+
+         ~replay_pipeline()
+         {
+            for( auto& f : _pending )
+            {
+               try {
+                  f.wait();
+               } catch( ... ) {}
+            }
+            for( auto& t : _threads )
+               t->quit();
+         }
+
+         /** @return the next block, or nullptr if it is not in the block database */
+         std::shared_ptr<replay_block> next()
+         {
+            if( _pending.empty() )
+               return nullptr;
+            auto result = _pending.front().wait();
+            _pending.pop_front();
+            fill();
+            return result;
+         }
+
+      private:
+         /** number of blocks decoded ahead of the one being applied */
+         static const size_t window = 1024;
+
+         void fill()
+         {
+            while( _next <= _last && _pending.size() < window )
+            {
+               const uint32_t block_num = _next++;
+               const block_database& blocks = _blocks;
+               const chain_id_type& chain_id = _chain_id;
+               _pending.push_back( _threads[block_num % _threads.size()]->async( [&blocks,&chain_id,block_num]() {
+                  return decode( blocks, chain_id, block_num );
+               }, "replay decode" ) );
+            }
+         }
+
+         static std::shared_ptr<replay_block> decode( const block_database& blocks, const chain_id_type& chain_id,
+                                                      uint32_t block_num )
+         {
+            fc::optional< signed_block > block = blocks.fetch_by_number( block_num );
+            if( !block.valid() )
+               return nullptr;
+            auto result = std::make_shared<replay_block>();
+            result->block = std::move( *block );
+            result->block.cache_digests( chain_id );
+            result->merkle_root = result->block.calculate_merkle_root();
+            return result;
+         }
+
+         const block_database&                                _blocks;
+         const chain_id_type                                  _chain_id;
+         uint32_t                                             _next;
+         const uint32_t                                       _last;
+         vector< std::unique_ptr<fc::thread> >                _threads;
+         std::deque< fc::future< std::shared_ptr<replay_block> > > _pending;
+   };
+
+   double blocks_per_second( uint32_t blocks, const fc::microseconds& elapsed )
+   {
+      return elapsed.count() > 0 ? double( blocks ) * 1000000.0 / elapsed.count() : 0.0;
+   }
+}
+
 database::database()
 {
    initialize_indexes();
@@ -44,6 +131,8 @@ database::database()
 database::~database()
 {
    clear_pending();
+   for( auto& t : _signature_threads )
+      t->quit();
 }
 
 void database::reindex( fc::path data_dir )
@@ -70,17 +159,29 @@ void database::reindex( fc::path data_dir )
    }
    else
       _undo_db.disable();
-   for( uint32_t i = head_block_num() + 1; i <= last_block_num; ++i )
+   const uint32_t first_block_num = head_block_num() + 1;
+   replay_pipeline pipeline( _block_id_to_block, get_chain_id(), first_block_num, last_block_num );
+   auto report_time = start;
+   uint32_t report_block_num = first_block_num;
+   uint32_t i = first_block_num;
+   for( ; i <= last_block_num; ++i )
    {
-      if( i % 10000 == 0 ) std::cerr << "   " << double(i*100)/last_block_num << "%   "<<i << " of " <<last_block_num<<"   \n";
+      if( i % 10000 == 0 )
+      {
+         const auto now = fc::time_point::now();
+         std::cerr << "   " << double(i*100)/last_block_num << "%   "<<i << " of " <<last_block_num
+                   << "   " << blocks_per_second( i - report_block_num, now - report_time ) << " blocks/s   \n";
+         report_time = now;
+         report_block_num = i;
+      }
       if( i == flush_point )
       {
          ilog( "Writing database to disk at block ${i}", ("i",i) );
          flush();
          ilog( "Done" );
       }
-      fc::optional< signed_block > block = _block_id_to_block.fetch_by_number(i);
-      if( !block.valid() )
+      std::shared_ptr<replay_block> block = pipeline.next();
+      if( !block )
       {
          wlog( "Reindexing terminated due to gap:  Block ${i} does not exist!", ("i", i) );
          uint32_t dropped_count = 0;
@@ -99,27 +200,39 @@ void database::reindex( fc::path data_dir )
          wlog( "Dropped ${n} blocks from after the gap", ("n", dropped_count) );
          break;
       }
-      if( i < undo_point )
-         apply_block(*block, skip_witness_signature |
-                             skip_transaction_signatures |
-                             skip_transaction_dupe_check |
-                             skip_tapos_check |
-                             skip_witness_schedule_check |
-                             skip_authority_check);
-      else
+      write_lock lock( *this );
+      _replay_block = block.get();
+      try
+      {
+         if( i < undo_point )
+            apply_block(block->block, skip_witness_signature |
+                                      skip_transaction_signatures |
+                                      skip_transaction_dupe_check |
+                                      skip_tapos_check |
+                                      skip_witness_schedule_check |
+                                      skip_authority_check);
+         else
+         {
+            _undo_db.enable();
+            push_block(block->block, skip_witness_signature |
+                                     skip_transaction_signatures |
+                                     skip_transaction_dupe_check |
+                                     skip_tapos_check |
+                                     skip_witness_schedule_check |
+                                     skip_authority_check);
+         }
+      }
+      catch( ... )
       {
-         _undo_db.enable();
-         push_block(*block, skip_witness_signature |
-                            skip_transaction_signatures |
-                            skip_transaction_dupe_check |
-                            skip_tapos_check |
-                            skip_witness_schedule_check |
-                            skip_authority_check);
+         _replay_block = nullptr;
+         throw;
       }
+      _replay_block = nullptr;
    }
    _undo_db.enable();
    auto end = fc::time_point::now();
-   ilog( "Done reindexing, elapsed time: ${t} sec", ("t",double((end-start).count())/1000000.0 ) );
+   ilog( "Done reindexing, elapsed time: ${t} sec, ${r} blocks/s",
+         ("t",double((end-start).count())/1000000.0 )("r",blocks_per_second( i - first_block_num, end - start )) );
 } FC_CAPTURE_AND_RETHROW( (data_dir) ) }
 
 void database::wipe(const fc::path& data_dir, bool include_blocks)
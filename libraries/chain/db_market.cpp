@@ -160,16 +160,21 @@ bool database::apply_order(const limit_order_object& new_order_object, bool allo
 {
    auto order_id = new_order_object.id;
 
-   const auto& limit_price_idx = get_index_type<limit_order_index>().indices().get<by_price>();
+   // is_match_possible() only pairs orders whose request_id and user_id are equal (or both unset), so only the
+   // by_request range sharing the new order's tag needs to be visited.  It is ordered like by_price within
+   // the tag, which keeps the matching order unchanged.
+   const auto& limit_request_idx = get_index_type<limit_order_index>().indices().get<by_request>();
 
    // TODO: it should be possible to simply check the NEXT/PREV iterator after new_order_object to
    // determine whether or not this order has "changed the book" in a way that requires us to
    // check orders. For now I just lookup the lower bound and check for equality... this is log(n) vs
    // constant time check. Potential optimization.
 
+   const auto request_id = new_order_object.request_id;
+   const auto user_id = new_order_object.user_id;
    auto max_price = ~new_order_object.sell_price;
-   auto limit_itr = limit_price_idx.lower_bound(max_price.max());
-   auto limit_end = limit_price_idx.upper_bound(max_price);
+   auto limit_itr = limit_request_idx.lower_bound(boost::make_tuple(request_id, user_id, max_price.max()));
+   auto limit_end = limit_request_idx.upper_bound(boost::make_tuple(request_id, user_id, max_price));
 
    bool finished = false;
    while( !finished && limit_itr != limit_end )
@@ -242,13 +247,13 @@ int database::match( const limit_order_object& usd, const OrderType& core, const
    usd_info.order = usd.id;
    usd_info.request_id = usd.request_id;
    usd_info.user_id = usd.user_id;
-   usd_info.p_memo = usd.p_memo;
+   usd_info.p_memo = usd.p_memo.as_optional();
 
    core_info.account = core.seller;
    core_info.order = core.id;
    core_info.request_id = core.request_id;
    core_info.user_id = core.user_id;
-   core_info.p_memo = core.p_memo;
+   core_info.p_memo = core.p_memo.as_optional();
 
    int result = 0;
    result |= fill_order( usd, usd_pays, usd_receives, false, match_price, false, &core_info ); // although this function is a template,
@@ -173,7 +173,8 @@ static void transaction_get_impacted_accounts( const transaction& tx, flat_set<a
     operation_get_impacted_accounts( op, result );
 }
 
-static void get_relevant_accounts( const object* obj, flat_set<account_id_type>& accounts )
+static void get_relevant_accounts( const object* obj, flat_set<account_id_type>& accounts,
+                                   const recent_transaction_cache& recent_transactions )
 {
    if( obj->id.space() == protocol_ids )
    {
@@ -267,7 +268,10 @@ static void get_relevant_accounts( const object* obj, flat_set<account_id_type>&
            } case impl_transaction_object_type:{
               const auto& aobj = dynamic_cast<const transaction_object*>(obj);
               assert( aobj != nullptr );
-              transaction_get_impacted_accounts( aobj->trx, accounts );
+              // the dedupe object has no body, accounts are only known while the transaction is still cached
+              auto trx = recent_transactions.find( aobj->trx_id );
+              if( trx )
+                 transaction_get_impacted_accounts( *trx, accounts );
               break;
            } case impl_blinded_balance_object_type:{
               const auto& aobj = dynamic_cast<const blinded_balance_object*>(obj);
@@ -289,7 +293,7 @@ static void get_relevant_accounts( const object* obj, flat_set<account_id_type>&
               break;
       }
    }
-} // end get_relevant_accounts( const object* obj, flat_set<account_id_type>& accounts )
+} // end get_relevant_accounts( const object* obj, flat_set<account_id_type>& accounts, ... )
 
 namespace graphene { namespace chain {
 
@@ -309,7 +313,7 @@ void database::notify_changed_objects()
           new_ids.push_back(item);
           auto obj = find_object(item);
           if(obj != nullptr)
-            get_relevant_accounts(obj, new_accounts_impacted);
+            get_relevant_accounts(obj, new_accounts_impacted, _recent_transactions);
         }
 
         new_objects(new_ids, new_accounts_impacted);
@@ -323,7 +327,7 @@ void database::notify_changed_objects()
         for( const auto& item : head_undo.old_values )
         {
           changed_ids.push_back(item.first);
-          get_relevant_accounts(item.second.get(), changed_accounts_impacted);
+          get_relevant_accounts(item.second.get(), changed_accounts_impacted, _recent_transactions);
         }
 
         changed_objects(changed_ids, changed_accounts_impacted);
@@ -340,7 +344,7 @@ void database::notify_changed_objects()
           removed_ids.emplace_back( item.first );
           auto obj = item.second.get();
           removed.emplace_back( obj );
-          get_relevant_accounts(obj, removed_accounts_impacted);
+          get_relevant_accounts(obj, removed_accounts_impacted, _recent_transactions);
         }
 
         removed_objects(removed_ids, removed, removed_accounts_impacted);
@@ -33,6 +33,7 @@
 #include <graphene/chain/transaction_object.hpp>
 #include <graphene/chain/withdraw_permission_object.hpp>
 #include <graphene/chain/witness_object.hpp>
+#include <graphene/chain/worker_object.hpp>
 
 #include <graphene/chain/protocol/fee_schedule.hpp>
 
@@ -162,10 +163,20 @@ void database::clear_expired_transactions()
    //Transactions must have expired by at least two forking windows in order to be removed.
    auto& transaction_idx = static_cast<transaction_index&>(get_mutable_index(implementation_ids, impl_transaction_object_type));
    const auto& dedupe_index = transaction_idx.indices().get<by_expiration>();
-   while( (!dedupe_index.empty()) && (head_block_time() > dedupe_index.begin()->trx.expiration) )
+   while( (!dedupe_index.empty()) && (head_block_time() > dedupe_index.begin()->expiration) )
       transaction_idx.remove(*dedupe_index.begin());
+   _recent_transactions.remove_expired( head_block_time() );
 } FC_CAPTURE_AND_RETHROW() }
 
+void database::clear_expired_signature_keys()
+{
+   while( !_signature_keys_by_expiration.empty() && head_block_time() > _signature_keys_by_expiration.begin()->first )
+   {
+      _signature_keys.erase( _signature_keys_by_expiration.begin()->second );
+      _signature_keys_by_expiration.erase( _signature_keys_by_expiration.begin() );
+   }
+}
+
 void database::clear_expired_proposals()
 {
    const auto& proposal_expiration_index = get_index_type<proposal_index>().indices().get<by_expiration>();
@@ -229,29 +240,13 @@ void database::clear_expired_orders()
 
 void database::clear_expired_bids()
 { try {
-    const auto& all_objects = get_index_type<bid_index>().indices();
-
-    vector<bid_id_type> to_remove;
-    to_remove.reserve(all_objects.size());
+    // Only bids that no limit order refers to anymore are kept in the expiry index, so every bid visited here is removed.
+    const auto& bid_idx = static_cast<const primary_index<bid_index>&>( get_index_type<bid_index>() );
+    const auto& expiring = bid_idx.get_secondary_index< expiry_index<bid_object> >().unreferenced;
 
-    auto& bid_idx = all_objects.get<by_expiration>();
-    for( auto it = bid_idx.begin(); it != bid_idx.end(); ++it )
+    while( !expiring.empty() && expiring.begin()->first <= head_block_time() )
     {
-      if( it->expiration > head_block_time() )
-        break;
-
-      int orders_num = get_index_type<limit_order_index>().indices().get<by_bid>().count(it->id);
-
-      if( 0 == orders_num){
-        to_remove.push_back( it->id);
-      }
-    }
-
-    for( const auto id: to_remove ){
-      auto itr = all_objects.get<by_id>().find(id);
-
-      if( itr != all_objects.get<by_id>().end()){
-        const bid_object& bid = *itr;
+        const bid_object& bid = expiring.begin()->second(*this);
 
         bid_expired_operation canceler;
         canceler.fee_paying_account = bid.owner;
@@ -264,35 +259,18 @@ void database::clear_expired_bids()
 
         push_applied_operation( canceler );
         remove( bid);
-      }
     }
 } FC_CAPTURE_AND_RETHROW() }
 
 void database::clear_expired_bid_requests()
 { try {
-    const auto& all_objects = get_index_type<bid_request_index>().indices();
-
-    vector<bid_request_id_type> to_remove;
-    to_remove.reserve(all_objects.size());
+    // Only bid requests that no bid refers to anymore are kept in the expiry index, so every request visited here is removed.
+    const auto& bid_request_idx = static_cast<const primary_index<bid_request_index>&>( get_index_type<bid_request_index>() );
+    const auto& expiring = bid_request_idx.get_secondary_index< expiry_index<bid_request_object> >().unreferenced;
 
-    auto& bid_request_idx = all_objects.get<by_expiration>();
-    for( auto it = bid_request_idx.begin(); it != bid_request_idx.end(); ++it )
+    while( !expiring.empty() && expiring.begin()->first <= head_block_time() )
     {
-      if( it->expiration > head_block_time() )
-        break;
-
-      int bids_num = get_index_type<bid_index>().indices().get<by_request>().count( it->id);
-
-      if( 0 == bids_num){
-        to_remove.push_back( it->id);
-      }
-    }
-
-    for( const auto id: to_remove ){
-      auto itr = all_objects.get<by_id>().find(id);
-
-      if( itr != all_objects.get<by_id>().end()){
-        const bid_request_object& bid_request = *itr;
+        const bid_request_object& bid_request = expiring.begin()->second(*this);
         bid_request_expired_operation canceler;
         canceler.fee_paying_account = bid_request.owner;
         canceler.bid_request_id = bid_request.id;
@@ -304,7 +282,6 @@ void database::clear_expired_bid_requests()
 
         push_applied_operation( canceler );
         remove( bid_request);
-      }
     }
 } FC_CAPTURE_AND_RETHROW() }
 
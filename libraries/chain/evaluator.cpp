@@ -44,9 +44,38 @@ database& generic_evaluator::db()const { return trx_state->db(); }
    { try {
       trx_state   = &eval_state;
       //check_required_authorities(op);
+      chain_profiler& profiler = db().profiler();
+      if( !profiler.enabled() )
+      {
+         auto result = evaluate( op );
+
+         if( apply ) result = this->apply( op );
+         return result;
+      }
+
+      const auto changes_before = db()._undo_db.changes();
+      auto start = fc::time_point::now();
       auto result = evaluate( op );
+      const auto evaluate_time = fc::time_point::now() - start;
+
+      fc::microseconds apply_time;
+      if( apply )
+      {
+         start = fc::time_point::now();
+         result = this->apply( op );
+         apply_time = fc::time_point::now() - start;
+      }
 
-      if( apply ) result = this->apply( op );
+      // fetched only now, as operations applied by this one (e.g. proposals) may resize the profiler's storage
+      operation_profile& stats = profiler.operation_stats( op.which() );
+      const auto& changes_after = db()._undo_db.changes();
+      stats.evaluate.record( evaluate_time );
+      if( apply )
+         stats.apply.record( apply_time );
+      stats.undo_bytes       += changes_after.undo_bytes - changes_before.undo_bytes;
+      stats.objects_created  += changes_after.created - changes_before.created;
+      stats.objects_modified += changes_after.modified - changes_before.modified;
+      stats.objects_removed  += changes_after.removed - changes_before.removed;
       return result;
    } FC_CAPTURE_AND_RETHROW() }
 
@@ -25,6 +25,11 @@
 #include <graphene/chain/protocol/operations.hpp>
 #include <graphene/db/generic_index.hpp>
 #include <boost/multi_index/composite_key.hpp>
+#include <boost/multi_index/ranked_index.hpp>
+#include <boost/multi_index/hashed_index.hpp>
+#include <boost/thread/mutex.hpp>
+
+#include <unordered_map>
 
 namespace graphene { namespace chain {
    class database;
@@ -252,10 +257,21 @@ namespace graphene { namespace chain {
          map< account_id_type, set<account_id_type> > referred_by;
    };
 
+   /** hashes typed object ids by their instance, for hashed indexes on them */
+   struct instance_hash
+   {
+      template<typename IdType>
+      size_t operator()( const IdType& id )const { return std::hash<uint64_t>()( id.instance.value ); }
+   };
+
    struct by_account_asset;
-   struct by_asset_balance;
+   struct by_owner_asset;
+   struct by_asset_account;
    /**
     * @ingroup object_index
+    *
+    * None of the keys contain the balance, so adjusting a balance does not move the object in any of the indexes.
+    * Holders ordered by balance are kept by the asset_holder_index for the assets that need them.
     */
    typedef multi_index_container<
       account_balance_object,
@@ -268,17 +284,19 @@ namespace graphene { namespace chain {
                member<account_balance_object, asset_id_type, &account_balance_object::asset_type>
             >
          >,
-         ordered_unique< tag<by_asset_balance>,
+         hashed_unique< tag<by_owner_asset>,
+            composite_key<
+               account_balance_object,
+               member<account_balance_object, account_id_type, &account_balance_object::owner>,
+               member<account_balance_object, asset_id_type, &account_balance_object::asset_type>
+            >,
+            composite_key_hash< instance_hash, instance_hash >
+         >,
+         ordered_unique< tag<by_asset_account>,
             composite_key<
                account_balance_object,
                member<account_balance_object, asset_id_type, &account_balance_object::asset_type>,
-               member<account_balance_object, share_type, &account_balance_object::balance>,
                member<account_balance_object, account_id_type, &account_balance_object::owner>
-            >,
-            composite_key_compare<
-               std::less< asset_id_type >,
-               std::greater< share_type >,
-               std::less< account_id_type >
             >
          >
       >
@@ -287,7 +305,76 @@ namespace graphene { namespace chain {
    /**
     * @ingroup object_index
     */
-   typedef generic_index<account_balance_object, account_balance_object_multi_index_type> account_balance_index;
+   typedef dense_generic_index<account_balance_object, account_balance_object_multi_index_type> account_balance_index;
+
+   /**
+    *  @brief This secondary index keeps the accounts holding a non-zero balance of an asset, largest balance first,
+    *  so that holder counts and pages of holders at any offset take logarithmic time.
+    *
+    *  Only assets that were asked for are kept, from the first call of holders() on.  Balance changes of those
+    *  assets are noted by owner and only sorted in when the holders are asked for again, so a balance changing
+    *  many times between two queries is moved once.
+    */
+   class asset_holder_index : public secondary_index
+   {
+      public:
+         struct holder
+         {
+            share_type      balance;
+            account_id_type owner;
+         };
+
+         struct by_owner;
+         typedef multi_index_container<
+            holder,
+            indexed_by<
+               ranked_unique<
+                  composite_key<
+                     holder,
+                     member<holder, share_type, &holder::balance>,
+                     member<holder, account_id_type, &holder::owner>
+                  >,
+                  composite_key_compare<
+                     std::greater< share_type >,
+                     std::less< account_id_type >
+                  >
+               >,
+               hashed_unique< tag<by_owner>, member<holder, account_id_type, &holder::owner>, instance_hash >
+            >
+         > holder_set;
+
+         virtual void object_inserted( const object& obj ) override;
+         virtual void object_removed( const object& obj ) override;
+         virtual void object_modified( const object& after  ) override;
+
+         /** the holders of an asset, largest balance first; size(), nth() and rank() are logarithmic */
+         const holder_set& holders( asset_id_type asset )const;
+
+         /** the balances to build the holders of an asset from when it is first asked for */
+         const account_balance_index* balances = nullptr;
+
+      private:
+         void balance_changed( const account_balance_object& b, share_type balance );
+
+         mutable boost::mutex                                                   _mutex;
+         mutable map< asset_id_type, holder_set >                               _holders;
+         /** the latest balance of each owner whose balance changed since the holders were last asked for */
+         mutable map< asset_id_type, std::unordered_map< account_id_type, share_type, instance_hash > > _changed;
+   };
+
+   /**
+    *  @brief Counts the non-zero balances of GRAPHENE_TEMP_ACCOUNT, which must be zero after every transaction.
+    */
+   class temp_account_balance_index : public secondary_index
+   {
+      public:
+         virtual void object_inserted( const object& obj ) override;
+         virtual void object_removed( const object& obj ) override;
+         virtual void about_to_modify( const object& before ) override;
+         virtual void object_modified( const object& after  ) override;
+
+         uint32_t nonzero_balances = 0;
+   };
 
    struct by_name{};
 
@@ -305,7 +392,7 @@ namespace graphene { namespace chain {
    /**
     * @ingroup object_index
     */
-   typedef generic_index<account_object, account_multi_index_type> account_index;
+   typedef dense_generic_index<account_object, account_multi_index_type> account_index;
 
 }}
 
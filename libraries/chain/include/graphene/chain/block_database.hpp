@@ -23,14 +23,39 @@
  */
 #pragma once
 #include <fstream>
+#include <atomic>
+#include <memory>
 #include <graphene/chain/protocol/block.hpp>
 
 namespace graphene { namespace chain {
    class index_entry;
 
+   /**
+    *  A block as it is stored, fc::raw packed.  Views returned by block_database point into the mapping of its
+    *  blocks file and stay valid until block_database::close(); others keep their bytes alive in owner.
+    */
+   struct packed_block_view
+   {
+      const char*                           data = nullptr;
+      uint32_t                              size = 0;
+      std::shared_ptr< const vector<char> > owner;
+   };
+
+   /**
+    *  @brief Append-only store of irreversible (and recent) blocks, indexed by block number
+    *
+    *  The "blocks" file holds the packed blocks back to back, the "index" file holds one fixed-size entry per block
+    *  number pointing into it.  The index is kept in memory and the blocks file is memory mapped, so fetching a
+    *  block costs no system call and no intermediate copy.  Blocks are packed straight into the mapping, the file is
+    *  grown ahead of them and only written back to disk by flush() and close().  Readers take no lock and may run on
+    *  any thread; store(), remove(), flush(), last() and last_id() must be called from a single writer thread.
+    */
    class block_database 
    {
       public:
+         block_database();
+         ~block_database();
+
          void open( const fc::path& dbdir );
          bool is_open()const;
          void flush();
@@ -43,12 +68,40 @@ namespace graphene { namespace chain {
          block_id_type          fetch_block_id( uint32_t block_num )const;
          optional<signed_block> fetch_optional( const block_id_type& id )const;
          optional<signed_block> fetch_by_number( uint32_t block_num )const;
+         /** the block as it is stored, without unpacking its transactions */
+         optional<packed_block_view> fetch_packed_by_number( uint32_t block_num )const;
+         /** the stored blocks from first to last, up to the first one missing */
+         vector<packed_block_view> fetch_packed_range( uint32_t first, uint32_t last )const;
          optional<signed_block> last()const;
          optional<block_id_type> last_id()const;
       private:
+         struct mapped_blocks;
+
          optional<index_entry> last_index_entry()const;
+         bool                  read_entry( uint32_t block_num, index_entry& e )const;
+         void                  write_entry( uint32_t block_num, const index_entry& e )const;
+         optional<signed_block> read_block( const index_entry& e )const;
+         optional<packed_block_view> read_packed_block( const index_entry& e )const;
+         void                  map_blocks( uint64_t min_size );
+         void                  write_index()const;
+         void                  truncate_index( uint32_t size )const;
+
          fc::path _index_filename;
-         mutable std::fstream _blocks;
+         fc::path _blocks_filename;
          mutable std::fstream _block_num_to_pos;
+
+         /** in-memory copy of the index file, allocated in segments so that entries never move */
+         std::unique_ptr< std::atomic<index_entry*>[] > _segments;
+         mutable std::atomic<uint32_t> _index_size;
+         /** odd while an existing entry is being rewritten, readers retry when it changed under them */
+         mutable std::atomic<uint64_t> _index_seq;
+         mutable uint32_t              _dirty_begin = 0;
+         mutable uint32_t              _dirty_end = 0;
+
+         /** mappings of the blocks file; older ones are kept until close() as readers may still use them */
+         std::vector< std::unique_ptr<mapped_blocks> > _mappings;
+         std::atomic<const mapped_blocks*>             _mapping;
+         /** bytes of the blocks file holding blocks, the file itself may be longer while open */
+         std::atomic<uint64_t>                         _blocks_size;
    };
 } }
@@ -0,0 +1,132 @@
+/*
+ * Copyright (c) 2015 Cryptonomex, Inc., and contributors.
+ *
+ * The MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#pragma once
+#include <graphene/chain/protocol/types.hpp>
+
+#include <fc/time.hpp>
+
+namespace graphene { namespace chain {
+
+   /**
+    *  @brief Count, total and distribution of the durations of something measured repeatedly
+    *
+    *  buckets[i] counts the samples that took less than 2^i microseconds (and at least 2^(i-1)), the last bucket
+    *  also counts everything slower.
+    */
+   struct latency_histogram
+   {
+      static const uint32_t num_buckets = 24;
+
+      uint64_t          count    = 0;
+      uint64_t          total_us = 0;
+      uint64_t          max_us   = 0;
+      vector<uint64_t>  buckets;
+
+      void record( const fc::microseconds& elapsed );
+   };
+
+   /** What applying one type of operation cost */
+   struct operation_profile
+   {
+      latency_histogram evaluate;
+      latency_histogram apply;
+      /** serialized size of the objects saved to the undo state */
+      uint64_t          undo_bytes       = 0;
+      uint64_t          objects_created  = 0;
+      uint64_t          objects_modified = 0;
+      uint64_t          objects_removed  = 0;
+   };
+
+   /** Where the time applying a block went, by phase of database::_apply_block() */
+   struct block_profile
+   {
+      latency_histogram total;
+      latency_histogram transactions;
+      /** global properties, signing witness and last irreversible block */
+      latency_histogram block_updates;
+      /** only recorded for blocks that start a maintenance interval */
+      latency_histogram maintenance;
+      /** block summary, clear_expired_* and withdraw permission updates */
+      latency_histogram clear_expired;
+      latency_histogram witness_schedule;
+      /** the applied_block signal, i.e. plugins */
+      latency_histogram applied_block;
+      latency_histogram notify_changed_objects;
+   };
+
+   /** Everything the chain_profiler measured since it was last reset */
+   struct chain_profile
+   {
+      bool                                enabled = false;
+      fc::time_point                      since;
+      uint32_t                            first_block_num = 0;
+      uint32_t                            last_block_num  = 0;
+      /** indexed by operation name */
+      flat_map<string, operation_profile> operations;
+      block_profile                       blocks;
+   };
+
+   /**
+    *  @brief Optional instrumentation of block and operation processing
+    *
+    *  When disabled (the default) the database only pays a branch per operation and per block phase.
+    */
+   class chain_profiler
+   {
+      public:
+         bool enabled()const { return _enabled; }
+         void enable( bool e );
+         void reset();
+
+         /** @return the current time when enabled, which is passed to lap() afterwards */
+         fc::time_point now()const { return _enabled ? fc::time_point::now() : fc::time_point(); }
+
+         /** Records the time since start in the given phase of the block being applied and returns the current time */
+         fc::time_point lap( latency_histogram block_profile::* phase, const fc::time_point& start );
+         void           record_block( uint32_t block_num, const fc::time_point& start );
+
+         operation_profile& operation_stats( int which );
+
+         chain_profile report()const;
+
+      private:
+         bool                       _enabled = false;
+         fc::time_point             _since;
+         uint32_t                   _first_block_num = 0;
+         uint32_t                   _last_block_num  = 0;
+         /** indexed by operation::which() */
+         vector<operation_profile>  _operations;
+         block_profile              _blocks;
+   };
+
+} } // graphene::chain
+
+FC_REFLECT( graphene::chain::latency_histogram, (count)(total_us)(max_us)(buckets) )
+FC_REFLECT( graphene::chain::operation_profile,
+            (evaluate)(apply)(undo_bytes)(objects_created)(objects_modified)(objects_removed) )
+FC_REFLECT( graphene::chain::block_profile,
+            (total)(transactions)(block_updates)(maintenance)(clear_expired)(witness_schedule)(applied_block)
+            (notify_changed_objects) )
+FC_REFLECT( graphene::chain::chain_profile,
+            (enabled)(since)(first_block_num)(last_block_num)(operations)(blocks) )
@@ -28,6 +28,8 @@
 #include <graphene/chain/asset_object.hpp>
 #include <graphene/chain/fork_database.hpp>
 #include <graphene/chain/block_database.hpp>
+#include <graphene/chain/chain_profiler.hpp>
+#include <graphene/chain/transaction_cache.hpp>
 #include <graphene/chain/genesis_state.hpp>
 #include <graphene/chain/evaluator.hpp>
 
@@ -35,13 +37,20 @@
 #include <graphene/db/object.hpp>
 #include <graphene/db/simple_index.hpp>
 #include <fc/signals.hpp>
+#include <fc/thread/mutex.hpp>
 
 #include <graphene/chain/protocol/protocol.hpp>
 
 #include <fc/log/logger.hpp>
 
+#include <boost/thread/locks.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/shared_mutex.hpp>
+
 #include <map>
 
+namespace fc { class thread; }
+
 namespace graphene { namespace chain {
    using graphene::db::abstract_object;
    using graphene::db::object;
@@ -50,6 +59,18 @@ namespace graphene { namespace chain {
 
    struct budget_record;
 
+   /**
+    *  @brief A block read back from the block database during replay, with the hashes apply_block() needs
+    *
+    *  These are computed on the replay worker threads so that the applying thread only runs state transitions.  The
+    *  block id and transaction digests are kept in the block itself, see signed_block::cache_digests().
+    */
+   struct replay_block
+   {
+      signed_block                 block;
+      checksum_type                merkle_root;
+   };
+
    /**
     *   @class database
     *   @brief tracks the blockchain state in an extensible manner
@@ -124,7 +145,11 @@ namespace graphene { namespace chain {
          block_id_type              get_block_id_for_num( uint32_t block_num )const;
          optional<signed_block>     fetch_block_by_id( const block_id_type& id )const;
          optional<signed_block>     fetch_block_by_number( uint32_t num )const;
-         const signed_transaction&  get_recent_transaction( const transaction_id_type& trx_id )const;
+         /** the fc::raw packed block, read in place from the block store once the block is irreversible */
+         optional<packed_block_view> fetch_packed_block_by_number( uint32_t num )const;
+         /** @throws fc::exception if the transaction is not, or no longer, in the recent_transaction_cache */
+         std::shared_ptr<const signed_transaction> get_recent_transaction( const transaction_id_type& trx_id )const;
+         recent_transaction_cache&  recent_transactions() { return _recent_transactions; }
          std::vector<block_id_type> get_block_ids_on_fork(block_id_type head_of_fork) const;
 
          /**
@@ -145,6 +170,46 @@ namespace graphene { namespace chain {
          ///@throws fc::exception if the proposed transaction fails to apply.
          processed_transaction push_proposal( const proposal_object& proposal );
 
+         /**
+          *  Recovers the public keys of the signatures of the given transactions on a pool of worker threads, and
+          *  caches them until the transactions expire.  Applying these transactions afterwards then checks their
+          *  authorities without any key recovery on the calling thread.  push_block() does this for the block's
+          *  transactions unless signature checks are skipped.
+          */
+         void precompute_signature_keys( const vector<processed_transaction>& trxs );
+
+         /**
+          *  @brief Exclusive side of the chain state lock, see lock_for_reading()
+          *
+          *  Taken on the chain thread around every change to the state.  It is re-entrant on the fc task holding
+          *  it, so nested pushes (e.g. the pending transactions re-pushed by push_block()) only lock once.  Another
+          *  task of the same thread, which may run while the holder waits inside a push, yields until the holder is
+          *  done instead of changing the half-applied state.  A thread holding lock_for_reading() must not take
+          *  it, it would wait for itself, and neither may a task the holder waits for.
+          */
+         class write_lock
+         {
+            public:
+               explicit write_lock( database& db );
+               ~write_lock();
+               write_lock( const write_lock& ) = delete;
+               write_lock& operator = ( const write_lock& ) = delete;
+            private:
+               database& _db;
+         };
+
+         /**
+          *  Lets threads other than the chain thread read the state consistently: while the returned lock is held
+          *  no block or transaction is being pushed, generated or popped.  Waiting writers take precedence over new
+          *  readers, so a stream of reads cannot hold off block application.
+          */
+         boost::shared_lock<boost::shared_mutex> lock_for_reading()const;
+
+         /// Per operation type and per block phase timings, only collected after enable_profiling( true )
+         chain_profiler&       profiler()      { return _profiler; }
+         const chain_profiler& profiler()const { return _profiler; }
+         void                  enable_profiling( bool enable );
+
          signed_block generate_block(
             const fc::time_point_sec when,
             witness_id_type witness_id,
@@ -302,6 +367,18 @@ namespace graphene { namespace chain {
           */
          void adjust_balance(account_id_type account, asset delta);
 
+         /**
+          * @brief Credit a fee to GRAPHENE_UMT_FEE_POOL_ACCOUNT
+          *
+          * The credits are summed per asset and written to the fee pool's balances once per block while a block
+          * is applied, and once per transaction otherwise, instead of modifying the same balance object for every
+          * fee.  get_balance() and adjust_balance() on the fee pool account see the pending credits.
+          */
+         void credit_fee_pool( const asset& fee );
+
+         /// Credit the fee pool on every fee instead of once per block, for comparing the resulting states
+         void enable_fee_pool_accumulation( bool enable ) { _accumulate_fee_pool = enable; }
+
          /**
           * @brief Helper to make lazy deposit to CDD VBO.
           *
@@ -421,12 +498,19 @@ namespace graphene { namespace chain {
          const witness_object& validate_block_header( uint32_t skip, const signed_block& next_block )const;
          const witness_object& _validate_block_header( const signed_block& next_block )const;
          void create_block_summary(const signed_block& next_block);
+         /** the cached keys of the transaction, or the keys recovered from its signatures, then recovered is set */
+         flat_set<public_key_type> signature_keys_of( const signed_transaction& trx, const transaction_id_type& trx_id,
+                                                      bool& recovered )const;
+         /** caches the keys recovered from a transaction that passed its checks */
+         void cache_signature_keys( const signed_transaction& trx, const transaction_id_type& trx_id,
+                                    flat_set<public_key_type> keys );
 
          //////////////////// db_update.cpp ////////////////////
          void update_global_dynamic_data( const signed_block& b );
          void update_signing_witness(const witness_object& signing_witness, const signed_block& new_block);
          void update_last_irreversible_block();
          void clear_expired_transactions();
+         void clear_expired_signature_keys();
          void clear_expired_proposals();
          void clear_expired_orders();
          void clear_expired_bids();
@@ -472,6 +556,14 @@ namespace graphene { namespace chain {
           */
          vector<optional<operation_history_object> >  _applied_ops;
 
+         /// writes the sums kept by credit_fee_pool() to the fee pool's balances
+         void flush_fee_pool();
+
+         flat_map<asset_id_type,share_type> _pending_fee_pool;
+         bool                              _accumulate_fee_pool = true;
+         /// set while _apply_block() runs, so that fee pool credits are written once per block
+         bool                              _applying_block = false;
+
          uint32_t                          _current_block_num    = 0;
          uint16_t                          _current_trx_in_block = 0;
          uint16_t                          _current_op_in_trx    = 0;
@@ -484,7 +576,34 @@ namespace graphene { namespace chain {
 
          flat_map<uint32_t,block_id_type>  _checkpoints;
 
+         /** hashes of the block being applied, set by reindex() while it applies a block from its pipeline */
+         const replay_block*               _replay_block = nullptr;
+
+         /** signing keys recovered from a transaction's signatures, see precompute_signature_keys() */
+         struct signature_keys
+         {
+            vector<signature_type>         signatures;
+            flat_set<public_key_type>      keys;
+            fc::time_point_sec             expiration;
+         };
+         std::map<transaction_id_type, signature_keys>               _signature_keys;
+         std::multimap<fc::time_point_sec, transaction_id_type>      _signature_keys_by_expiration;
+         vector< std::unique_ptr<fc::thread> >                        _signature_threads;
+
+         recent_transaction_cache          _recent_transactions;
+
+         /** set by initialize_indexes() */
+         const temp_account_balance_index* _temp_account_balances = nullptr;
+
          node_property_object              _node_property_object;
+
+         chain_profiler                    _profiler;
+
+         mutable boost::shared_mutex       _state_mutex;
+         /** held by a writer while it waits for and holds _state_mutex, new readers queue behind it */
+         mutable boost::mutex              _writer_gate;
+         /** taken by write_lock before the two above, writers waiting on it yield rather than block their thread */
+         fc::mutex                         _writer_mutex;
    };
 
    namespace detail
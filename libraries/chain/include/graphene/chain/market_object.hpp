@@ -26,6 +26,7 @@
 #include <graphene/chain/protocol/asset.hpp>
 #include <graphene/chain/protocol/types.hpp>
 #include <graphene/chain/protocol/memo.hpp>
+#include <graphene/db/cold_optional.hpp>
 #include <graphene/db/generic_index.hpp>
 #include <graphene/db/object.hpp>
 
@@ -49,6 +50,7 @@ class limit_order_object : public abstract_object<limit_order_object>
       static const uint8_t space_id = protocol_ids;
       static const uint8_t type_id  = limit_order_object_type;
 
+      // what matching and expiring the order reads, kept together at the front of the object
       time_point_sec   expiration;
       account_id_type  seller;
       share_type       for_sale; ///< asset id is sell_price.base.asset_id
@@ -60,8 +62,10 @@ class limit_order_object : public abstract_object<limit_order_object>
       optional< uint64_t > user_id;
       optional< account_id_type > counterparty_id;
       optional< bid_id_type > bid_id;
-      optional< memo_data > p_memo;          //private encoded memo
-      optional< memo_data > p_accepted_memo; //private encoded memo
+
+      // the memos are only copied into operations, so they live out of line and copies of the order share them
+      cold_optional< memo_data > p_memo;          //private encoded memo
+      cold_optional< memo_data > p_accepted_memo; //private encoded memo
 
       pair<asset_id_type,asset_id_type> get_market()const
       {
@@ -80,6 +84,7 @@ struct by_expiration;
 struct by_account;
 struct by_bid;
 struct by_counterparty;
+struct by_request;
 
 typedef multi_index_container<
    limit_order_object,
@@ -115,11 +120,26 @@ typedef multi_index_container<
             member<limit_order_object, optional< bid_id_type >, &limit_order_object::bid_id>,
             member<object, object_id_type, &object::id>
          >
+      >,
+      /**
+       * Orders grouped by their telecom tag, then in the same price/time priority as by_price.  Within a single
+       * (request_id, user_id) pair the price component also pins down the market, so matching a tagged order
+       * only visits the few orders that carry the same tag.
+       */
+      ordered_unique< tag<by_request>,
+         composite_key< limit_order_object,
+            member<limit_order_object, optional< uint64_t >, &limit_order_object::request_id>,
+            member<limit_order_object, optional< uint64_t >, &limit_order_object::user_id>,
+            member<limit_order_object, price, &limit_order_object::sell_price>,
+            member<object, object_id_type, &object::id>
+         >,
+         composite_key_compare< std::less< optional< uint64_t > >, std::less< optional< uint64_t > >,
+                                std::greater<price>, std::less<object_id_type> >
       >
    >
 > limit_order_multi_index_type;
 
-typedef generic_index<limit_order_object, limit_order_multi_index_type> limit_order_index;
+typedef dense_generic_index<limit_order_object, limit_order_multi_index_type> limit_order_index;
 
 } } // graphene::chain
 
@@ -94,6 +94,7 @@ namespace graphene { namespace chain {
          operation_history_id_type            operation_id;
          uint32_t                             sequence = 0; /// the operation position within the given account
          account_transaction_history_id_type  next;
+         uint16_t                             op_type = 0; /// operation::which() of the referenced operation, filters history without loading it
 
          //std::pair<account_id_type,operation_history_id_type>  account_op()const  { return std::tie( account, operation_id ); }
          //std::pair<account_id_type,uint32_t>                   account_seq()const { return std::tie( account, sequence );     }
@@ -108,11 +109,12 @@ namespace graphene { namespace chain {
       >
    > operation_history_multi_index_type;
 
-   typedef generic_index<operation_history_object, operation_history_multi_index_type> operation_history_index;
+   typedef dense_generic_index<operation_history_object, operation_history_multi_index_type> operation_history_index;
 
    struct by_seq;
    struct by_op;
    struct by_opid;
+   struct by_op_type;
 
    typedef multi_index_container<
       account_transaction_history_object,
@@ -132,11 +134,18 @@ namespace graphene { namespace chain {
          >,
          ordered_non_unique< tag<by_opid>,
             member< account_transaction_history_object, operation_history_id_type, &account_transaction_history_object::operation_id>
+         >,
+         ordered_unique< tag<by_op_type>,
+            composite_key< account_transaction_history_object,
+               member< account_transaction_history_object, account_id_type, &account_transaction_history_object::account>,
+               member< account_transaction_history_object, uint16_t, &account_transaction_history_object::op_type>,
+               member< account_transaction_history_object, uint32_t, &account_transaction_history_object::sequence>
+            >
          >
       >
    > account_transaction_history_multi_index_type;
 
-   typedef generic_index<account_transaction_history_object, account_transaction_history_multi_index_type> account_transaction_history_index;
+   typedef dense_generic_index<account_transaction_history_object, account_transaction_history_multi_index_type> account_transaction_history_index;
 
 
 } } // graphene::chain
@@ -145,4 +154,4 @@ FC_REFLECT_DERIVED( graphene::chain::operation_history_object, (graphene::chain:
                     (op)(result)(block_num)(trx_in_block)(op_in_trx)(virtual_op) )
 
 FC_REFLECT_DERIVED( graphene::chain::account_transaction_history_object, (graphene::chain::object),
-                    (account)(operation_id)(sequence)(next) )
+                    (account)(operation_id)(sequence)(next)(op_type) )
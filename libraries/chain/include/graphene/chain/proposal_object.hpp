@@ -86,7 +86,7 @@ typedef boost::multi_index_container<
       ordered_non_unique< tag< by_expiration >, member< proposal_object, time_point_sec, &proposal_object::expiration_time > >
    >
 > proposal_multi_index_container;
-typedef generic_index<proposal_object, proposal_multi_index_container> proposal_index;
+typedef dense_generic_index<proposal_object, proposal_multi_index_container> proposal_index;
 
 } } // graphene::chain
 
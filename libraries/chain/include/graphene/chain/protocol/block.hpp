@@ -46,12 +46,26 @@ namespace graphene { namespace chain {
       void                       sign( const fc::ecc::private_key& signer );
       bool                       validate_signee( const fc::ecc::public_key& expected_signee )const;
 
+      /// Keeps id(), see transaction::cache_digests(); sign() drops it
+      void                       cache_id()const;
+
       signature_type             witness_signature;
+
+   private:
+      mutable detail::cached_value<block_id_type> _id;
    };
 
    struct signed_block : public signed_block_header
    {
       checksum_type calculate_merkle_root()const;
+
+      /**
+       *  Keeps the block id and the digests of every transaction, so that applying, relaying and indexing the block
+       *  hash each of them once.  Call it on a block that has been deserialized or generated, see
+       *  transaction::cache_digests() for the rules.
+       */
+      void cache_digests( const chain_id_type& chain_id )const;
+
       vector<processed_transaction> transactions;
    };
 
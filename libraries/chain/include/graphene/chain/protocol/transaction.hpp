@@ -59,6 +59,32 @@ namespace graphene { namespace chain {
     * @{
     */
 
+   namespace detail {
+      /**
+       *  A value derived from the fields of the object holding it.  Copies of that object may be changed through
+       *  their fields, so copying leaves the value unset; moving carries it over.
+       */
+      template<typename T>
+      struct cached_value
+      {
+         cached_value() = default;
+         cached_value( const cached_value& ) {}
+         cached_value( cached_value&& other ) : value( other.value ), valid( other.valid ) { other.valid = false; }
+
+         cached_value& operator = ( const cached_value& ) { valid = false; return *this; }
+         cached_value& operator = ( cached_value&& other )
+         {
+            value = other.value;
+            valid = other.valid;
+            other.valid = false;
+            return *this;
+         }
+
+         T    value;
+         bool valid = false;
+      };
+   }
+
    /**
     *  @brief groups operations that should be applied atomically
     */
@@ -91,6 +117,15 @@ namespace graphene { namespace chain {
       /// Calculate the digest used for signature validation
       digest_type         sig_digest( const chain_id_type& chain_id )const;
 
+      /**
+       *  Keeps digest(), id() and sig_digest( chain_id ) so that later calls return them without packing and hashing
+       *  the transaction again.  Call it once the transaction is final, i.e. when it has been deserialized or
+       *  created.  The mutating members of this class drop the kept values, but assigning to the fields does not,
+       *  so a transaction must not be modified through its fields after this has been called.  Copies start
+       *  without the kept values and may be modified freely.
+       */
+      void cache_digests( const chain_id_type& chain_id )const;
+
       void set_expiration( fc::time_point_sec expiration_time );
       void set_reference_block( const block_id_type& reference_block );
 
@@ -98,6 +133,7 @@ namespace graphene { namespace chain {
       template<typename Visitor>
       vector<typename Visitor::result_type> visit( Visitor&& visitor )
       {
+         invalidate_digests();
          vector<typename Visitor::result_type> results;
          for( auto& op : operations )
             results.push_back(op.visit( std::forward<Visitor>( visitor ) ));
@@ -113,6 +149,14 @@ namespace graphene { namespace chain {
       }
 
       void get_required_authorities( flat_set<account_id_type>& active, flat_set<account_id_type>& owner, vector<authority>& other )const;
+
+   protected:
+      void invalidate_digests() { _digest.valid = _sig_digest.valid = false; }
+
+   private:
+      /// set by cache_digests(), not serialized
+      mutable detail::cached_value<digest_type>                          _digest;
+      mutable detail::cached_value<std::pair<chain_id_type,digest_type>> _sig_digest;
    };
 
    /**
@@ -170,7 +214,7 @@ namespace graphene { namespace chain {
       vector<signature_type> signatures;
 
       /// Removes all operations and signatures
-      void clear() { operations.clear(); signatures.clear(); }
+      void clear() { operations.clear(); signatures.clear(); invalidate_digests(); }
    };
 
    void verify_authority( const vector<operation>& ops, const flat_set<public_key_type>& sigs,
@@ -202,6 +246,12 @@ namespace graphene { namespace chain {
       vector<operation_result> operation_results;
 
       digest_type merkle_digest()const;
+
+      /// Also keeps merkle_digest(), which covers the signatures and operation_results as well
+      void cache_digests( const chain_id_type& chain_id )const;
+
+   private:
+      mutable detail::cached_value<digest_type> _merkle_digest;
    };
 
    /// @} transactions group
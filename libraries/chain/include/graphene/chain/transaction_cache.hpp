@@ -0,0 +1,95 @@
+/*
+ * Copyright (c) 2015 Cryptonomex, Inc., and contributors.
+ *
+ * The MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#pragma once
+#include <graphene/chain/protocol/transaction.hpp>
+
+#include <boost/multi_index_container.hpp>
+#include <boost/multi_index/member.hpp>
+#include <boost/multi_index/ordered_index.hpp>
+#include <boost/multi_index/hashed_index.hpp>
+#include <boost/multi_index/sequenced_index.hpp>
+#include <boost/thread/mutex.hpp>
+
+#include <memory>
+
+namespace graphene { namespace chain {
+
+   /**
+    *  @brief Bodies of the transactions recently applied, for get_recent_transaction() and the p2p layer
+    *
+    *  The deduplication index only keeps ids and expirations, the transactions themselves are kept here.  This is
+    *  not part of the chain state: nothing here is undone when a block is popped, and entries are dropped when
+    *  their transaction expires or, oldest first, when the cache grows beyond its size limit.  Lookups hand out a
+    *  shared reference, so a transaction being served stays valid after it is dropped.
+    */
+   class recent_transaction_cache
+   {
+      public:
+         explicit recent_transaction_cache( uint64_t max_bytes = 64 * 1024 * 1024 );
+
+         /** Limits the serialized size of the cached transactions, 0 disables the cache */
+         void set_max_bytes( uint64_t max_bytes );
+         uint64_t max_bytes()const { return _max_bytes; }
+
+         void add( const transaction_id_type& id, const signed_transaction& trx );
+         std::shared_ptr<const signed_transaction> find( const transaction_id_type& id )const;
+
+         /** Drops the transactions that expired before now */
+         void remove_expired( fc::time_point_sec now );
+         void clear();
+
+         uint64_t size()const;
+         uint64_t size_bytes()const;
+
+      private:
+         struct entry
+         {
+            transaction_id_type                        id;
+            fc::time_point_sec                         expiration;
+            uint64_t                                   bytes = 0;
+            std::shared_ptr<const signed_transaction>  trx;
+         };
+
+         struct by_trx_id;
+         struct by_expiration;
+         typedef boost::multi_index_container<
+            entry,
+            boost::multi_index::indexed_by<
+               boost::multi_index::sequenced<>,
+               boost::multi_index::hashed_unique< boost::multi_index::tag<by_trx_id>,
+                  BOOST_MULTI_INDEX_MEMBER( entry, transaction_id_type, id ), std::hash<transaction_id_type> >,
+               boost::multi_index::ordered_non_unique< boost::multi_index::tag<by_expiration>,
+                  BOOST_MULTI_INDEX_MEMBER( entry, fc::time_point_sec, expiration ) >
+            >
+         > entry_index;
+
+         void shrink_to( uint64_t max_bytes );
+
+         mutable boost::mutex  _mutex;
+         entry_index           _entries;
+         uint64_t              _max_bytes;
+         uint64_t              _bytes = 0;
+   };
+
+} }
@@ -93,7 +93,7 @@ namespace graphene { namespace chain {
           >,
           ordered_non_unique<tag<by_owner>, member<bid_request_object, account_id_type, &bid_request_object::owner>>
       >> bid_request_object_multi_index_type;
-  typedef generic_index<bid_request_object, bid_request_object_multi_index_type> bid_request_index;
+  typedef dense_generic_index<bid_request_object, bid_request_object_multi_index_type> bid_request_index;
 
   class bid_object : public abstract_object<bid_object>
   {
@@ -136,7 +136,130 @@ namespace graphene { namespace chain {
           >,
           ordered_non_unique<tag<by_owner>, member<bid_object, account_id_type, &bid_object::owner>>
       >> bid_object_multi_index_type;
-  typedef generic_index<bid_object, bid_object_multi_index_type> bid_index;
+  typedef dense_generic_index<bid_object, bid_object_multi_index_type> bid_index;
+
+  /**
+   *  @brief This secondary index allows a reverse lookup of the bid requests addressed to a provider or an asset.
+   */
+  class bid_request_member_index : public secondary_index
+  {
+     public:
+        virtual void object_inserted( const object& obj ) override;
+        virtual void object_removed( const object& obj ) override;
+        virtual void about_to_modify( const object& before ) override;
+        virtual void object_modified( const object& after  ) override;
+
+        /** maps a provider account to the bid requests listing it in providers */
+        map< account_id_type, set<bid_request_id_type> > requests_by_provider;
+        /** maps an asset to the bid requests listing it in assets */
+        map< asset_id_type, set<bid_request_id_type> >   requests_by_asset;
+        /** same as requests_by_asset, ordered by bid request name */
+        map< asset_id_type, set< pair<string, bid_request_id_type> > > requests_by_asset_name;
+
+     protected:
+        void add_asset_names( const bid_request_object& r, const flat_set<asset_id_type>& assets, const string& name );
+        void remove_asset_names( const bid_request_object& r, const flat_set<asset_id_type>& assets, const string& name );
+
+        flat_set<account_id_type>  before_providers;
+        flat_set<asset_id_type>    before_assets;
+        string                     before_name;
+  };
+
+  /**
+   *  @brief This secondary index keeps the objects that may be expired, ordered by expiration.
+   *
+   *  Bids and bid requests are only removed after expiration once no limit order (respectively bid) refers to
+   *  them anymore.  The referring index reports its references through add_ref() / remove_ref(), so that
+   *  database::clear_expired_bids() and clear_expired_bid_requests() only visit objects they actually remove.
+   */
+  template<typename ObjectType>
+  class expiry_index : public secondary_index
+  {
+     public:
+        typedef decltype( std::declval<ObjectType>().get_id() ) id_type;
+
+        virtual void object_inserted( const object& obj ) override
+        {
+           const ObjectType& o = static_cast<const ObjectType&>( obj );
+           _expirations[o.get_id()] = o.expiration;
+           if( _refs.find( o.get_id() ) == _refs.end() )
+              unreferenced.insert( std::make_pair( o.expiration, o.get_id() ) );
+        }
+        virtual void object_removed( const object& obj ) override
+        {
+           const ObjectType& o = static_cast<const ObjectType&>( obj );
+           _expirations.erase( o.get_id() );
+           unreferenced.erase( std::make_pair( o.expiration, o.get_id() ) );
+        }
+        virtual void about_to_modify( const object& before ) override { object_removed( before ); }
+        virtual void object_modified( const object& after  ) override { object_inserted( after ); }
+
+        void add_ref( id_type id )
+        {
+           if( ++_refs[id] > 1 ) return;
+           auto itr = _expirations.find( id );
+           if( itr != _expirations.end() )
+              unreferenced.erase( std::make_pair( itr->second, id ) );
+        }
+        void remove_ref( id_type id )
+        {
+           auto ref = _refs.find( id );
+           assert( ref != _refs.end() );
+           if( ref == _refs.end() || --ref->second > 0 ) return;
+           _refs.erase( ref );
+           auto itr = _expirations.find( id );
+           if( itr != _expirations.end() )
+              unreferenced.insert( std::make_pair( itr->second, id ) );
+        }
+
+        /** number of referring objects reported for id */
+        uint32_t ref_count( id_type id )const
+        {
+           auto ref = _refs.find( id );
+           return ref == _refs.end() ? 0 : ref->second;
+        }
+
+        /** objects that nothing refers to, ordered by expiration */
+        set< pair<time_point_sec, id_type> > unreferenced;
+
+     private:
+        map< id_type, time_point_sec > _expirations;
+        map< id_type, uint32_t >       _refs;
+  };
+
+  /**
+   *  @brief Reports the bid request referenced by each bid to the bid request expiry_index.
+   */
+  class bid_request_ref_index : public secondary_index
+  {
+     public:
+        virtual void object_inserted( const object& obj ) override;
+        virtual void object_removed( const object& obj ) override;
+        virtual void about_to_modify( const object& before ) override;
+        virtual void object_modified( const object& after  ) override;
+
+        expiry_index<bid_request_object>* bid_requests = nullptr;
+
+     private:
+        bid_request_id_type before_request;
+  };
+
+  /**
+   *  @brief Reports the bid referenced by each limit order to the bid expiry_index.
+   */
+  class bid_order_ref_index : public secondary_index
+  {
+     public:
+        virtual void object_inserted( const object& obj ) override;
+        virtual void object_removed( const object& obj ) override;
+        virtual void about_to_modify( const object& before ) override;
+        virtual void object_modified( const object& after  ) override;
+
+        expiry_index<bid_object>* bids = nullptr;
+
+     private:
+        optional<bid_id_type> before_bid;
+  };
 
 } } // graphene::chain
 
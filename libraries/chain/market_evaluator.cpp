@@ -154,16 +154,19 @@ void_result limit_order_accept_evaluator::do_apply(const limit_order_accept_oper
 { try {
    database& d = db();
 
-   const auto& limit_price_idx = d.get_index_type<limit_order_index>().indices().get<by_price>();
+   const auto& limit_request_idx = d.get_index_type<limit_order_index>().indices().get<by_request>();
+
+   const optional<uint64_t> request_id = o.request_id;
+   const optional<uint64_t> user_id = o.user_id;
+   auto limit_itr = limit_request_idx.lower_bound(boost::make_tuple(request_id, user_id,
+                                                                    price::max(o.asset_id_to_receive, o.asset_id_to_sell)));
+   auto limit_end = limit_request_idx.upper_bound(boost::make_tuple(request_id, user_id,
+                                                                    price::min(o.asset_id_to_receive, o.asset_id_to_sell)));
 
-   auto limit_itr = limit_price_idx.lower_bound(price::max(o.asset_id_to_receive, o.asset_id_to_sell));
-   auto limit_end = limit_price_idx.upper_bound(price::min(o.asset_id_to_receive, o.asset_id_to_sell));
-   
    while( limit_itr != limit_end )
    {
       const limit_order_object& order = *limit_itr;
       ++limit_itr;
-      // match returns 2 when only the old order was fully filled. In this case, we keep matching; otherwise, we stop.
       if( d.is_match_possible( order, o.request_id, o.user_id, o.seller, o.counterparty_id) ){
         limit_order_accepted_operation op_accepted;
         op_accepted.order_id = order.id;
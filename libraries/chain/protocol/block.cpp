@@ -39,6 +39,8 @@ namespace graphene { namespace chain {
 
    block_id_type signed_block_header::id()const
    {
+      if( _id.valid )
+         return _id.value;
       auto tmp = fc::sha224::hash( *this );
       tmp._hash[0] = fc::endian_reverse_u32(block_num()); // store the block num in the ID, 160 bits is plenty for the hash
       static_assert( sizeof(tmp._hash[0]) == 4, "should be 4 bytes" );
@@ -47,6 +49,15 @@ namespace graphene { namespace chain {
       return result;
    }
 
+   void signed_block_header::cache_id()const
+   {
+      if( !_id.valid )
+      {
+         _id.value = id();
+         _id.valid = true;
+      }
+   }
+
    fc::ecc::public_key signed_block_header::signee()const
    {
       return fc::ecc::public_key( witness_signature, digest(), true/*enforce canonical*/ );
@@ -55,6 +66,7 @@ namespace graphene { namespace chain {
    void signed_block_header::sign( const fc::ecc::private_key& signer )
    {
       witness_signature = signer.sign_compact( digest() );
+      _id.valid = false;
    }
 
    bool signed_block_header::validate_signee( const fc::ecc::public_key& expected_signee )const
@@ -89,4 +101,11 @@ namespace graphene { namespace chain {
       return checksum_type::hash( ids[0] );
    }
 
+   void signed_block::cache_digests( const chain_id_type& chain_id )const
+   {
+      for( const auto& trx : transactions )
+         trx.cache_digests( chain_id );
+      cache_id();
+   }
+
 } }
@@ -32,13 +32,27 @@ namespace graphene { namespace chain {
 
 digest_type processed_transaction::merkle_digest()const
 {
+   if( _merkle_digest.valid )
+      return _merkle_digest.value;
    digest_type::encoder enc;
    fc::raw::pack( enc, *this );
    return enc.result();
 }
 
+void processed_transaction::cache_digests( const chain_id_type& chain_id )const
+{
+   signed_transaction::cache_digests( chain_id );
+   if( !_merkle_digest.valid )
+   {
+      _merkle_digest.value = merkle_digest();
+      _merkle_digest.valid = true;
+   }
+}
+
 digest_type transaction::digest()const
 {
+   if( _digest.valid )
+      return _digest.value;
    digest_type::encoder enc;
    fc::raw::pack( enc, *this );
    return enc.result();
@@ -46,12 +60,29 @@ digest_type transaction::digest()const
 
 digest_type transaction::sig_digest( const chain_id_type& chain_id )const
 {
+   if( _sig_digest.valid && _sig_digest.value.first == chain_id )
+      return _sig_digest.value.second;
    digest_type::encoder enc;
    fc::raw::pack( enc, chain_id );
    fc::raw::pack( enc, *this );
    return enc.result();
 }
 
+void transaction::cache_digests( const chain_id_type& chain_id )const
+{
+   if( !_digest.valid )
+   {
+      _digest.value = digest();
+      _digest.valid = true;
+   }
+   if( !_sig_digest.valid || _sig_digest.value.first != chain_id )
+   {
+      _sig_digest.valid = false;
+      _sig_digest.value = std::make_pair( chain_id, sig_digest( chain_id ) );
+      _sig_digest.valid = true;
+   }
+}
+
 void transaction::validate() const
 {
    FC_ASSERT( operations.size() > 0, "A transaction must have at least one operation", ("trx",*this) );
@@ -85,12 +116,14 @@ signature_type graphene::chain::signed_transaction::sign(const private_key_type&
 void transaction::set_expiration( fc::time_point_sec expiration_time )
 {
     expiration = expiration_time;
+    invalidate_digests();
 }
 
 void transaction::set_reference_block( const block_id_type& reference_block )
 {
    ref_block_num = fc::endian_reverse_u32(reference_block._hash[0]);
    ref_block_prefix = reference_block._hash[1];
+   invalidate_digests();
 }
 
 void transaction::get_required_authorities( flat_set<account_id_type>& active, flat_set<account_id_type>& owner, vector<authority>& other )const
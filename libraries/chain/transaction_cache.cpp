@@ -0,0 +1,109 @@
+/*
+ * Copyright (c) 2015 Cryptonomex, Inc., and contributors.
+ *
+ * The MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#include <graphene/chain/transaction_cache.hpp>
+
+#include <fc/io/raw.hpp>
+
+#include <boost/thread/locks.hpp>
+
+namespace graphene { namespace chain {
+
+recent_transaction_cache::recent_transaction_cache( uint64_t max_bytes )
+   : _max_bytes( max_bytes )
+{
+}
+
+void recent_transaction_cache::set_max_bytes( uint64_t max_bytes )
+{
+   boost::lock_guard<boost::mutex> guard( _mutex );
+   _max_bytes = max_bytes;
+   shrink_to( _max_bytes );
+}
+
+void recent_transaction_cache::add( const transaction_id_type& id, const signed_transaction& trx )
+{
+   const uint64_t bytes = fc::raw::pack_size( trx );
+   boost::lock_guard<boost::mutex> guard( _mutex );
+   if( bytes > _max_bytes || _entries.get<by_trx_id>().find( id ) != _entries.get<by_trx_id>().end() )
+      return;
+   shrink_to( _max_bytes - bytes );
+   entry e;
+   e.id = id;
+   e.expiration = trx.expiration;
+   e.bytes = bytes;
+   e.trx = std::make_shared<const signed_transaction>( trx );
+   _entries.push_back( std::move( e ) );
+   _bytes += bytes;
+}
+
+std::shared_ptr<const signed_transaction> recent_transaction_cache::find( const transaction_id_type& id )const
+{
+   boost::lock_guard<boost::mutex> guard( _mutex );
+   const auto& idx = _entries.get<by_trx_id>();
+   auto itr = idx.find( id );
+   if( itr == idx.end() )
+      return std::shared_ptr<const signed_transaction>();
+   return itr->trx;
+}
+
+void recent_transaction_cache::remove_expired( fc::time_point_sec now )
+{
+   boost::lock_guard<boost::mutex> guard( _mutex );
+   auto& idx = _entries.get<by_expiration>();
+   while( !idx.empty() && now > idx.begin()->expiration )
+   {
+      _bytes -= idx.begin()->bytes;
+      idx.erase( idx.begin() );
+   }
+}
+
+void recent_transaction_cache::clear()
+{
+   boost::lock_guard<boost::mutex> guard( _mutex );
+   _entries.clear();
+   _bytes = 0;
+}
+
+uint64_t recent_transaction_cache::size()const
+{
+   boost::lock_guard<boost::mutex> guard( _mutex );
+   return _entries.size();
+}
+
+uint64_t recent_transaction_cache::size_bytes()const
+{
+   boost::lock_guard<boost::mutex> guard( _mutex );
+   return _bytes;
+}
+
+void recent_transaction_cache::shrink_to( uint64_t max_bytes )
+{
+   while( !_entries.empty() && _bytes > max_bytes )
+   {
+      _bytes -= _entries.front().bytes;
+      _entries.pop_front();
+   }
+}
+
+} }
@@ -0,0 +1,174 @@
+/*
+ * Copyright (c) 2015 Cryptonomex, Inc., and contributors.
+ *
+ * The MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#include <graphene/chain/market_object.hpp>
+#include <graphene/chain/worker_object.hpp>
+
+namespace graphene { namespace chain {
+
+void bid_request_member_index::object_inserted( const object& obj )
+{
+   const bid_request_object& r = static_cast<const bid_request_object&>( obj );
+   for( auto item : r.providers )
+      requests_by_provider[item].insert( r.get_id() );
+   for( auto item : r.assets )
+      requests_by_asset[item].insert( r.get_id() );
+   add_asset_names( r, r.assets, r.name );
+}
+
+void bid_request_member_index::object_removed( const object& obj )
+{
+   const bid_request_object& r = static_cast<const bid_request_object&>( obj );
+   for( auto item : r.providers )
+   {
+      auto itr = requests_by_provider.find( item );
+      if( itr == requests_by_provider.end() ) continue;
+      itr->second.erase( r.get_id() );
+      if( itr->second.empty() ) requests_by_provider.erase( itr );
+   }
+   for( auto item : r.assets )
+   {
+      auto itr = requests_by_asset.find( item );
+      if( itr == requests_by_asset.end() ) continue;
+      itr->second.erase( r.get_id() );
+      if( itr->second.empty() ) requests_by_asset.erase( itr );
+   }
+   remove_asset_names( r, r.assets, r.name );
+}
+
+void bid_request_member_index::about_to_modify( const object& before )
+{
+   const bid_request_object& r = static_cast<const bid_request_object&>( before );
+   before_providers = r.providers;
+   before_assets = r.assets;
+   before_name = r.name;
+}
+
+void bid_request_member_index::object_modified( const object& after  )
+{
+   const bid_request_object& r = static_cast<const bid_request_object&>( after );
+   if( r.providers != before_providers )
+   {
+      for( auto item : before_providers )
+      {
+         if( r.providers.find( item ) != r.providers.end() ) continue;
+         auto itr = requests_by_provider.find( item );
+         if( itr == requests_by_provider.end() ) continue;
+         itr->second.erase( r.get_id() );
+         if( itr->second.empty() ) requests_by_provider.erase( itr );
+      }
+      for( auto item : r.providers )
+         requests_by_provider[item].insert( r.get_id() );
+   }
+   if( r.assets != before_assets )
+   {
+      for( auto item : before_assets )
+      {
+         if( r.assets.find( item ) != r.assets.end() ) continue;
+         auto itr = requests_by_asset.find( item );
+         if( itr == requests_by_asset.end() ) continue;
+         itr->second.erase( r.get_id() );
+         if( itr->second.empty() ) requests_by_asset.erase( itr );
+      }
+      for( auto item : r.assets )
+         requests_by_asset[item].insert( r.get_id() );
+   }
+   if( r.assets != before_assets || r.name != before_name )
+   {
+      remove_asset_names( r, before_assets, before_name );
+      add_asset_names( r, r.assets, r.name );
+   }
+}
+
+void bid_request_member_index::add_asset_names( const bid_request_object& r, const flat_set<asset_id_type>& assets,
+                                                const string& name )
+{
+   for( auto item : assets )
+      requests_by_asset_name[item].insert( std::make_pair( name, r.get_id() ) );
+}
+
+void bid_request_member_index::remove_asset_names( const bid_request_object& r, const flat_set<asset_id_type>& assets,
+                                                   const string& name )
+{
+   for( auto item : assets )
+   {
+      auto itr = requests_by_asset_name.find( item );
+      if( itr == requests_by_asset_name.end() ) continue;
+      itr->second.erase( std::make_pair( name, r.get_id() ) );
+      if( itr->second.empty() ) requests_by_asset_name.erase( itr );
+   }
+}
+
+void bid_request_ref_index::object_inserted( const object& obj )
+{
+   bid_requests->add_ref( static_cast<const bid_object&>( obj ).request );
+}
+
+void bid_request_ref_index::object_removed( const object& obj )
+{
+   bid_requests->remove_ref( static_cast<const bid_object&>( obj ).request );
+}
+
+void bid_request_ref_index::about_to_modify( const object& before )
+{
+   before_request = static_cast<const bid_object&>( before ).request;
+}
+
+void bid_request_ref_index::object_modified( const object& after  )
+{
+   const bid_object& b = static_cast<const bid_object&>( after );
+   if( b.request == before_request ) return;
+   bid_requests->add_ref( b.request );
+   bid_requests->remove_ref( before_request );
+}
+
+void bid_order_ref_index::object_inserted( const object& obj )
+{
+   const limit_order_object& o = static_cast<const limit_order_object&>( obj );
+   if( o.bid_id.valid() )
+      bids->add_ref( *o.bid_id );
+}
+
+void bid_order_ref_index::object_removed( const object& obj )
+{
+   const limit_order_object& o = static_cast<const limit_order_object&>( obj );
+   if( o.bid_id.valid() )
+      bids->remove_ref( *o.bid_id );
+}
+
+void bid_order_ref_index::about_to_modify( const object& before )
+{
+   before_bid = static_cast<const limit_order_object&>( before ).bid_id;
+}
+
+void bid_order_ref_index::object_modified( const object& after  )
+{
+   const limit_order_object& o = static_cast<const limit_order_object&>( after );
+   if( o.bid_id == before_bid ) return;
+   if( o.bid_id.valid() )
+      bids->add_ref( *o.bid_id );
+   if( before_bid.valid() )
+      bids->remove_ref( *before_bid );
+}
+
+} } // graphene::chain
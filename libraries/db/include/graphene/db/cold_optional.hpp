@@ -0,0 +1,122 @@
+/*
+ * Copyright (c) 2015 Cryptonomex, Inc., and contributors.
+ *
+ * The MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#pragma once
+#include <fc/optional.hpp>
+#include <fc/io/raw.hpp>
+#include <fc/variant.hpp>
+
+#include <memory>
+
+namespace graphene { namespace db {
+
+   /**
+    *  @brief An optional value kept out of line in an immutable block shared by all copies
+    *
+    *  Objects in the hot multi_index containers are copied for every undo state and walked by every matching
+    *  loop; a large, rarely read member such as a memo makes each of them several times bigger than the fields
+    *  that are actually compared.  Storing it through cold_optional leaves a single pointer in the object, and
+    *  the value is only touched when it is read.
+    *
+    *  It serializes and converts to a variant exactly like optional<T>, so reflected objects are unchanged.
+    */
+   template<typename T>
+   class cold_optional
+   {
+      public:
+         typedef T value_type;
+
+         cold_optional() = default;
+         cold_optional( const fc::optional<T>& v ) { *this = v; }
+
+         cold_optional& operator=( const fc::optional<T>& v )
+         {
+            if( v.valid() )
+               _value = std::make_shared<const T>( *v );
+            else
+               _value.reset();
+            return *this;
+         }
+
+         cold_optional& operator=( const T& v )
+         {
+            _value = std::make_shared<const T>( v );
+            return *this;
+         }
+
+         bool     valid()const      { return bool(_value); }
+         void     reset()           { _value.reset(); }
+         const T& operator*()const  { return *_value; }
+         const T* operator->()const { return _value.get(); }
+
+         /** a copy of the value, for the places that hold optional<T> */
+         fc::optional<T> as_optional()const
+         {
+            if( _value )
+               return fc::optional<T>( *_value );
+            return fc::optional<T>();
+         }
+
+      private:
+         std::shared_ptr<const T> _value;
+   };
+
+   template<typename Stream, typename T>
+   void operator<<( Stream& s, const cold_optional<T>& v )
+   {
+      // same layout as optional<T>
+      fc::raw::pack( s, v.valid() );
+      if( v.valid() )
+         fc::raw::pack( s, *v );
+   }
+
+   template<typename Stream, typename T>
+   void operator>>( Stream& s, cold_optional<T>& v )
+   {
+      fc::optional<T> tmp;
+      fc::raw::unpack( s, tmp );
+      v = tmp;
+   }
+
+} } // graphene::db
+
+namespace fc {
+
+   template<typename T>
+   void to_variant( const graphene::db::cold_optional<T>& var, fc::variant& vo )
+   {
+      if( var.valid() )
+         to_variant( *var, vo );
+      else
+         vo = fc::variant();
+   }
+
+   template<typename T>
+   void from_variant( const fc::variant& var, graphene::db::cold_optional<T>& vo )
+   {
+      fc::optional<T> tmp;
+      from_variant( var, tmp );
+      vo = tmp;
+   }
+
+} // fc
@@ -0,0 +1,183 @@
+/*
+ * Copyright (c) 2015 Cryptonomex, Inc., and contributors.
+ *
+ * The MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#pragma once
+#include <graphene/db/object_id.hpp>
+
+#include <utility>
+#include <vector>
+
+namespace graphene { namespace db {
+
+   namespace detail
+   {
+      inline const object_id_type& entry_id( const object_id_type& e ) { return e; }
+
+      template<typename Value>
+      const object_id_type& entry_id( const std::pair<object_id_type,Value>& e ) { return e.first; }
+
+      /**
+       *  @brief Open addressing hash table keyed by object id
+       *
+       *  Entries are stored densely in insertion order (erasing moves the last entry into the hole), and a
+       *  power of two array of slots with linear probing maps ids to positions.  Compared to the node based
+       *  std::unordered_* containers this costs no allocation per entry and iterates contiguous memory.
+       */
+      template<typename Entry>
+      class flat_id_table
+      {
+         public:
+            typedef Entry                                           value_type;
+            typedef typename std::vector<Entry>::iterator          iterator;
+            typedef typename std::vector<Entry>::const_iterator    const_iterator;
+
+            iterator       begin()       { return _entries.begin(); }
+            iterator       end()         { return _entries.end();   }
+            const_iterator begin()const  { return _entries.begin(); }
+            const_iterator end()const    { return _entries.end();   }
+            size_t         size()const   { return _entries.size();  }
+            bool           empty()const  { return _entries.empty(); }
+
+            iterator find( const object_id_type& id )
+            {
+               const size_t slot = find_slot( id );
+               return _slots.empty() || _slots[slot] == empty_slot ? end() : begin() + _slots[slot];
+            }
+            const_iterator find( const object_id_type& id )const
+            {
+               const size_t slot = find_slot( id );
+               return _slots.empty() || _slots[slot] == empty_slot ? end() : begin() + _slots[slot];
+            }
+            size_t count( const object_id_type& id )const { return find( id ) == end() ? 0 : 1; }
+
+            size_t erase( const object_id_type& id )
+            {
+               if( _slots.empty() )
+                  return 0;
+               size_t hole = find_slot( id );
+               if( _slots[hole] == empty_slot )
+                  return 0;
+
+               // move the last entry into the erased one's place
+               const uint32_t pos = _slots[hole];
+               const uint32_t last = _entries.size() - 1;
+               if( pos != last )
+               {
+                  _slots[ find_slot( entry_id( _entries[last] ) ) ] = pos;
+                  _entries[pos] = std::move( _entries[last] );
+               }
+               _entries.pop_back();
+
+               // backward shift the probe sequence over the hole, so no tombstones are needed
+               const size_t mask = _slots.size() - 1;
+               for( size_t next = (hole + 1) & mask; _slots[next] != empty_slot; next = (next + 1) & mask )
+               {
+                  const size_t home = slot_of( entry_id( _entries[_slots[next]] ) );
+                  // move the entry back unless its home lies cyclically in (hole, next]
+                  const bool stays = hole <= next ? ( hole < home && home <= next ) : ( hole < home || home <= next );
+                  if( !stays )
+                  {
+                     _slots[hole] = _slots[next];
+                     hole = next;
+                  }
+               }
+               _slots[hole] = empty_slot;
+               return 1;
+            }
+
+            void clear()
+            {
+               _entries.clear();
+               _slots.clear();
+            }
+
+         protected:
+            /** inserts e unless an entry with its id exists, and returns the entry with that id */
+            Entry& insert_entry( Entry&& e )
+            {
+               if( (_entries.size() + 1) * 4 > _slots.size() * 3 )
+                  grow();
+               const size_t slot = find_slot( entry_id( e ) );
+               if( _slots[slot] == empty_slot )
+               {
+                  _slots[slot] = _entries.size();
+                  _entries.push_back( std::move( e ) );
+               }
+               return _entries[_slots[slot]];
+            }
+
+         private:
+            static const uint32_t empty_slot = uint32_t(-1);
+
+            size_t slot_of( const object_id_type& id )const
+            {
+               uint64_t h = id.number * 0x9e3779b97f4a7c15ull;
+               return ( h ^ (h >> 32) ) & ( _slots.size() - 1 );
+            }
+
+            /** @return the slot holding id, or the empty slot where it would go */
+            size_t find_slot( const object_id_type& id )const
+            {
+               if( _slots.empty() )
+                  return 0;
+               const size_t mask = _slots.size() - 1;
+               size_t slot = slot_of( id );
+               while( _slots[slot] != empty_slot && !( entry_id( _entries[_slots[slot]] ) == id ) )
+                  slot = (slot + 1) & mask;
+               return slot;
+            }
+
+            void grow()
+            {
+               _slots.assign( std::max<size_t>( 16, _slots.size() * 2 ), empty_slot );
+               for( uint32_t pos = 0; pos < _entries.size(); ++pos )
+                  _slots[ find_slot( entry_id( _entries[pos] ) ) ] = pos;
+            }
+
+            std::vector<Entry>    _entries;
+            std::vector<uint32_t> _slots;
+      };
+
+      template<typename Entry>
+      const uint32_t flat_id_table<Entry>::empty_slot;
+   }
+
+   /** Map from object id to Value, see detail::flat_id_table */
+   template<typename Value>
+   class flat_id_map : public detail::flat_id_table< std::pair<object_id_type,Value> >
+   {
+      public:
+         Value& operator[]( const object_id_type& id )
+         {
+            return this->insert_entry( std::pair<object_id_type,Value>( id, Value() ) ).second;
+         }
+   };
+
+   /** Set of object ids, see detail::flat_id_table */
+   class flat_id_set : public detail::flat_id_table< object_id_type >
+   {
+      public:
+         void insert( const object_id_type& id ) { object_id_type e = id; insert_entry( std::move( e ) ); }
+   };
+
+} } // graphene::db
@@ -28,6 +28,9 @@
 #include <boost/multi_index/ordered_index.hpp>
 #include <boost/multi_index/mem_fun.hpp>
 
+#include <memory>
+#include <vector>
+
 namespace graphene { namespace chain {
 
    using boost::multi_index_container;
@@ -112,6 +115,110 @@ namespace graphene { namespace chain {
          index_type  _indices;
    };
 
+   /**
+    *  A generic_index that also keeps a pointer to each of its objects by instance number, so that find() costs an
+    *  array access instead of a walk down the by_id tree.  Instances are handed out in sequence, so the table is
+    *  dense; it is allocated in segments, and a segment whose objects were all removed is released again.
+    *
+    *  Objects never move inside the multi_index container and their ids never change, so the table only follows
+    *  insert() and remove(), which is also how undo puts objects back and takes them out, and a modify() after
+    *  which the container dropped the object.
+    */
+   template<typename ObjectType, typename MultiIndexType>
+   class dense_generic_index : public generic_index<ObjectType, MultiIndexType>
+   {
+         typedef generic_index<ObjectType, MultiIndexType> base_type;
+      public:
+         virtual const object& insert( object&& obj )override
+         {
+            const object& result = base_type::insert( std::move( obj ) );
+            set_slot( result.id.instance(), &result );
+            return result;
+         }
+
+         virtual const object& create( const std::function<void(object&)>& constructor )override
+         {
+            const object& result = base_type::create( constructor );
+            set_slot( result.id.instance(), &result );
+            return result;
+         }
+
+         virtual void modify( const object& obj, const std::function<void(object&)>& m )override
+         {
+            const object_id_type id = obj.id;
+            try
+            {
+               base_type::modify( obj, m );
+            }
+            catch( ... )
+            {
+               // boost::multi_index erases an object whose modification throws or breaks a uniqueness constraint
+               if( base_type::indices().find( id ) == base_type::indices().end() )
+                  clear_slot( id.instance() );
+               throw;
+            }
+         }
+
+         virtual void remove( const object& obj )override
+         {
+            const uint64_t instance = obj.id.instance();
+            base_type::remove( obj );
+            clear_slot( instance );
+         }
+
+         virtual const object* find( object_id_type id )const override
+         {
+            const uint64_t instance = id.instance();
+            const uint64_t seg = instance >> segment_bits;
+            if( seg >= _segments.size() || !_segments[seg].objects )
+               return nullptr;
+            const object* result = _segments[seg].objects[ instance & ( segment_size - 1 ) ];
+            if( result == nullptr || result->id != id )
+               return nullptr;
+            return result;
+         }
+
+      private:
+         static const uint32_t segment_bits = 12;
+         static const uint64_t segment_size = uint64_t(1) << segment_bits;
+
+         struct segment
+         {
+            std::unique_ptr<const object*[]> objects;
+            uint32_t                         count = 0;
+         };
+
+         void set_slot( uint64_t instance, const object* obj )
+         {
+            const uint64_t seg = instance >> segment_bits;
+            if( seg >= _segments.size() )
+               _segments.resize( seg + 1 );
+            segment& s = _segments[seg];
+            if( !s.objects )
+               s.objects.reset( new const object*[segment_size]() );
+            const object*& slot = s.objects[ instance & ( segment_size - 1 ) ];
+            if( slot == nullptr )
+               ++s.count;
+            slot = obj;
+         }
+
+         void clear_slot( uint64_t instance )
+         {
+            const uint64_t seg = instance >> segment_bits;
+            if( seg >= _segments.size() || !_segments[seg].objects )
+               return;
+            segment& s = _segments[seg];
+            const object*& slot = s.objects[ instance & ( segment_size - 1 ) ];
+            if( slot == nullptr )
+               return;
+            slot = nullptr;
+            if( --s.count == 0 )
+               s.objects.reset();
+         }
+
+         std::vector<segment> _segments;
+   };
+
    /**
     * @brief An index type for objects which may be deleted
     *
@@ -27,12 +27,37 @@
 #include <fc/io/raw.hpp>
 #include <fc/io/json.hpp>
 #include <fc/crypto/sha256.hpp>
+#include <fc/optional.hpp>
 #include <fstream>
 
 namespace graphene { namespace db {
    class object_database;
    using fc::path;
 
+   /**
+    * @brief Leads every file written by primary_index::save()
+    *
+    * The objects follow in chunks of about snapshot_chunk_size bytes, each made of the number of objects it holds,
+    * the size of its payload and the packed objects themselves.  checksum covers all chunks, so a truncated or
+    * damaged file is detected instead of being loaded partially.
+    */
+   struct snapshot_header
+   {
+      /** files without this leading word use the old format of length-prefixed objects */
+      static const uint64_t magic_number = 0xff67726170686e65ull;
+      static const uint32_t current_format_version = 2;
+
+      uint64_t        magic = magic_number;
+      uint32_t        format_version = current_format_version;
+      object_id_type  next_id;
+      fc::sha256      object_version;
+      uint64_t        object_count = 0;
+      uint64_t        chunk_count = 0;
+      fc::sha256      checksum;
+   };
+
+   const size_t snapshot_chunk_size = 1024*1024;
+
    /**
     * @class index_observer
     * @brief used to get callbacks when objects change
@@ -96,6 +121,14 @@ namespace graphene { namespace db {
          virtual void open( const fc::path& db ) = 0;
          virtual void save( const fc::path& db ) = 0;
 
+         /**
+          *  open() in two steps, so that object_database can read the files of several indexes concurrently:
+          *  read_snapshot() decodes and verifies the file without touching the index, insert_snapshot() then
+          *  adds the decoded objects.  Only read_snapshot() may run in parallel with other indexes.
+          */
+         virtual void read_snapshot( const fc::path& db ) = 0;
+         virtual void insert_snapshot() = 0;
+
 
 
          /** @return the object with id or nullptr if not found */
@@ -224,24 +257,44 @@ namespace graphene { namespace db {
          }
 
          virtual void open( const path& db )override
-         { 
+         {
+            read_snapshot( db );
+            insert_snapshot();
+         }
+
+         virtual void read_snapshot( const path& db )override
+         {
+            _snapshot.clear();
+            _snapshot_next_id.reset();
             if( !fc::exists( db ) ) return;
+            const auto file_size = fc::file_size( db );
+            FC_ASSERT( file_size >= sizeof(uint64_t), "Object database file ${f} is truncated", ("f",db) );
+
             fc::file_mapping fm( db.generic_string().c_str(), fc::read_only );
-            fc::mapped_region mr( fm, fc::read_only, 0, fc::file_size(db) );
+            fc::mapped_region mr( fm, fc::read_only, 0, file_size );
             fc::datastream<const char*> ds( (const char*)mr.get_address(), mr.get_size() );
-            fc::sha256 open_ver;
 
-            fc::raw::unpack(ds, _next_id);
-            fc::raw::unpack(ds, open_ver);
-            FC_ASSERT( open_ver == get_object_version(), "Incompatible Version, the serialization of objects in this index has changed" );
-            try {
-               vector<char> tmp;
-               while( true ) 
-               {
-                  fc::raw::unpack( ds, tmp );
-                  load( tmp );
-               }
-            } catch ( const fc::exception&  ){}
+            uint64_t magic;
+            memcpy( &magic, mr.get_address(), sizeof(magic) );
+            if( magic == snapshot_header::magic_number )
+               read_chunks( ds, db );
+            else
+               read_legacy( ds, db );
+         }
+
+         virtual void insert_snapshot()override
+         {
+            if( !_snapshot_next_id.valid() ) return;
+            _next_id = *_snapshot_next_id;
+            for( auto& item : _snapshot )
+            {
+               const auto& result = DerivedIndex::insert( std::move( item ) );
+               for( const auto& sindex : _sindex )
+                  sindex->object_inserted( result );
+            }
+            _snapshot.clear();
+            _snapshot.shrink_to_fit();
+            _snapshot_next_id.reset();
          }
 
          virtual void save( const path& db ) override 
@@ -249,14 +302,50 @@ namespace graphene { namespace db {
             std::ofstream out( db.generic_string(), 
                                std::ofstream::binary | std::ofstream::out | std::ofstream::trunc );
             FC_ASSERT( out );
-            auto ver  = get_object_version();
-            fc::raw::pack( out, _next_id );
-            fc::raw::pack( out, ver );
+
+            snapshot_header header;
+            header.next_id = _next_id;
+            header.object_version = get_object_version();
+            fc::raw::pack( out, header ); // rewritten below, once count and checksum are known
+
+            fc::sha256::encoder enc;
+            std::vector<char> chunk;
+            chunk.reserve( snapshot_chunk_size );
+            uint32_t chunk_objects = 0;
+
+            auto write_chunk = [&]() {
+               if( chunk_objects == 0 ) return;
+               char prefix[2*sizeof(uint32_t)];
+               fc::datastream<char*> ps( prefix, sizeof(prefix) );
+               fc::raw::pack( ps, chunk_objects );
+               fc::raw::pack( ps, uint32_t( chunk.size() ) );
+               enc.write( prefix, sizeof(prefix) );
+               enc.write( chunk.data(), chunk.size() );
+               out.write( prefix, sizeof(prefix) );
+               out.write( chunk.data(), chunk.size() );
+               ++header.chunk_count;
+               chunk.clear();
+               chunk_objects = 0;
+            };
+
             this->inspect_all_objects( [&]( const object& o ) {
-                auto vec = fc::raw::pack( static_cast<const object_type&>(o) );
-                auto packed_vec = fc::raw::pack( vec );
-                out.write( packed_vec.data(), packed_vec.size() );
+                const object_type& obj = static_cast<const object_type&>(o);
+                const size_t offset = chunk.size();
+                chunk.resize( offset + fc::raw::pack_size( obj ) );
+                fc::datastream<char*> ds( chunk.data() + offset, chunk.size() - offset );
+                fc::raw::pack( ds, obj );
+                ++chunk_objects;
+                ++header.object_count;
+                if( chunk.size() >= snapshot_chunk_size )
+                   write_chunk();
             });
+            write_chunk();
+
+            header.checksum = enc.result();
+            out.seekp( 0 );
+            fc::raw::pack( out, header );
+            out.flush();
+            FC_ASSERT( out, "Unable to write object database file ${f}", ("f",db) );
          }
 
          virtual const object&  load( const std::vector<char>& data )override
@@ -268,6 +357,15 @@ namespace graphene { namespace db {
          }
 
 
+         virtual const object&  insert( object&& obj )override
+         {
+            const auto& result = DerivedIndex::insert( std::move( obj ) );
+            for( const auto& item : _sindex )
+               item->object_inserted( result );
+            on_add( result );
+            return result;
+         }
+
          virtual const object&  create(const std::function<void(object&)>& constructor )override
          {
             const auto& result = DerivedIndex::create( constructor );
@@ -320,7 +418,74 @@ namespace graphene { namespace db {
          }
 
       private:
-         object_id_type _next_id;
+         void read_chunks( fc::datastream<const char*>& ds, const path& db )
+         {
+            snapshot_header header;
+            FC_ASSERT( ds.remaining() >= fc::raw::pack_size( header ), "Object database file ${f} is truncated", ("f",db) );
+            fc::raw::unpack( ds, header );
+            FC_ASSERT( header.format_version == snapshot_header::current_format_version,
+                       "Unsupported object database file format ${v}", ("v",header.format_version)("f",db) );
+            FC_ASSERT( header.object_version == get_object_version(), "Incompatible Version, the serialization of objects in this index has changed" );
+            // every chunk has a prefix and every object takes at least a byte, check before trusting the counts
+            FC_ASSERT( header.chunk_count <= ds.remaining() / ( 2 * sizeof(uint32_t) )
+                       && header.object_count <= ds.remaining() - header.chunk_count * 2 * sizeof(uint32_t),
+                       "Object database file ${f} is corrupted", ("f",db)("objects",header.object_count)
+                       ("chunks",header.chunk_count)("size",ds.remaining()) );
+
+            fc::sha256::encoder enc;
+            _snapshot.reserve( header.object_count );
+            for( uint64_t c = 0; c < header.chunk_count; ++c )
+            {
+               const char* chunk_begin = ds.pos();
+               uint32_t count;
+               uint32_t size;
+               FC_ASSERT( ds.remaining() >= sizeof(count) + sizeof(size), "Object database file ${f} is truncated", ("f",db) );
+               fc::raw::unpack( ds, count );
+               fc::raw::unpack( ds, size );
+               FC_ASSERT( ds.remaining() >= size, "Object database file ${f} is truncated", ("f",db) );
+               FC_ASSERT( count <= size && _snapshot.size() + count <= header.object_count,
+                          "Object database file ${f} is corrupted", ("f",db) );
+               enc.write( chunk_begin, sizeof(count) + sizeof(size) + size );
+
+               fc::datastream<const char*> chunk( ds.pos(), size );
+               for( uint32_t i = 0; i < count; ++i )
+               {
+                  _snapshot.emplace_back();
+                  fc::raw::unpack( chunk, _snapshot.back() );
+               }
+               FC_ASSERT( chunk.remaining() == 0, "Object database file ${f} is corrupted", ("f",db) );
+               ds.skip( size );
+            }
+            FC_ASSERT( ds.remaining() == 0, "Object database file ${f} has trailing data", ("f",db) );
+            FC_ASSERT( _snapshot.size() == header.object_count, "Object database file ${f} is corrupted", ("f",db)
+                       ("expected",header.object_count)("found",_snapshot.size()) );
+            FC_ASSERT( enc.result() == header.checksum, "Object database file ${f} fails its checksum", ("f",db) );
+            _snapshot_next_id = header.next_id;
+         }
+
+         /** files written before snapshot_header was introduced */
+         void read_legacy( fc::datastream<const char*>& ds, const path& db )
+         {
+            object_id_type next_id;
+            fc::sha256 open_ver;
+
+            fc::raw::unpack(ds, next_id);
+            fc::raw::unpack(ds, open_ver);
+            FC_ASSERT( open_ver == get_object_version(), "Incompatible Version, the serialization of objects in this index has changed" );
+            vector<char> tmp;
+            while( ds.remaining() > 0 )
+            {
+               fc::raw::unpack( ds, tmp );
+               _snapshot.push_back( fc::raw::unpack<object_type>( tmp ) );
+            }
+            _snapshot_next_id = next_id;
+         }
+
+         object_id_type               _next_id;
+         vector<object_type>          _snapshot;
+         fc::optional<object_id_type> _snapshot_next_id;
    };
 
 } } // graphene::db
+
+FC_REFLECT( graphene::db::snapshot_header, (magic)(format_version)(next_id)(object_version)(object_count)(chunk_count)(checksum) )
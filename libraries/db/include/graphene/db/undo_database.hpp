@@ -23,21 +23,75 @@
  */
 #pragma once
 #include <graphene/db/object.hpp>
+#include <graphene/db/flat_id_map.hpp>
 #include <deque>
 #include <fc/exception/exception.hpp>
 
 namespace graphene { namespace db {
 
-   using std::unordered_map;
    using fc::flat_set;
    class object_database;
 
+   /** Blocks released by undo_arena::reset(), kept for reuse by the arenas of later undo states */
+   struct undo_block_pool
+   {
+      ~undo_block_pool();
+      std::vector<char*> blocks;
+   };
+
+   /**
+    *  @brief Bump allocator for the object copies saved in an undo state
+    *
+    *  Memory is handed out from fixed size blocks and only released all at once by reset(), which returns the blocks
+    *  to the pool, so a steady stream of sessions allocates nothing once the pool is warm.
+    */
+   class undo_arena
+   {
+      public:
+         static const size_t block_size = 64 * 1024;
+
+         explicit undo_arena( undo_block_pool* pool = nullptr ) : _pool( pool ) {}
+         undo_arena( const undo_arena& ) = delete;
+         undo_arena& operator = ( const undo_arena& ) = delete;
+         ~undo_arena() { reset(); }
+
+         /** @return size bytes aligned for any object */
+         void* allocate( size_t size );
+         /** takes over the memory of other, e.g. when other's objects are moved into this arena's state */
+         void  splice( undo_arena& other );
+         void  reset();
+
+      private:
+         undo_block_pool*    _pool;
+         std::vector<char*>  _blocks;
+         /** allocations larger than a block, which are not pooled */
+         std::vector<char*>  _large;
+         /** bytes used of _blocks.back() */
+         size_t              _used = block_size;
+   };
+
+   /** Destroys, but does not free, an object copied into an undo_arena */
+   struct undo_object_deleter
+   {
+      void operator()( object* obj )const { obj->~object(); }
+   };
+   typedef std::unique_ptr<object, undo_object_deleter> undo_object_ptr;
+
    struct undo_state
    {
-      unordered_map<object_id_type, unique_ptr<object> > old_values;
-      unordered_map<object_id_type, object_id_type>      old_index_next_ids;
-      std::unordered_set<object_id_type>                 new_ids;
-      unordered_map<object_id_type, unique_ptr<object> > removed;
+      explicit undo_state( undo_block_pool* pool = nullptr ) : arena( pool ) {}
+
+      undo_object_ptr copy( const object& obj )
+      {
+         return undo_object_ptr( obj.clone_into( arena.allocate( obj.object_size() ) ) );
+      }
+
+      /** holds the memory of the object copies below, so it is declared first to be destroyed after them */
+      undo_arena                    arena;
+      flat_id_map<undo_object_ptr>  old_values;
+      flat_id_map<object_id_type>   old_index_next_ids;
+      flat_id_set                   new_ids;
+      flat_id_map<undo_object_ptr>  removed;
    };
 
 
@@ -132,6 +186,23 @@ namespace graphene { namespace db {
 
          const undo_state& head()const;
 
+         /** Running totals of the changes reported to on_create(), on_modify() and on_remove() */
+         struct change_counters
+         {
+            uint64_t created    = 0;
+            uint64_t modified   = 0;
+            uint64_t removed    = 0;
+            /** serialized size of the object copies saved for undo */
+            uint64_t undo_bytes = 0;
+         };
+
+         /**
+          * Counting undo_bytes serializes every saved object, so the counters are only maintained
+          * while enabled here.
+          */
+         void count_changes( bool enable ) { _count_changes = enable; }
+         const change_counters& changes()const { return _changes; }
+
       private:
          void undo();
          void merge();
@@ -139,9 +210,13 @@ namespace graphene { namespace db {
 
          uint32_t                _active_sessions = 0;
          bool                    _disabled = true;
+         /** declared before _stack, as the states return their blocks to it when destroyed */
+         undo_block_pool         _pool;
          std::deque<undo_state>  _stack;
          object_database&        _db;
          size_t                  _max_size = 256;
+         bool                    _count_changes = false;
+         change_counters         _changes;
    };
 
 } } // graphene::db
@@ -25,10 +25,62 @@
 
 #include <fc/io/raw.hpp>
 #include <fc/container/flat.hpp>
+#include <fc/thread/thread.hpp>
 #include <fc/uint128.hpp>
 
+#include <thread>
+
 namespace graphene { namespace db {
 
+namespace {
+   /**
+    * Runs the tasks on a pool of fc threads and waits for all of them.  The first failure is rethrown once every
+    * started task has finished, so none of them is left touching an index.
+    *
+    * If done is given, it is called on the calling thread for each task in order, as soon as that task and all
+    * tasks before it succeeded.  Only one task per thread is then started ahead of the one waited for, so that
+    * results waiting for done() do not pile up.  No task is started after a failure.
+    */
+   void run_in_parallel( const vector< std::function<void()> >& tasks,
+                         const std::function<void(size_t)>& done = std::function<void(size_t)>() )
+   {
+      if( tasks.empty() ) return;
+      const size_t num_threads = std::min<size_t>( std::max( 1u, std::thread::hardware_concurrency() ), tasks.size() );
+
+      vector< std::unique_ptr<fc::thread> > threads;
+      for( size_t i = 0; i < num_threads; ++i )
+         threads.emplace_back( new fc::thread( "object_database " + fc::to_string( uint64_t(i) ) ) );
+
+      vector< fc::future<void> > results;
+      results.reserve( tasks.size() );
+      auto start_next = [&]() {
+         const size_t i = results.size();
+         results.push_back( threads[i % num_threads]->async( tasks[i], "object_database io" ) );
+      };
+      const size_t ahead = done ? num_threads : tasks.size();
+      while( results.size() < ahead )
+         start_next();
+
+      std::exception_ptr error;
+      for( size_t i = 0; i < results.size(); ++i )
+      {
+         try {
+            results[i].wait();
+            if( done && !error )
+               done( i );
+         } catch( ... ) {
+            if( !error ) error = std::current_exception();
+         }
+         if( !error && results.size() < tasks.size() )
+            start_next();
+      }
+      for( auto& t : threads )
+         t->quit();
+      if( error )
+         std::rethrow_exception( error );
+   }
+}
+
 object_database::object_database()
 :_undo_db(*this)
 {
@@ -72,14 +124,20 @@ void object_database::flush()
 {
 //   ilog("Save object_database in ${d}", ("d", _data_dir));
    fc::create_directories( _data_dir / "object_database.tmp" / "lock" );
+   vector< std::function<void()> > tasks;
    for( uint32_t space = 0; space < _index.size(); ++space )
    {
       fc::create_directories( _data_dir / "object_database.tmp" / fc::to_string(space) );
       const auto types = _index[space].size();
       for( uint32_t type = 0; type  <  types; ++type )
          if( _index[space][type] )
-            _index[space][type]->save( _data_dir / "object_database.tmp" / fc::to_string(space)/fc::to_string(type) );
+         {
+            index* idx = _index[space][type].get();
+            fc::path file = _data_dir / "object_database.tmp" / fc::to_string(space)/fc::to_string(type);
+            tasks.push_back( [idx, file]() { idx->save( file ); } );
+         }
    }
+   run_in_parallel( tasks );
    fc::remove_all( _data_dir / "object_database.tmp" / "lock" );
    if( fc::exists( _data_dir / "object_database" ) )
       fc::rename( _data_dir / "object_database", _data_dir / "object_database.old" );
@@ -104,10 +162,21 @@ void object_database::open(const fc::path& data_dir)
        return;
    }
    ilog("Opening object database from ${d} ...", ("d", data_dir));
+   // files are decoded and verified concurrently, but inserted in order and one index at a time on this thread
+   // since secondary indexes may refer to each other.  Each index is inserted as soon as it is decoded, so only
+   // a few decoded files are held in memory next to the indexes.
+   vector< std::function<void()> > tasks;
+   vector< index* > indexes;
    for( uint32_t space = 0; space < _index.size(); ++space )
       for( uint32_t type = 0; type  < _index[space].size(); ++type )
          if( _index[space][type] )
-            _index[space][type]->open( _data_dir / "object_database" / fc::to_string(space)/fc::to_string(type) );
+         {
+            index* idx = _index[space][type].get();
+            fc::path file = _data_dir / "object_database" / fc::to_string(space)/fc::to_string(type);
+            tasks.push_back( [idx, file]() { idx->read_snapshot( file ); } );
+            indexes.push_back( idx );
+         }
+   run_in_parallel( tasks, [&indexes]( size_t i ) { indexes[i]->insert_snapshot(); } );
    ilog( "Done opening object database." );
 
 } FC_CAPTURE_AND_RETHROW( (data_dir) ) }
@@ -25,8 +25,72 @@
 #include <graphene/db/undo_database.hpp>
 #include <fc/reflect/variant.hpp>
 
+#include <cstddef>
+
 namespace graphene { namespace db {
 
+namespace {
+   /** blocks kept in undo_block_pool at most, the rest is freed */
+   const size_t max_pooled_blocks = 1024;
+   const size_t arena_alignment = alignof(std::max_align_t);
+}
+
+undo_block_pool::~undo_block_pool()
+{
+   for( char* b : blocks )
+      delete[] b;
+}
+
+void* undo_arena::allocate( size_t size )
+{
+   size = (size + arena_alignment - 1) & ~(arena_alignment - 1);
+   if( size > block_size )
+   {
+      _large.push_back( new char[size] );
+      return _large.back();
+   }
+   if( _used + size > block_size )
+   {
+      if( _pool && !_pool->blocks.empty() )
+      {
+         _blocks.push_back( _pool->blocks.back() );
+         _pool->blocks.pop_back();
+      }
+      else
+         _blocks.push_back( new char[block_size] );
+      _used = 0;
+   }
+   void* result = _blocks.back() + _used;
+   _used += size;
+   return result;
+}
+
+void undo_arena::splice( undo_arena& other )
+{
+   // keep our current block last, so allocation continues where it was
+   _blocks.insert( _blocks.begin(), other._blocks.begin(), other._blocks.end() );
+   _large.insert( _large.end(), other._large.begin(), other._large.end() );
+   other._blocks.clear();
+   other._large.clear();
+   other._used = block_size;
+}
+
+void undo_arena::reset()
+{
+   for( char* b : _blocks )
+   {
+      if( _pool && _pool->blocks.size() < max_pooled_blocks )
+         _pool->blocks.push_back( b );
+      else
+         delete[] b;
+   }
+   for( char* b : _large )
+      delete[] b;
+   _blocks.clear();
+   _large.clear();
+   _used = block_size;
+}
+
 void undo_database::enable()  { _disabled = false; }
 void undo_database::disable() { _disabled = true; }
 
@@ -40,16 +104,17 @@ undo_database::session undo_database::start_undo_session( bool force_enable )
    while( size() > max_size() )
       _stack.pop_front();
 
-   _stack.emplace_back();
+   _stack.emplace_back( &_pool );
    ++_active_sessions;
    return session(*this, disable_on_exit );
 }
 void undo_database::on_create( const object& obj )
 {
+   if( _count_changes ) ++_changes.created;
    if( _disabled ) return;
 
    if( _stack.empty() )
-      _stack.emplace_back();
+      _stack.emplace_back( &_pool );
    auto& state = _stack.back();
    auto index_id = object_id_type( obj.id.space(), obj.id.type(), 0 );
    auto itr = state.old_index_next_ids.find( index_id );
@@ -59,23 +124,26 @@ void undo_database::on_create( const object& obj )
 }
 void undo_database::on_modify( const object& obj )
 {
+   if( _count_changes ) ++_changes.modified;
    if( _disabled ) return;
 
    if( _stack.empty() )
-      _stack.emplace_back();
+      _stack.emplace_back( &_pool );
    auto& state = _stack.back();
    if( state.new_ids.find(obj.id) != state.new_ids.end() )
       return;
    auto itr =  state.old_values.find(obj.id);
    if( itr != state.old_values.end() ) return;
-   state.old_values[obj.id] = obj.clone();
+   state.old_values[obj.id] = state.copy( obj );
+   if( _count_changes ) _changes.undo_bytes += obj.pack().size();
 }
 void undo_database::on_remove( const object& obj )
 {
+   if( _count_changes ) ++_changes.removed;
    if( _disabled ) return;
 
    if( _stack.empty() )
-      _stack.emplace_back();
+      _stack.emplace_back( &_pool );
    undo_state& state = _stack.back();
    if( state.new_ids.count(obj.id) )
    {
@@ -89,7 +157,8 @@ void undo_database::on_remove( const object& obj )
       return;
    }
    if( state.removed.count(obj.id) ) return;
-   state.removed[obj.id] = obj.clone();
+   state.removed[obj.id] = state.copy( obj );
+   if( _count_changes ) _changes.undo_bytes += obj.pack().size();
 }
 
 void undo_database::undo()
@@ -239,6 +308,8 @@ void undo_database::merge()
       // nop + del(was=Y) -> del(was=Y)
       prev_state.removed[obj.second->id] = std::move(obj.second);
    }
+   // prev_state now holds objects copied into state's arena
+   prev_state.arena.splice( state.arena );
    _stack.pop_back();
    --_active_sessions;
 }
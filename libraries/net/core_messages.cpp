@@ -23,6 +23,8 @@
  */
 #include <graphene/net/core_messages.hpp>
 
+#include <cstring>
+
 
 namespace graphene { namespace net {
 
@@ -45,6 +47,32 @@ namespace graphene { namespace net {
   const core_message_type_enum check_firewall_reply_message::type            = core_message_type_enum::check_firewall_reply_message_type;
   const core_message_type_enum get_current_connections_request_message::type = core_message_type_enum::get_current_connections_request_message_type;
   const core_message_type_enum get_current_connections_reply_message::type   = core_message_type_enum::get_current_connections_reply_message_type;
+  const core_message_type_enum compact_block_message::type                   = core_message_type_enum::compact_block_message_type;
+  const core_message_type_enum fetch_compact_block_transactions_message::type = core_message_type_enum::fetch_compact_block_transactions_message_type;
+  const core_message_type_enum compact_block_transactions_message::type      = core_message_type_enum::compact_block_transactions_message_type;
+
+  short_transaction_id_type get_short_transaction_id( const transaction_id_type& id )
+  {
+    short_transaction_id_type short_id;
+    static_assert(sizeof(short_id) <= sizeof(id), "short transaction id must be a prefix of the transaction id");
+    memcpy(&short_id, id.data(), sizeof(short_id));
+    return short_id;
+  }
+
+  compact_block_message::compact_block_message(const signed_block& block, const block_id_type& block_id,
+                                               const item_hash_t& item_hash) :
+    header(block),
+    block_id(block_id),
+    item_hash(item_hash)
+  {
+    short_transaction_ids.reserve(block.transactions.size());
+    operation_results.reserve(block.transactions.size());
+    for (const graphene::chain::processed_transaction& trx : block.transactions)
+    {
+      short_transaction_ids.push_back(get_short_transaction_id(trx.id()));
+      operation_results.push_back(trx.operation_results);
+    }
+  }
 
 } } // graphene::net
 
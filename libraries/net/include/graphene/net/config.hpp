@@ -106,3 +106,15 @@
 #define GRAPHENE_NET_MIN_BLOCK_IDS_TO_PREFETCH               10000
 
 #define GRAPHENE_NET_MAX_TRX_PER_SECOND                      1000
+
+/**
+ * How many compact blocks we will hold per peer while we fetch the transactions
+ * we were missing from them.  Past this, we fetch compact blocks in full.
+ */
+#define GRAPHENE_NET_MAX_COMPACT_BLOCKS_AWAITING_TRANSACTIONS    4
+
+/**
+ * How long we wait for the missing transactions of a compact block before we give up on
+ * them and fetch the block in full.
+ */
+#define GRAPHENE_NET_COMPACT_BLOCK_TRANSACTIONS_TIMEOUT          5 // seconds
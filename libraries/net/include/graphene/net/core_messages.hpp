@@ -44,6 +44,8 @@ namespace graphene { namespace net {
   using graphene::chain::block_id_type;
   using graphene::chain::transaction_id_type;
   using graphene::chain::signed_block;
+  using graphene::chain::signed_block_header;
+  using graphene::chain::operation_result;
 
   typedef fc::ecc::public_key_data node_id_t;
   typedef fc::ripemd160 item_hash_t;
@@ -86,6 +88,9 @@ namespace graphene { namespace net {
     check_firewall_reply_message_type            = 5015,
     get_current_connections_request_message_type = 5016,
     get_current_connections_reply_message_type   = 5017,
+    compact_block_message_type                   = 5018,
+    fetch_compact_block_transactions_message_type = 5019,
+    compact_block_transactions_message_type      = 5020,
     core_message_type_last                       = 5099
   };
 
@@ -115,6 +120,68 @@ namespace graphene { namespace net {
 
    };
 
+  /**
+   * The first 8 bytes of a transaction id.  Compact blocks refer to their transactions by these,
+   * a collision only costs the receiver a fetch of the full block because the rebuilt block
+   * must still match the transaction_merkle_root in its header.
+   */
+  typedef uint64_t short_transaction_id_type;
+  short_transaction_id_type get_short_transaction_id( const transaction_id_type& id );
+
+  /**
+   * A block sent as its header plus short ids of its transactions, to a peer which said in its
+   * hello_message that it understands them.  The peer has nearly always seen the transactions
+   * already, and rebuilds the block from its message cache.  operation_results are only known
+   * once the block is produced, so they travel with the compact block.
+   */
+  struct compact_block_message
+  {
+    static const core_message_type_enum type;
+
+    signed_block_header                              header;
+    block_id_type                                    block_id;
+    /** the hash of the block_message this stands in for, as it was requested in the fetch_items_message */
+    item_hash_t                                      item_hash;
+    std::vector<short_transaction_id_type>           short_transaction_ids;
+    std::vector<std::vector<operation_result> >      operation_results;
+
+    compact_block_message() {}
+    compact_block_message(const signed_block& block, const block_id_type& block_id, const item_hash_t& item_hash);
+  };
+
+  /** asks the peer which sent us a compact block for the transactions we could not find */
+  struct fetch_compact_block_transactions_message
+  {
+    static const core_message_type_enum type;
+
+    block_id_type         block_id;
+    std::vector<uint32_t> transaction_indices;
+
+    fetch_compact_block_transactions_message() {}
+    fetch_compact_block_transactions_message(const block_id_type& block_id,
+                                             const std::vector<uint32_t>& transaction_indices) :
+      block_id(block_id),
+      transaction_indices(transaction_indices)
+    {}
+  };
+
+  /**
+   * reply to fetch_compact_block_transactions_message, in the order they were asked for.  Empty
+   * if the block is no longer available, in which case the full block should be fetched by id.
+   */
+  struct compact_block_transactions_message
+  {
+    static const core_message_type_enum type;
+
+    block_id_type                   block_id;
+    std::vector<signed_transaction> transactions;
+
+    compact_block_transactions_message() {}
+    compact_block_transactions_message(const block_id_type& block_id) :
+      block_id(block_id)
+    {}
+  };
+
   struct item_ids_inventory_message
   {
     static const core_message_type_enum type;
@@ -424,10 +491,22 @@ FC_REFLECT_ENUM( graphene::net::core_message_type_enum,
                  (check_firewall_reply_message_type)
                  (get_current_connections_request_message_type)
                  (get_current_connections_reply_message_type)
+                 (compact_block_message_type)
+                 (fetch_compact_block_transactions_message_type)
+                 (compact_block_transactions_message_type)
                  (core_message_type_last) )
 
 FC_REFLECT( graphene::net::trx_message, (trx) )
 FC_REFLECT( graphene::net::block_message, (block)(block_id) )
+FC_REFLECT( graphene::net::compact_block_message, (header)
+                                             (block_id)
+                                             (item_hash)
+                                             (short_transaction_ids)
+                                             (operation_results) )
+FC_REFLECT( graphene::net::fetch_compact_block_transactions_message, (block_id)
+                                                                (transaction_indices) )
+FC_REFLECT( graphene::net::compact_block_transactions_message, (block_id)
+                                                          (transactions) )
 
 FC_REFLECT( graphene::net::item_id, (item_type)
                                (item_hash) )
@@ -56,10 +56,10 @@ namespace graphene { namespace net {
      message(){}
 
      message( message&& m )
-     :message_header(m),data( std::move(m.data) ){}
+     :message_header(m),data( std::move(m.data) ),_id( m._id ),_has_id( m._has_id ){}
 
      message( const message& m )
-     :message_header(m),data( m.data ){}
+     :message_header(m),data( m.data ),_id( m._id ),_has_id( m._has_id ){}
 
      /**
       *  Assumes that T::type specifies the message type
@@ -74,9 +74,21 @@ namespace graphene { namespace net {
 
      fc::uint160_t id()const
      {
+        if( _has_id )
+           return _id;
         return fc::ripemd160::hash( data.data(), (uint32_t)data.size() );
      }
 
+     /**
+      *  Keeps id(), so that a connection can hash a message on its I/O thread
+      *  before handing it on.  data must not change afterwards.
+      */
+     void cache_id()
+     {
+        _id = id();
+        _has_id = true;
+     }
+
      /**
       *  Automatically checks the type and deserializes T in the
       *  opposite process from the constructor.
@@ -106,6 +118,10 @@ namespace graphene { namespace net {
               ("msg_type", msg_type)
               );
      }
+
+  private:
+     fc::uint160_t _id;
+     bool          _has_id = false;
   };
 
 
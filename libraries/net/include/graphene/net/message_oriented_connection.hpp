@@ -25,6 +25,8 @@
 #include <fc/network/tcp_socket.hpp>
 #include <graphene/net/message.hpp>
 
+namespace fc { class thread; }
+
 namespace graphene { namespace net {
 
   namespace detail { class message_oriented_connection_impl; }
@@ -39,11 +41,17 @@ namespace graphene { namespace net {
     virtual void on_connection_closed(message_oriented_connection* originating_connection) = 0;
   };
 
-  /** uses a secure socket to create a connection that reads and writes a stream of `fc::net::message` objects */
+  /**
+   * uses a secure socket to create a connection that reads and writes a stream of `fc::net::message` objects
+   *
+   * If @p io_thread is given, the socket I/O, framing, encryption and hashing of messages run on it.  The
+   * delegate is still called, and the methods must still be called, on the thread that created the connection.
+   */
   class message_oriented_connection
   {
      public:
-       message_oriented_connection(message_oriented_connection_delegate* delegate = nullptr);
+       message_oriented_connection(message_oriented_connection_delegate* delegate = nullptr,
+                                   fc::thread* io_thread = nullptr);
        ~message_oriented_connection();
        fc::tcp_socket& get_socket();
 
@@ -52,6 +60,8 @@ namespace graphene { namespace net {
        void connect_to(const fc::ip::endpoint& remote_endpoint);
 
        void send_message(const message& message_to_send);
+       /** with an I/O thread, returns once the message is queued for it */
+       void send_message(message&& message_to_send);
        void close_connection();
        void destroy_connection();
 
@@ -285,6 +285,13 @@ namespace graphene { namespace net {
 
         void set_total_bandwidth_limit(uint32_t upload_bytes_per_second, uint32_t download_bytes_per_second);
 
+        /**
+         * Spreads the socket I/O, encryption and message framing of peer connections over this many threads,
+         * which hand whole messages to the p2p thread.  0, the default, does it all on the p2p thread.
+         * Only affects connections made after the call, so call it before listening or connecting.
+         */
+        void set_io_thread_count(uint32_t num_threads);
+
         fc::variant_object network_get_info() const;
         fc::variant_object network_get_usage_stats() const;
 
@@ -40,6 +40,7 @@
 #include <boost/multi_index/sequenced_index.hpp>
 #include <boost/multi_index/hashed_index.hpp>
 
+#include <map>
 #include <queue>
 #include <boost/container/deque.hpp>
 #include <fc/thread/future.hpp>
@@ -207,6 +208,7 @@ namespace graphene { namespace net
       fc::optional<fc::time_point_sec> fc_git_revision_unix_timestamp;
       fc::optional<std::string> platform;
       fc::optional<uint32_t> bitness;
+      bool             supports_compact_blocks; /// set if the hello_message says the peer accepts compact_block_messages
 
       // for inbound connections, these fields record what the peer sent us in
       // its hello message.  For outbound, they record what we sent the peer
@@ -254,6 +256,16 @@ namespace graphene { namespace net
       timestamped_items_set_type inventory_advertised_to_peer;
 
       item_to_time_map_type items_requested_from_peer;  /// items we've requested from this peer during normal operation.  fetch from another peer if this peer disconnects
+
+      /** compact blocks this peer sent us which we are rebuilding, waiting for the transactions we didn't
+       * have.  The slots of missing_transaction_indices in block.transactions hold only the operation_results */
+      struct compact_block_awaiting_transactions
+      {
+        block_message         block;
+        std::vector<uint32_t> missing_transaction_indices;
+        fc::time_point        transactions_requested_time;
+      };
+      std::map<block_id_type, compact_block_awaiting_transactions> compact_blocks_awaiting_transactions;
       /// @}
 
       // if they're flooding us with transactions, we set this to avoid fetching for a few seconds to let the
@@ -272,10 +284,11 @@ namespace graphene { namespace net
 #endif
       bool _currently_handling_message; // true while we're in the middle of handling a message from the remote system
     private:
-      peer_connection(peer_connection_delegate* delegate);
+      peer_connection(peer_connection_delegate* delegate, fc::thread* io_thread);
       void destroy();
     public:
-      static peer_connection_ptr make_shared(peer_connection_delegate* delegate); // use this instead of the constructor
+      /// use this instead of the constructor.  io_thread, if given, does the connection's socket I/O, see message_oriented_connection
+      static peer_connection_ptr make_shared(peer_connection_delegate* delegate, fc::thread* io_thread = nullptr);
       virtual ~peer_connection();
 
       fc::tcp_socket& get_socket();
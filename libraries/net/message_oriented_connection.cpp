@@ -39,8 +39,10 @@
 
 #ifndef NDEBUG
 # define VERIFY_CORRECT_THREAD() assert(_thread->is_current())
+# define VERIFY_IO_THREAD() assert(_io_thread ? _io_thread->is_current() : _thread->is_current())
 #else
 # define VERIFY_CORRECT_THREAD() do {} while (0)
+# define VERIFY_IO_THREAD() do {} while (0)
 #endif
 
 namespace graphene { namespace net {
@@ -62,12 +64,24 @@ namespace graphene { namespace net {
 
       bool _send_message_in_progress;
 
-#ifndef NDEBUG
+      /* the thread the delegate is called on and the public methods are called from */
       fc::thread* _thread;
-#endif
+
+      /* if set, the key exchange, the read loop and the framing, encryption and hashing of
+       * messages run on this thread, and only whole messages cross over to _thread.  The members
+       * above, other than _sock, are only touched on _thread */
+      fc::thread* _io_thread;
+      fc::future<void> _send_message_done; /// the last write queued on _io_thread, if any
+      fc::future<void> _previous_message_delivered; /// only touched on _io_thread while the read loop runs
+      bool _closing; /// set in destroy_connection(), stops messages still queued for the delegate
 
       void read_loop();
       void start_read_loop();
+      void deliver_message(message&& received_message, uint64_t bytes_received);
+      void deliver_connection_closed();
+      void write_message(const message& message_to_send);
+      template<typename Functor>
+      void run_on_io_thread(Functor&& f, const char* description);
     public:
       fc::tcp_socket& get_socket();
       void accept();
@@ -75,10 +89,11 @@ namespace graphene { namespace net {
       void bind(const fc::ip::endpoint& local_endpoint);
 
       message_oriented_connection_impl(message_oriented_connection* self,
-                                       message_oriented_connection_delegate* delegate = nullptr);
+                                       message_oriented_connection_delegate* delegate = nullptr,
+                                       fc::thread* io_thread = nullptr);
       ~message_oriented_connection_impl();
 
-      void send_message(const message& message_to_send);
+      void send_message(message&& message_to_send);
       void close_connection();
       void destroy_connection();
 
@@ -92,15 +107,16 @@ namespace graphene { namespace net {
     };
 
     message_oriented_connection_impl::message_oriented_connection_impl(message_oriented_connection* self,
-                                                                       message_oriented_connection_delegate* delegate)
+                                                                       message_oriented_connection_delegate* delegate,
+                                                                       fc::thread* io_thread)
     : _self(self),
       _delegate(delegate),
       _bytes_received(0),
       _bytes_sent(0),
-      _send_message_in_progress(false)
-#ifndef NDEBUG
-      ,_thread(&fc::thread::current())
-#endif
+      _send_message_in_progress(false),
+      _thread(&fc::thread::current()),
+      _io_thread(io_thread),
+      _closing(false)
     {
     }
     message_oriented_connection_impl::~message_oriented_connection_impl()
@@ -115,20 +131,33 @@ namespace graphene { namespace net {
       return _sock.get_socket();
     }
 
+    template<typename Functor>
+    void message_oriented_connection_impl::run_on_io_thread(Functor&& f, const char* description)
+    {
+      if (_io_thread)
+        _io_thread->async(std::forward<Functor>(f), description).wait();
+      else
+        f();
+    }
+
     void message_oriented_connection_impl::accept()
     {
       VERIFY_CORRECT_THREAD();
-      _sock.accept();
+      run_on_io_thread([this](){ _sock.accept(); }, "stcp key exchange");
       assert(!_read_loop_done.valid()); // check to be sure we never launch two read loops
-      _read_loop_done = fc::async([=](){ read_loop(); }, "message read_loop");
+      _connected_time = fc::time_point::now();
+      fc::thread& read_thread = _io_thread ? *_io_thread : fc::thread::current();
+      _read_loop_done = read_thread.async([=](){ read_loop(); }, "message read_loop");
     }
 
     void message_oriented_connection_impl::connect_to(const fc::ip::endpoint& remote_endpoint)
     {
       VERIFY_CORRECT_THREAD();
-      _sock.connect_to(remote_endpoint);
+      run_on_io_thread([this, remote_endpoint](){ _sock.connect_to(remote_endpoint); }, "stcp connect");
       assert(!_read_loop_done.valid()); // check to be sure we never launch two read loops
-      _read_loop_done = fc::async([=](){ read_loop(); }, "message read_loop");
+      _connected_time = fc::time_point::now();
+      fc::thread& read_thread = _io_thread ? *_io_thread : fc::thread::current();
+      _read_loop_done = read_thread.async([=](){ read_loop(); }, "message read_loop");
     }
 
     void message_oriented_connection_impl::bind(const fc::ip::endpoint& local_endpoint)
@@ -140,24 +169,22 @@ namespace graphene { namespace net {
 
     void message_oriented_connection_impl::read_loop()
     {
-      VERIFY_CORRECT_THREAD();
+      VERIFY_IO_THREAD();
       const int BUFFER_SIZE = 16;
       const int LEFTOVER = BUFFER_SIZE - sizeof(message_header);
       static_assert(BUFFER_SIZE >= sizeof(message_header), "insufficient buffer");
 
-      _connected_time = fc::time_point::now();
-
       fc::oexception exception_to_rethrow;
       bool call_on_connection_closed = false;
 
       try
       {
-        message m;
         while( true )
         {
+          message m;
+          uint64_t bytes_received = BUFFER_SIZE;
           char buffer[BUFFER_SIZE];
           _sock.read(buffer, BUFFER_SIZE);
-          _bytes_received += BUFFER_SIZE;
           memcpy((char*)&m, buffer, sizeof(message_header));
 
           FC_ASSERT( m.size <= MAX_MESSAGE_SIZE, "", ("m.size",m.size)("MAX_MESSAGE_SIZE",MAX_MESSAGE_SIZE) );
@@ -168,16 +195,14 @@ namespace graphene { namespace net {
           if (remaining_bytes_with_padding)
           {
             _sock.read(&m.data[LEFTOVER], remaining_bytes_with_padding);
-            _bytes_received += remaining_bytes_with_padding;
+            bytes_received += remaining_bytes_with_padding;
           }
           m.data.resize(m.size); // truncate off the padding bytes
 
-          _last_message_received_time = fc::time_point::now();
-
           try
           {
             // message handling errors are warnings...
-            _delegate->on_message(_self, m);
+            deliver_message(std::move(m), bytes_received);
           }
           /// Dedicated catches needed to distinguish from general fc::exception
           catch ( const fc::canceled_exception& e ) { throw; }
@@ -220,13 +245,65 @@ namespace graphene { namespace net {
       }
 
       if (call_on_connection_closed)
-        _delegate->on_connection_closed(_self);
+        deliver_connection_closed();
 
       if (exception_to_rethrow)
         throw *exception_to_rethrow;
     }
 
-    void message_oriented_connection_impl::send_message(const message& message_to_send)
+    void message_oriented_connection_impl::deliver_message(message&& received_message, uint64_t bytes_received)
+    {
+      VERIFY_IO_THREAD();
+      if (!_io_thread)
+      {
+        _bytes_received += bytes_received;
+        _last_message_received_time = fc::time_point::now();
+        _delegate->on_message(_self, received_message);
+        return;
+      }
+
+      // hash the message here so the delegate doesn't have to, then hand it over.  We read and decrypt
+      // the next message while the delegate handles this one, but no further, so a peer can't queue up
+      // more than one message on _thread.  An exception from the delegate ends the read loop as before,
+      // just one message later
+      received_message.cache_id();
+      if (_previous_message_delivered.valid())
+        _previous_message_delivered.wait();
+      auto message_to_deliver = std::make_shared<message>(std::move(received_message));
+      _previous_message_delivered = _thread->async([this, message_to_deliver, bytes_received]() {
+        if (_closing)
+          return;
+        _bytes_received += bytes_received;
+        _last_message_received_time = fc::time_point::now();
+        _delegate->on_message(_self, *message_to_deliver);
+      }, "deliver message");
+    }
+
+    void message_oriented_connection_impl::deliver_connection_closed()
+    {
+      VERIFY_IO_THREAD();
+      if (!_io_thread)
+      {
+        _delegate->on_connection_closed(_self);
+        return;
+      }
+      try
+      {
+        if (_previous_message_delivered.valid())
+          _previous_message_delivered.wait();
+      }
+      catch (const fc::exception&)
+      {
+        // the connection is closing anyway
+      }
+      _previous_message_delivered = _thread->async([this]() {
+        if (!_closing)
+          _delegate->on_connection_closed(_self);
+      }, "deliver connection closed");
+      _previous_message_delivered.wait();
+    }
+
+    void message_oriented_connection_impl::send_message(message&& message_to_send)
     {
       VERIFY_CORRECT_THREAD();
 #if 0 // this gets too verbose
@@ -258,22 +335,45 @@ namespace graphene { namespace net {
         size_t size_of_message_and_header = sizeof(message_header) + message_to_send.size;
         if( message_to_send.size > MAX_MESSAGE_SIZE )
            elog("Trying to send a message larger than MAX_MESSAGE_SIZE. This probably won't work...");
+        if (_io_thread)
+        {
+          // we return once the message is queued, and only wait for the write before it, so the next
+          // message is prepared while this one goes out but no more pile up here than in peer_connection's
+          // queue.  A failed write is reported by the next call
+          if (_send_message_done.valid())
+            _send_message_done.wait();
+          // the io task owns the message, it may outlive this call if the calling task is canceled.
+          // destroy_connection() waits for it
+          auto message_to_write = std::make_shared<message>(std::move(message_to_send));
+          _send_message_done = _io_thread->async([this, message_to_write]() { write_message(*message_to_write); }, "send message");
+        }
+        else
+          write_message(message_to_send);
         //pad the message we send to a multiple of 16 bytes
         size_t size_with_padding = 16 * ((size_of_message_and_header + 15) / 16);
-        std::unique_ptr<char[]> padded_message(new char[size_with_padding]);
-        memcpy(padded_message.get(), (char*)&message_to_send, sizeof(message_header));
-        memcpy(padded_message.get() + sizeof(message_header), message_to_send.data.data(), message_to_send.size );
-        _sock.write(padded_message.get(), size_with_padding);
-        _sock.flush();
         _bytes_sent += size_with_padding;
         _last_message_sent_time = fc::time_point::now();
       } FC_RETHROW_EXCEPTIONS( warn, "unable to send message" );
     }
 
+    void message_oriented_connection_impl::write_message(const message& message_to_send)
+    {
+      VERIFY_IO_THREAD();
+      size_t size_of_message_and_header = sizeof(message_header) + message_to_send.size;
+      //pad the message we send to a multiple of 16 bytes
+      size_t size_with_padding = 16 * ((size_of_message_and_header + 15) / 16);
+      std::unique_ptr<char[]> padded_message(new char[size_with_padding]);
+      memcpy(padded_message.get(), (char*)&message_to_send, sizeof(message_header));
+      memcpy(padded_message.get() + sizeof(message_header), message_to_send.data.data(), message_to_send.size );
+      _sock.write(padded_message.get(), size_with_padding);
+      _sock.flush();
+    }
+
     void message_oriented_connection_impl::close_connection()
     {
       VERIFY_CORRECT_THREAD();
-      _sock.close();
+      // the read loop and the writes use the socket on _io_thread
+      run_on_io_thread([this](){ _sock.close(); }, "close socket");
     }
 
     void message_oriented_connection_impl::destroy_connection()
@@ -290,6 +390,25 @@ namespace graphene { namespace net {
              "The task calling send_message() should have been canceled already");
       assert(!_send_message_in_progress);
 
+      // messages already handed to _thread must not reach a delegate which is going away
+      _closing = true;
+
+      if (_send_message_done.valid() && !_send_message_done.ready())
+      {
+        try
+        {
+          _send_message_done.cancel_and_wait(__FUNCTION__);
+        }
+        catch ( const fc::exception& e )
+        {
+          wlog( "Exception thrown while canceling message_oriented_connection's send, ignoring: ${e}", ("e",e) );
+        }
+        catch (...)
+        {
+          wlog( "Exception thrown while canceling message_oriented_connection's send, ignoring" );
+        }
+      }
+
       try
       {
         _read_loop_done.cancel_and_wait(__FUNCTION__);
@@ -302,6 +421,19 @@ namespace graphene { namespace net {
       {
         wlog( "Exception thrown while canceling message_oriented_connection's read_loop, ignoring" );
       }
+
+      // the read loop is done, so nothing else touches this.  A delivery may still be queued on this
+      // thread, let it run (and do nothing) before we go away
+      if (_previous_message_delivered.valid() && !_previous_message_delivered.ready())
+      {
+        try
+        {
+          _previous_message_delivered.cancel_and_wait(__FUNCTION__);
+        }
+        catch (...)
+        {
+        }
+      }
     }
 
     uint64_t message_oriented_connection_impl::get_total_bytes_sent() const
@@ -337,8 +469,9 @@ namespace graphene { namespace net {
   } // end namespace graphene::net::detail
 
 
-  message_oriented_connection::message_oriented_connection(message_oriented_connection_delegate* delegate) :
-    my(new detail::message_oriented_connection_impl(this, delegate))
+  message_oriented_connection::message_oriented_connection(message_oriented_connection_delegate* delegate,
+                                                           fc::thread* io_thread) :
+    my(new detail::message_oriented_connection_impl(this, delegate, io_thread))
   {
   }
 
@@ -368,7 +501,12 @@ namespace graphene { namespace net {
 
   void message_oriented_connection::send_message(const message& message_to_send)
   {
-    my->send_message(message_to_send);
+    my->send_message(message(message_to_send));
+  }
+
+  void message_oriented_connection::send_message(message&& message_to_send)
+  {
+    my->send_message(std::move(message_to_send));
   }
 
   void message_oriented_connection::close_connection()
@@ -132,11 +132,13 @@ namespace graphene { namespace net {
       struct message_hash_index{};
       struct message_contents_hash_index{};
       struct block_clock_index{};
+      struct short_transaction_id_index{};
       struct message_info
       {
         message_hash_type message_hash;
         message           message_body;
         uint32_t          block_clock_when_received;
+        short_transaction_id_type short_transaction_id; // for transactions, used to rebuild compact blocks; 0 otherwise
 
         // for network performance stats
         message_propagation_data propagation_data;
@@ -150,6 +152,7 @@ namespace graphene { namespace net {
           message_hash( message_hash ),
           message_body( message_body ),
           block_clock_when_received( block_clock_when_received ),
+          short_transaction_id( message_body.msg_type == trx_message_type ? get_short_transaction_id( message_contents_hash ) : 0 ),
           propagation_data( propagation_data ),
           message_contents_hash( message_contents_hash )
         {}
@@ -161,7 +164,9 @@ namespace graphene { namespace net {
                              bmi::ordered_non_unique< bmi::tag<message_contents_hash_index>,
                                                       bmi::member<message_info, fc::uint160_t, &message_info::message_contents_hash> >,
                              bmi::ordered_non_unique< bmi::tag<block_clock_index>,
-                                                      bmi::member<message_info, uint32_t, &message_info::block_clock_when_received> > >
+                                                      bmi::member<message_info, uint32_t, &message_info::block_clock_when_received> >,
+                             bmi::ordered_non_unique< bmi::tag<short_transaction_id_index>,
+                                                      bmi::member<message_info, short_transaction_id_type, &message_info::short_transaction_id> > >
         > message_cache_container;
 
       message_cache_container _message_cache;
@@ -177,6 +182,7 @@ namespace graphene { namespace net {
                         const message_propagation_data& propagation_data, const fc::uint160_t& message_content_hash );
       message get_message( const message_hash_type& hash_of_message_to_lookup );
       message_propagation_data get_message_propagation_data( const fc::uint160_t& hash_of_message_contents_to_lookup ) const;
+      fc::optional<signed_transaction> get_transaction_by_short_id( short_transaction_id_type short_id ) const;
       size_t size() const { return _message_cache.size(); }
     };
 
@@ -221,6 +227,24 @@ namespace graphene { namespace net {
       FC_THROW_EXCEPTION(  fc::key_not_found_exception, "Requested message not in cache" );
     }
 
+    fc::optional<signed_transaction> blockchain_tied_message_cache::get_transaction_by_short_id( short_transaction_id_type short_id ) const
+    {
+      // the same transaction may be cached more than once, but if two different transactions share the
+      // short id we can't tell which one the block holds, and treat it as missing
+      fc::optional<signed_transaction> result;
+      auto range = _message_cache.get<short_transaction_id_index>().equal_range( short_id );
+      for( auto iter = range.first; iter != range.second; ++iter )
+      {
+        if( iter->message_body.msg_type != trx_message_type )
+          continue;
+        if( result && result->id() != iter->message_contents_hash )
+          return fc::optional<signed_transaction>();
+        if( !result )
+          result = iter->message_body.as<trx_message>().trx;
+      }
+      return result;
+    }
+
 /////////////////////////////////////////////////////////////////////////////////////////////////////////
 
     // This specifies configuration info for the local node.  It's stored as JSON
@@ -529,6 +553,14 @@ namespace graphene { namespace net { namespace detail {
 
       blockchain_tied_message_cache _message_cache; /// cache message we have received and might be required to provide to other peers via inventory requests
 
+      /// compact block relay stats, reported by network_get_info()
+      /// @{
+      uint32_t _compact_blocks_sent;
+      uint32_t _compact_blocks_received;
+      uint32_t _compact_block_transactions_fetched; /// transactions we didn't have when a compact block arrived
+      uint32_t _compact_block_fallbacks; /// compact blocks we couldn't rebuild and fetched in full instead
+      /// @}
+
       fc::rate_limiting_group _rate_limiter;
 
       uint32_t _last_reported_number_of_connections; // number of connections last reported to the client (to avoid sending duplicate messages)
@@ -578,6 +610,11 @@ namespace graphene { namespace net { namespace detail {
 
       std::list<fc::future<void> > _handle_message_calls_in_progress;
 
+      /// threads doing the socket I/O of peer connections, assigned to new connections in turn.  Empty if the
+      /// p2p thread does it all
+      std::vector<std::unique_ptr<fc::thread> > _io_threads;
+      uint32_t _next_io_thread;
+
       node_impl(const std::string& user_agent);
       virtual ~node_impl();
 
@@ -679,6 +716,19 @@ namespace graphene { namespace net { namespace detail {
 
       void on_connection_closed(peer_connection* originating_peer) override;
 
+      void on_compact_block_message(peer_connection* originating_peer,
+                                    const compact_block_message& compact_block_message_received);
+
+      void on_fetch_compact_block_transactions_message(peer_connection* originating_peer,
+                                                       const fetch_compact_block_transactions_message& fetch_compact_block_transactions_message_received);
+
+      void on_compact_block_transactions_message(peer_connection* originating_peer,
+                                                 const compact_block_transactions_message& compact_block_transactions_message_received);
+
+      void process_rebuilt_compact_block(peer_connection* originating_peer, const graphene::net::block_message& rebuilt_block);
+      void expire_compact_blocks_awaiting_transactions(peer_connection* peer);
+      void fetch_full_block_instead_of_compact_block(peer_connection* originating_peer, const block_id_type& block_id);
+
       void send_sync_block_to_node_delegate(const graphene::net::block_message& block_message_to_send);
       void process_backlog_of_sync_blocks();
       void trigger_process_backlog_of_sync_blocks();
@@ -748,6 +798,8 @@ namespace graphene { namespace net { namespace detail {
       void                       set_allowed_peers( const std::vector<node_id_t>& allowed_peers );
       void                       clear_peer_database();
       void                       set_total_bandwidth_limit( uint32_t upload_bytes_per_second, uint32_t download_bytes_per_second );
+      void                       set_io_thread_count( uint32_t num_threads );
+      fc::thread*                get_io_thread_for_new_peer();
       void                       disable_peer_advertising();
       fc::variant_object         get_call_statistics() const;
       message                    get_message_for_item(const item_id& item) override;
@@ -810,6 +862,10 @@ namespace graphene { namespace net { namespace detail {
       _peer_inactivity_timeout(GRAPHENE_NET_PEER_HANDSHAKE_INACTIVITY_TIMEOUT),
       _most_recent_blocks_accepted(_maximum_number_of_connections),
       _total_number_of_unfetched_items(0),
+      _compact_blocks_sent(0),
+      _compact_blocks_received(0),
+      _compact_block_transactions_fetched(0),
+      _compact_block_fallbacks(0),
       _rate_limiter(0, 0),
       _last_reported_number_of_connections(0),
       _peer_advertising_disabled(false),
@@ -824,7 +880,8 @@ namespace graphene { namespace net { namespace detail {
       _node_is_shutting_down(false),
       _maximum_number_of_blocks_to_handle_at_one_time(MAXIMUM_NUMBER_OF_BLOCKS_TO_HANDLE_AT_ONE_TIME),
       _maximum_number_of_sync_blocks_to_prefetch(MAXIMUM_NUMBER_OF_BLOCKS_TO_PREFETCH),
-      _maximum_blocks_per_peer_during_syncing(GRAPHENE_NET_MAX_BLOCKS_PER_PEER_DURING_SYNCING)
+      _maximum_blocks_per_peer_during_syncing(GRAPHENE_NET_MAX_BLOCKS_PER_PEER_DURING_SYNCING),
+      _next_io_thread(0)
     {
       _rate_limiter.set_actual_rate_time_constant(fc::seconds(2));
       fc::rand_pseudo_bytes(&_node_id.data[0], (int)_node_id.size());
@@ -859,6 +916,8 @@ namespace graphene { namespace net { namespace detail {
       {
         wlog( "unexpected exception on close ${e}", ("e", e) );
       }
+      for (const std::unique_ptr<fc::thread>& io_thread : _io_threads)
+        io_thread->quit();
       ilog( "done" );
     }
 
@@ -1820,6 +1879,15 @@ namespace graphene { namespace net { namespace detail {
       case core_message_type_enum::get_current_connections_reply_message_type:
         on_get_current_connections_reply_message(originating_peer, received_message.as<get_current_connections_reply_message>());
         break;
+      case core_message_type_enum::compact_block_message_type:
+        on_compact_block_message(originating_peer, received_message.as<compact_block_message>());
+        break;
+      case core_message_type_enum::fetch_compact_block_transactions_message_type:
+        on_fetch_compact_block_transactions_message(originating_peer, received_message.as<fetch_compact_block_transactions_message>());
+        break;
+      case core_message_type_enum::compact_block_transactions_message_type:
+        on_compact_block_transactions_message(originating_peer, received_message.as<compact_block_transactions_message>());
+        break;
 
       default:
         // ignore any message in between core_message_type_first and _last that we don't handle above
@@ -1852,6 +1920,7 @@ namespace graphene { namespace net { namespace detail {
       user_data["platform"] = "other";
 #endif
       user_data["bitness"] = sizeof(void*) * 8;
+      user_data["compact_blocks"] = true;
 
       user_data["node_id"] = _node_id;
 
@@ -1885,6 +1954,8 @@ namespace graphene { namespace net { namespace detail {
         originating_peer->node_id = user_data["node_id"].as<node_id_t>();
       if (user_data.contains("last_known_fork_block_number"))
         originating_peer->last_known_fork_block_number = user_data["last_known_fork_block_number"].as<uint32_t>();
+      if (user_data.contains("compact_blocks"))
+        originating_peer->supports_compact_blocks = user_data["compact_blocks"].as<bool>();
     }
 
     void node_impl::on_hello_message( peer_connection* originating_peer, const hello_message& hello_message_received )
@@ -2771,9 +2842,20 @@ namespace graphene { namespace net { namespace detail {
           dlog("received item request for item ${id} from peer ${endpoint}, returning the item from my message cache",
                ("endpoint", originating_peer->get_remote_endpoint())
                ("id", requested_message.id()));
-          reply_messages.push_back(requested_message);
           if (fetch_items_message_received.item_type == block_message_type)
+          {
             last_block_message_sent = requested_message;
+            // blocks are only in the cache while they're new, so the peer has most likely seen their
+            // transactions already.  Blocks fetched by id while syncing come from the delegate in full.
+            if (originating_peer->supports_compact_blocks)
+            {
+              graphene::net::block_message block_to_send = requested_message.as<graphene::net::block_message>();
+              reply_messages.push_back(compact_block_message(block_to_send.block, block_to_send.block_id, item_hash));
+              ++_compact_blocks_sent;
+              continue;
+            }
+          }
+          reply_messages.push_back(requested_message);
           continue;
         }
         catch (fc::key_not_found_exception&)
@@ -3019,6 +3101,9 @@ namespace graphene { namespace net { namespace detail {
         }
       }
 
+      // the blocks we were rebuilding are fetched again along with the other items below
+      originating_peer->compact_blocks_awaiting_transactions.clear();
+
       // if we had requested any sync or regular items from this peer that we haven't
       // received yet, reschedule them to be fetched from another peer
       if (!originating_peer->sync_items_requested_from_peer.empty())
@@ -3697,7 +3782,7 @@ namespace graphene { namespace net { namespace detail {
         {
           // we're not connected to them, so we need to set up a connection to them
           // to test.
-          peer_connection_ptr peer_for_testing(peer_connection::make_shared(this));
+          peer_connection_ptr peer_for_testing(peer_connection::make_shared(this, get_io_thread_for_new_peer()));
           peer_for_testing->firewall_check_state = new firewall_check_state_data;
           peer_for_testing->firewall_check_state->endpoint_to_test = check_firewall_message_received.endpoint_to_check;
           peer_for_testing->firewall_check_state->expected_node_id = check_firewall_message_received.node_id;
@@ -3856,6 +3941,190 @@ namespace graphene { namespace net { namespace detail {
       VERIFY_CORRECT_THREAD();
     }
 
+    void node_impl::on_compact_block_message(peer_connection* originating_peer,
+                                             const compact_block_message& compact_block_message_received)
+    {
+      VERIFY_CORRECT_THREAD();
+      const block_id_type& block_id = compact_block_message_received.block_id;
+      dlog("received compact block ${id} with ${count} transactions from peer ${endpoint}",
+           ("id", block_id)
+           ("count", compact_block_message_received.short_transaction_ids.size())
+           ("endpoint", originating_peer->get_remote_endpoint()));
+
+      // we only get compact blocks in reply to a request for that block during normal operation
+      if (originating_peer->items_requested_from_peer.find(item_id(graphene::net::block_message_type, compact_block_message_received.item_hash)) ==
+          originating_peer->items_requested_from_peer.end())
+      {
+        wlog("received compact block ${id} from peer ${endpoint} but we didn't ask for it, ignoring it",
+             ("id", block_id)
+             ("endpoint", originating_peer->get_remote_endpoint()));
+        return;
+      }
+      if (compact_block_message_received.short_transaction_ids.size() != compact_block_message_received.operation_results.size())
+      {
+        wlog("received an invalid compact block from peer ${endpoint}", ("endpoint", originating_peer->get_remote_endpoint()));
+        disconnect_from_peer(originating_peer, "You sent me an invalid compact block", true,
+                             fc::exception(FC_LOG_MESSAGE(error, "compact block ${id} has ${ids} transaction ids but ${results} sets of operation results",
+                                                          ("id", block_id)
+                                                          ("ids", compact_block_message_received.short_transaction_ids.size())
+                                                          ("results", compact_block_message_received.operation_results.size()))));
+        return;
+      }
+      ++_compact_blocks_received;
+
+      graphene::net::block_message rebuilt_block;
+      static_cast<signed_block_header&>(rebuilt_block.block) = compact_block_message_received.header;
+      rebuilt_block.block_id = block_id;
+      rebuilt_block.block.transactions.resize(compact_block_message_received.short_transaction_ids.size());
+
+      std::vector<uint32_t> missing_transaction_indices;
+      for (uint32_t i = 0; i < compact_block_message_received.short_transaction_ids.size(); ++i)
+      {
+        fc::optional<signed_transaction> transaction = _message_cache.get_transaction_by_short_id(compact_block_message_received.short_transaction_ids[i]);
+        if (transaction)
+          rebuilt_block.block.transactions[i] = graphene::chain::processed_transaction(*transaction);
+        else
+          missing_transaction_indices.push_back(i);
+        rebuilt_block.block.transactions[i].operation_results = compact_block_message_received.operation_results[i];
+      }
+
+      if (missing_transaction_indices.empty())
+      {
+        process_rebuilt_compact_block(originating_peer, rebuilt_block);
+        return;
+      }
+
+      expire_compact_blocks_awaiting_transactions(originating_peer);
+      if (originating_peer->compact_blocks_awaiting_transactions.size() >= GRAPHENE_NET_MAX_COMPACT_BLOCKS_AWAITING_TRANSACTIONS)
+      {
+        fetch_full_block_instead_of_compact_block(originating_peer, block_id);
+        return;
+      }
+
+      dlog("missing ${count} transactions of compact block ${id}, requesting them from peer ${endpoint}",
+           ("count", missing_transaction_indices.size())
+           ("id", block_id)
+           ("endpoint", originating_peer->get_remote_endpoint()));
+      originating_peer->send_message(fetch_compact_block_transactions_message(block_id, missing_transaction_indices));
+      peer_connection::compact_block_awaiting_transactions& awaiting = originating_peer->compact_blocks_awaiting_transactions[block_id];
+      awaiting.block = std::move(rebuilt_block);
+      awaiting.missing_transaction_indices = std::move(missing_transaction_indices);
+      awaiting.transactions_requested_time = fc::time_point::now();
+    }
+
+    void node_impl::expire_compact_blocks_awaiting_transactions(peer_connection* peer)
+    {
+      VERIFY_CORRECT_THREAD();
+      // a peer which never answers would otherwise keep its slots forever, and every later compact block
+      // from it would be fetched in full
+      fc::time_point expiration_threshold = fc::time_point::now() - fc::seconds(GRAPHENE_NET_COMPACT_BLOCK_TRANSACTIONS_TIMEOUT);
+      for (auto iter = peer->compact_blocks_awaiting_transactions.begin(); iter != peer->compact_blocks_awaiting_transactions.end(); )
+      {
+        if (iter->second.transactions_requested_time < expiration_threshold)
+        {
+          block_id_type block_id = iter->first;
+          iter = peer->compact_blocks_awaiting_transactions.erase(iter);
+          dlog("peer ${endpoint} didn't send the transactions of compact block ${id} in time",
+               ("endpoint", peer->get_remote_endpoint())
+               ("id", block_id));
+          fetch_full_block_instead_of_compact_block(peer, block_id);
+        }
+        else
+          ++iter;
+      }
+    }
+
+    void node_impl::on_fetch_compact_block_transactions_message(peer_connection* originating_peer,
+                                                                const fetch_compact_block_transactions_message& fetch_compact_block_transactions_message_received)
+    {
+      VERIFY_CORRECT_THREAD();
+      const block_id_type& block_id = fetch_compact_block_transactions_message_received.block_id;
+      compact_block_transactions_message reply(block_id);
+      try
+      {
+        graphene::net::block_message requested_block = _delegate->get_item(item_id(block_message_type, block_id)).as<graphene::net::block_message>();
+        reply.transactions.reserve(fetch_compact_block_transactions_message_received.transaction_indices.size());
+        for (uint32_t index : fetch_compact_block_transactions_message_received.transaction_indices)
+        {
+          if (index >= requested_block.block.transactions.size())
+          {
+            reply.transactions.clear();
+            break;
+          }
+          reply.transactions.push_back(requested_block.block.transactions[index]);
+        }
+      }
+      catch (const fc::exception&)
+      {
+        // we no longer have the block, the empty reply tells the peer to fetch it in full from someone else
+        dlog("peer ${endpoint} requested transactions of block ${id} which we don't have",
+             ("endpoint", originating_peer->get_remote_endpoint())
+             ("id", block_id));
+      }
+      originating_peer->send_message(reply);
+    }
+
+    void node_impl::on_compact_block_transactions_message(peer_connection* originating_peer,
+                                                          const compact_block_transactions_message& compact_block_transactions_message_received)
+    {
+      VERIFY_CORRECT_THREAD();
+      const block_id_type& block_id = compact_block_transactions_message_received.block_id;
+      auto awaiting_iter = originating_peer->compact_blocks_awaiting_transactions.find(block_id);
+      if (awaiting_iter == originating_peer->compact_blocks_awaiting_transactions.end())
+      {
+        dlog("received transactions for compact block ${id} from peer ${endpoint}, but we aren't waiting for them",
+             ("id", block_id)
+             ("endpoint", originating_peer->get_remote_endpoint()));
+        return;
+      }
+      peer_connection::compact_block_awaiting_transactions awaiting = std::move(awaiting_iter->second);
+      originating_peer->compact_blocks_awaiting_transactions.erase(awaiting_iter);
+
+      const std::vector<signed_transaction>& transactions = compact_block_transactions_message_received.transactions;
+      if (transactions.size() != awaiting.missing_transaction_indices.size())
+      {
+        fetch_full_block_instead_of_compact_block(originating_peer, block_id);
+        return;
+      }
+      for (size_t i = 0; i < transactions.size(); ++i)
+      {
+        graphene::chain::processed_transaction& slot = awaiting.block.block.transactions[awaiting.missing_transaction_indices[i]];
+        std::vector<operation_result> operation_results = std::move(slot.operation_results);
+        slot = graphene::chain::processed_transaction(transactions[i]);
+        slot.operation_results = std::move(operation_results);
+      }
+      _compact_block_transactions_fetched += transactions.size();
+      process_rebuilt_compact_block(originating_peer, awaiting.block);
+    }
+
+    void node_impl::process_rebuilt_compact_block(peer_connection* originating_peer, const graphene::net::block_message& rebuilt_block)
+    {
+      VERIFY_CORRECT_THREAD();
+      // a short id collision gives us the wrong transaction, which the merkle root catches.  If the block
+      // is good, the message we build is byte for byte the block_message we requested, so it has the same hash
+      if (rebuilt_block.block.calculate_merkle_root() != rebuilt_block.block.transaction_merkle_root ||
+          rebuilt_block.block.id() != rebuilt_block.block_id)
+      {
+        wlog("unable to rebuild compact block ${id} from peer ${endpoint}",
+             ("id", rebuilt_block.block_id)
+             ("endpoint", originating_peer->get_remote_endpoint()));
+        fetch_full_block_instead_of_compact_block(originating_peer, rebuilt_block.block_id);
+        return;
+      }
+      message block_message_to_process(rebuilt_block);
+      process_block_message(originating_peer, block_message_to_process, block_message_to_process.id());
+    }
+
+    void node_impl::fetch_full_block_instead_of_compact_block(peer_connection* originating_peer, const block_id_type& block_id)
+    {
+      VERIFY_CORRECT_THREAD();
+      ++_compact_block_fallbacks;
+      // the peer serves blocks requested by id from its database and never as compact blocks.  The
+      // original request stays in items_requested_from_peer, so the usual timeout still applies
+      dlog("fetching block ${id} in full from peer ${endpoint}", ("id", block_id)("endpoint", originating_peer->get_remote_endpoint()));
+      originating_peer->send_message(fetch_items_message(block_message_type, std::vector<item_hash_t>{block_id}));
+    }
+
 
     // this handles any message we get that doesn't require any special processing.
     // currently, this is any message other than block messages and p2p-specific
@@ -4253,7 +4522,7 @@ namespace graphene { namespace net { namespace detail {
       VERIFY_CORRECT_THREAD();
       while ( !_accept_loop_complete.canceled() )
       {
-        peer_connection_ptr new_peer(peer_connection::make_shared(this));
+        peer_connection_ptr new_peer(peer_connection::make_shared(this, get_io_thread_for_new_peer()));
 
         try
         {
@@ -4679,7 +4948,7 @@ namespace graphene { namespace net { namespace detail {
                            ("endpoint", remote_endpoint));
 
       dlog("node_impl::connect_to_endpoint(${endpoint})", ("endpoint", remote_endpoint));
-      peer_connection_ptr new_peer(peer_connection::make_shared(this));
+      peer_connection_ptr new_peer(peer_connection::make_shared(this, get_io_thread_for_new_peer()));
       new_peer->set_remote_endpoint(remote_endpoint);
       initiate_connect_to(new_peer);
     }
@@ -5075,6 +5344,24 @@ namespace graphene { namespace net { namespace detail {
       _rate_limiter.set_download_limit( download_bytes_per_second );
     }
 
+    void node_impl::set_io_thread_count( uint32_t num_threads )
+    {
+      VERIFY_CORRECT_THREAD();
+      // connections keep the thread they were given, so we only ever add threads
+      for (uint32_t i = _io_threads.size(); i < num_threads; ++i)
+        _io_threads.emplace_back(new fc::thread("p2p io " + fc::to_string(uint64_t(i))));
+      if (num_threads < _io_threads.size())
+        wlog("p2p io threads can't be removed, keeping ${n}", ("n", _io_threads.size()));
+    }
+
+    fc::thread* node_impl::get_io_thread_for_new_peer()
+    {
+      VERIFY_CORRECT_THREAD();
+      if (_io_threads.empty())
+        return nullptr;
+      return _io_threads[_next_io_thread++ % _io_threads.size()].get();
+    }
+
     void node_impl::disable_peer_advertising()
     {
       VERIFY_CORRECT_THREAD();
@@ -5095,6 +5382,10 @@ namespace graphene { namespace net { namespace detail {
       info["node_public_key"] = _node_public_key;
       info["node_id"] = _node_id;
       info["firewalled"] = _is_firewalled;
+      info["compact_blocks_sent"] = _compact_blocks_sent;
+      info["compact_blocks_received"] = _compact_blocks_received;
+      info["compact_block_transactions_fetched"] = _compact_block_transactions_fetched;
+      info["compact_block_fallbacks"] = _compact_block_fallbacks;
       return info;
     }
     fc::variant_object node_impl::network_get_usage_stats() const
@@ -5285,6 +5576,11 @@ namespace graphene { namespace net { namespace detail {
     INVOKE_IN_IMPL(set_total_bandwidth_limit, upload_bytes_per_second, download_bytes_per_second);
   }
 
+  void node::set_io_thread_count(uint32_t num_threads)
+  {
+    INVOKE_IN_IMPL(set_io_thread_count, num_threads);
+  }
+
   void node::disable_peer_advertising()
   {
     INVOKE_IN_IMPL(disable_peer_advertising);
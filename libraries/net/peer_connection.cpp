@@ -71,9 +71,9 @@ namespace graphene { namespace net
       return sizeof(item_id);
     }
 
-    peer_connection::peer_connection(peer_connection_delegate* delegate) :
+    peer_connection::peer_connection(peer_connection_delegate* delegate, fc::thread* io_thread) :
       _node(delegate),
-      _message_connection(this),
+      _message_connection(this, io_thread),
       _total_queued_messages_size(0),
       direction(peer_connection_direction::unknown),
       is_firewalled(firewalled_state::unknown),
@@ -82,6 +82,7 @@ namespace graphene { namespace net
       their_state(their_connection_state::disconnected),
       we_have_requested_close(false),
       negotiation_status(connection_negotiation_status::disconnected),
+      supports_compact_blocks(false),
       number_of_unfetched_item_ids(0),
       peer_needs_sync_items_from_us(true),
       we_need_sync_items_from_peer(true),
@@ -97,7 +98,7 @@ namespace graphene { namespace net
     {
     }
 
-    peer_connection_ptr peer_connection::make_shared(peer_connection_delegate* delegate)
+    peer_connection_ptr peer_connection::make_shared(peer_connection_delegate* delegate, fc::thread* io_thread)
     {
       // The lifetime of peer_connection objects is managed by shared_ptrs in node.  The peer_connection
       // is responsible for notifying the node when it should be deleted, and the process of deleting it
@@ -107,7 +108,7 @@ namespace graphene { namespace net
       // current task yields.  In the (not uncommon) case where it is the task executing
       // connect_to or read_loop, this allows the task to finish before the destructor is forced
       // to cancel it.
-      return peer_connection_ptr(new peer_connection(delegate));
+      return peer_connection_ptr(new peer_connection(delegate, io_thread));
       //, [](peer_connection* peer_to_delete){ fc::async([peer_to_delete](){delete peer_to_delete;}); });
     }
 
@@ -301,7 +302,7 @@ namespace graphene { namespace net
           //dlog("peer_connection::send_queued_messages_task() calling message_oriented_connection::send_message() "
           //     "to send message of type ${type} for peer ${endpoint}",
           //     ("type", message_to_send.msg_type)("endpoint", get_remote_endpoint()));
-          _message_connection.send_message(message_to_send);
+          _message_connection.send_message(std::move(message_to_send));
           //dlog("peer_connection::send_queued_messages_task()'s call to message_oriented_connection::send_message() completed normally for peer ${endpoint}",
           //     ("endpoint", get_remote_endpoint()));
         }
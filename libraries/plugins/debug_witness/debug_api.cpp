@@ -1,5 +1,6 @@
 
 #include <fc/filesystem.hpp>
+#include <fc/io/json.hpp>
 #include <fc/optional.hpp>
 #include <fc/variant_object.hpp>
 #include <fc/smart_ref_impl.hpp>
@@ -30,6 +31,7 @@ class debug_api_impl
       //void debug_save_db( std::string db_path );
       void debug_stream_json_objects( const std::string& filename );
       void debug_stream_json_objects_flush();
+      void debug_dump_profile( const std::string& filename );
       std::shared_ptr< graphene::debug_witness_plugin::debug_witness_plugin > get_plugin();
 
       graphene::app::application& app;
@@ -122,6 +124,12 @@ void debug_api_impl::debug_stream_json_objects_flush()
    get_plugin()->flush_json_object_stream();
 }
 
+void debug_api_impl::debug_dump_profile( const std::string& filename )
+{
+   std::shared_ptr< graphene::chain::database > db = app.chain_database();
+   fc::json::save_to_file( db->profiler().report(), fc::path( filename ) );
+}
+
 } // detail
 
 debug_api::debug_api( graphene::app::application& app )
@@ -154,5 +162,10 @@ void debug_api::debug_stream_json_objects_flush()
    my->debug_stream_json_objects_flush();
 }
 
+void debug_api::debug_dump_profile( std::string filename )
+{
+   my->debug_dump_profile( filename );
+}
+
 
 } } // graphene::debug_witness
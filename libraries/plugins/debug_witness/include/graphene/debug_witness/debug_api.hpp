@@ -82,6 +82,11 @@ class debug_api
        */
       void debug_stream_json_objects_flush();
 
+      /**
+       * Write the chain profile (see profiler_api) to a JSON file.
+       */
+      void debug_dump_profile( std::string filename );
+
       std::shared_ptr< detail::debug_api_impl > my;
 };
 
@@ -93,4 +98,5 @@ FC_API(graphene::debug_witness::debug_api,
        (debug_update_object)
        (debug_stream_json_objects)
        (debug_stream_json_objects_flush)
+       (debug_dump_profile)
      )
@@ -32,6 +32,8 @@
 #include <fc/api.hpp>
 #include <fc/smart_ref_impl.hpp>
 
+#include <algorithm>
+#include <deque>
 
 namespace graphene { namespace delayed_node {
 namespace bpo = boost::program_options;
@@ -39,12 +41,20 @@ namespace bpo = boost::program_options;
 namespace detail {
 struct delayed_node_plugin_impl {
    std::string remote_endpoint;
+   std::string remote_user;
+   std::string remote_password;
    fc::http::websocket_client client;
    std::shared_ptr<fc::rpc::websocket_api_connection> client_connection;
    fc::api<graphene::app::database_api> database_api;
+   /// set if the trusted node lets us use its block_api, which serves blocks in ranges
+   fc::optional< fc::api<graphene::app::block_api> > block_api;
    boost::signals2::scoped_connection client_connection_closed;
    graphene::chain::block_id_type last_received_remote_head;
    graphene::chain::block_id_type last_processed_remote_head;
+   /// blocks per block_api::get_blocks request
+   uint32_t window_size = 100;
+   /// block_api::get_blocks requests kept in flight
+   uint32_t window_depth = 4;
 };
 }
 
@@ -59,6 +69,14 @@ void delayed_node_plugin::plugin_set_program_options(bpo::options_description& c
 {
    cli.add_options()
          ("trusted-node", boost::program_options::value<std::string>(), "RPC endpoint of a trusted validating node (required)")
+         ("trusted-node-user", boost::program_options::value<std::string>()->default_value(""),
+          "User to log in to the trusted node with, to use its block_api")
+         ("trusted-node-password", boost::program_options::value<std::string>()->default_value(""),
+          "Password to log in to the trusted node with")
+         ("trusted-node-window", boost::program_options::value<uint32_t>()->default_value(100),
+          "Number of blocks fetched from the trusted node per request while catching up")
+         ("trusted-node-requests", boost::program_options::value<uint32_t>()->default_value(4),
+          "Number of block requests kept in flight to the trusted node while catching up")
          ;
    cfg.add(cli);
 }
@@ -70,12 +88,31 @@ void delayed_node_plugin::connect()
    my->client_connection_closed = my->client_connection->closed.connect([this] {
       connection_failed();
    });
+
+   my->block_api.reset();
+   try
+   {
+      auto login = my->client_connection->get_remote_api<graphene::app::login_api>(1);
+      if( login->login( my->remote_user, my->remote_password ) )
+         my->block_api = login->block();
+   }
+   catch( const fc::exception& e )
+   {
+      dlog( "No block_api on the trusted node: ${e}", ("e", e.to_detail_string()) );
+   }
+   if( !my->block_api.valid() )
+      wlog( "The trusted node does not grant block_api, catching up one block per request" );
 }
 
 void delayed_node_plugin::plugin_initialize(const boost::program_options::variables_map& options)
 {
    FC_ASSERT(options.count("trusted-node") > 0);
    my->remote_endpoint = "ws://" + options.at("trusted-node").as<std::string>();
+   my->remote_user = options.at("trusted-node-user").as<std::string>();
+   my->remote_password = options.at("trusted-node-password").as<std::string>();
+   my->window_size = options.at("trusted-node-window").as<uint32_t>();
+   my->window_depth = options.at("trusted-node-requests").as<uint32_t>();
+   FC_ASSERT( my->window_size > 0 && my->window_depth > 0 );
 }
 
 void delayed_node_plugin::sync_with_trusted_node()
@@ -99,6 +136,11 @@ void delayed_node_plugin::sync_with_trusted_node()
          break;
       }
       pass_count++;
+      if( my->block_api.valid() )
+      {
+         synced_blocks += sync_block_range( remote_dpo.last_irreversible_block_num );
+         continue;
+      }
       while( remote_dpo.last_irreversible_block_num > db.head_block_num() )
       {
          fc::optional<graphene::chain::signed_block> block = my->database_api->get_block( db.head_block_num()+1 );
@@ -110,6 +152,48 @@ void delayed_node_plugin::sync_with_trusted_node()
    }
 }
 
+uint32_t delayed_node_plugin::sync_block_range( uint32_t last_block_num )
+{
+   typedef std::vector< fc::optional<graphene::chain::signed_block> > block_window;
+
+   auto& db = database();
+   fc::api<graphene::app::block_api> remote_blocks = *my->block_api;
+   std::deque< fc::future<block_window> > requests;
+   uint32_t next_block_num = db.head_block_num() + 1;
+   uint32_t synced_blocks = 0;
+
+   // each request runs in its own task, so the next windows are transferred and decoded while one is pushed
+   auto request_windows = [&]() {
+      while( next_block_num <= last_block_num && requests.size() < my->window_depth )
+      {
+         const uint32_t from = next_block_num;
+         const uint32_t to = std::min( last_block_num, from + my->window_size - 1 );
+         next_block_num = to + 1;
+         requests.push_back( fc::async( [remote_blocks,from,to]() {
+            return remote_blocks->get_blocks( from, to );
+         }, "delayed_node get_blocks" ) );
+      }
+   };
+
+   request_windows();
+   while( !requests.empty() )
+   {
+      block_window blocks = requests.front().wait();
+      requests.pop_front();
+      request_windows();
+      if( !blocks.empty() && blocks.front() )
+         ilog( "Pushing blocks #${n} to #${m}", ("n", blocks.front()->block_num())("m", blocks.front()->block_num() + blocks.size() - 1) );
+      for( const auto& block : blocks )
+      {
+         FC_ASSERT( block, "Trusted node claims it has blocks it doesn't actually have." );
+         FC_ASSERT( block->block_num() == db.head_block_num() + 1, "Trusted node sent block #${n} out of order", ("n", block->block_num()) );
+         db.push_block( *block );
+         synced_blocks++;
+      }
+   }
+   return synced_blocks;
+}
+
 void delayed_node_plugin::mainloop()
 {
    while( true )
@@ -46,6 +46,8 @@ protected:
    void connection_failed();
    void connect();
    void sync_with_trusted_node();
+   /// fetches blocks up to last_block_num in windows with several requests in flight, returns the number pushed
+   uint32_t sync_block_range( uint32_t last_block_num );
 };
 
 } } //graphene::account_history
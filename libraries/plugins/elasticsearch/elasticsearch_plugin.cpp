@@ -34,6 +34,7 @@
 #include <graphene/chain/operation_history_object.hpp>
 #include <graphene/chain/transaction_evaluation_state.hpp>
 
+#include <fc/io/fstream.hpp>
 #include <fc/smart_ref_impl.hpp>
 #include <fc/thread/thread.hpp>
 
@@ -42,13 +43,41 @@
 #include <boost/algorithm/string/replace.hpp>
 #include <boost/algorithm/string/find.hpp>
 #include <boost/algorithm/string.hpp>
+#include <boost/filesystem.hpp>
 #include <regex>
 
+#include <algorithm>
+#include <atomic>
+#include <deque>
+#include <fstream>
+#include <mutex>
+
 namespace graphene { namespace elasticsearch {
 
 namespace detail
 {
 
+/**
+ * A document to be indexed, captured on the chain thread.  It is turned into a bulk line on the export thread.
+ */
+struct bulk_document
+{
+   account_transaction_history_object   ath;
+   operation_history_object             oho;
+};
+
+/**
+ * All documents produced by one applied block, with the little of the block the documents refer to
+ */
+struct export_batch
+{
+   uint32_t                      block_num = 0;
+   fc::time_point_sec            block_time;
+   /// indexed by trx_in_block
+   vector<transaction_id_type>   transaction_ids;
+   vector<bulk_document>         documents;
+};
+
 class elasticsearch_plugin_impl
 {
    public:
@@ -59,6 +88,10 @@ class elasticsearch_plugin_impl
 
       void update_account_histories( const signed_block& b );
 
+      void start_export();
+      void stop_export();
+      export_stats get_export_stats()const;
+
       graphene::chain::database& database()
       {
          return _self.database();
@@ -72,17 +105,57 @@ class elasticsearch_plugin_impl
       uint32_t _elasticsearch_bulk_sync = 100;
       bool _elasticsearch_logs = true;
       bool _elasticsearch_visitor = false;
-      CURL *curl; // curl handler
-      vector <string> bulk; //  vector of op lines
+      uint32_t _elasticsearch_queue_size = 100000;
+      uint32_t _elasticsearch_max_retries = 5;
+      fc::path _elasticsearch_spool_dir;
+      uint32_t _elasticsearch_stats_interval = 60;
+      CURL *curl; // curl handler, only used by the export thread
+      vector <string> bulk; //  vector of op lines, only used by the export thread
    private:
-      void add_elasticsearch( const account_id_type account_id, const optional<operation_history_object>& oho, const signed_block& b );
-      void createBulkLine(account_transaction_history_object ath, operation_history_struct os, int op_type, block_struct bs, visitor_struct vs);
-      void sendBulk(std::string _elasticsearch_node_url, bool _elasticsearch_logs);
-
+      void add_elasticsearch( const account_id_type account_id, const optional<operation_history_object>& oho, export_batch& batch );
+
+      // chain thread
+      void enqueue( std::shared_ptr<export_batch> batch );
+      void report_export_stats();
+
+      // export thread
+      void process_batch( const export_batch& batch );
+      /// also called on the chain thread for batches which overflow the queue
+      void createBulkLine( const bulk_document& doc, const export_batch& batch, vector<string>& lines )const;
+      void sendBulk();
+      bool post( const std::string& url, const std::string& body, std::string& response );
+      bool send_with_retry( const std::string& body );
+      void flush_spool();
+      void spool( const std::string& body );
+      void load_spool();
+      fc::microseconds backoff_delay( uint32_t attempt )const;
+
+      std::unique_ptr<fc::thread>      _export_thread;
+      std::deque< fc::future<void> >   _pending_batches;
+
+      /// guards _spool and _next_spool_seq, which the chain thread appends to when the queue overflows
+      std::mutex                       _spool_mutex;
+      std::deque<fc::path>             _spool;
+      uint64_t                         _next_spool_seq = 0;
+      uint32_t                         _spool_failures = 0;
+      fc::time_point                   _next_spool_attempt;
+
+      std::atomic<uint32_t>            _queued_documents{0};
+      std::atomic<uint32_t>            _spooled_batches{0};
+      std::atomic<uint32_t>            _last_enqueued_block{0};
+      std::atomic<uint32_t>            _last_exported_block{0};
+      std::atomic<uint32_t>            _last_exported_block_time{0};
+      std::atomic<uint64_t>            _sent_documents{0};
+      std::atomic<uint64_t>            _failed_requests{0};
+      uint32_t                         _buffered_block = 0;
+      uint32_t                         _buffered_block_time = 0;
+      fc::time_point                   _next_stats_report;
 };
 
 elasticsearch_plugin_impl::~elasticsearch_plugin_impl()
 {
+   if( curl )
+      curl_easy_cleanup( curl );
    return;
 }
 
@@ -90,6 +163,7 @@ void elasticsearch_plugin_impl::update_account_histories( const signed_block& b
 {
    graphene::chain::database& db = database();
    const vector<optional< operation_history_object > >& hist = db.get_applied_operations();
+   auto batch = std::make_shared<export_batch>();
    for( const optional< operation_history_object >& o_op : hist ) {
       optional <operation_history_object> oho;
 
@@ -132,12 +206,25 @@ void elasticsearch_plugin_impl::update_account_histories( const signed_block& b
 
       for( auto& account_id : impacted )
       {
-         add_elasticsearch( account_id, oho, b );
+         add_elasticsearch( account_id, oho, *batch );
       }
    }
+
+   _last_enqueued_block = b.block_num();
+   if( !batch->documents.empty() )
+   {
+      // the ids are cached by block validation, so the block itself is not copied to the export thread
+      batch->block_num = b.block_num();
+      batch->block_time = b.timestamp;
+      batch->transaction_ids.reserve( b.transactions.size() );
+      for( const auto& trx : b.transactions )
+         batch->transaction_ids.push_back( trx.id() );
+      enqueue( batch );
+   }
+   report_export_stats();
 }
 
-void elasticsearch_plugin_impl::add_elasticsearch( const account_id_type account_id, const optional <operation_history_object>& oho, const signed_block& b)
+void elasticsearch_plugin_impl::add_elasticsearch( const account_id_type account_id, const optional <operation_history_object>& oho, export_batch& batch )
 {
    graphene::chain::database& db = database();
    const auto &stats_obj = account_id(db).statistics(db);
@@ -148,6 +235,7 @@ void elasticsearch_plugin_impl::add_elasticsearch( const account_id_type account
       obj.account = account_id;
       obj.sequence = stats_obj.total_ops + 1;
       obj.next = stats_obj.most_recent_op;
+      obj.op_type = oho->op.which();
    });
 
    // keep stats growing as no op will be removed
@@ -156,55 +244,8 @@ void elasticsearch_plugin_impl::add_elasticsearch( const account_id_type account
       obj.total_ops = ath.sequence;
    });
 
-   // operation_type
-   int op_type = -1;
-   if (!oho->id.is_null())
-      op_type = oho->op.which();
-
-   // operation history data
-   operation_history_struct os;
-   os.trx_in_block = oho->trx_in_block;
-   os.op_in_trx = oho->op_in_trx;
-   os.operation_result = fc::json::to_string(oho->result);
-   os.virtual_op = oho->virtual_op;
-   os.op = fc::json::to_string(oho->op);
-
-   // visitor data
-   visitor_struct vs;
-   if(_elasticsearch_visitor) {
-      operation_visitor o_v;
-      oho->op.visit(o_v);
-
-      vs.fee_data.asset = o_v.fee_asset;
-      vs.fee_data.amount = o_v.fee_amount;
-      vs.transfer_data.asset = o_v.transfer_asset_id;
-      vs.transfer_data.amount = o_v.transfer_amount;
-      vs.transfer_data.from = o_v.transfer_from;
-      vs.transfer_data.to = o_v.transfer_to;
-   }
-
-   // block data
-   std::string trx_id = "";
-   if(!b.transactions.empty() && oho->trx_in_block < b.transactions.size()) {
-      trx_id = b.transactions[oho->trx_in_block].id().str();
-   }
-   block_struct bs;
-   bs.block_num = b.block_num();
-   bs.block_time = b.timestamp;
-   bs.trx_id = trx_id;
-
-   // check if we are in replay or in sync and change number of bulk documents accordingly
-   uint32_t limit_documents = 0;
-   if((fc::time_point::now() - b.timestamp) < fc::seconds(30))
-      limit_documents = _elasticsearch_bulk_sync;
-   else
-      limit_documents = _elasticsearch_bulk_replay;
-
-   createBulkLine(ath, os, op_type, bs, vs); // we have everything, creating bulk line
-
-   if (curl && bulk.size() >= limit_documents) { // we are in bulk time, ready to add data to elasticsearech
-      sendBulk(_elasticsearch_node_url, _elasticsearch_logs);
-   }
+   // the document itself is serialized by the export thread
+   batch.documents.push_back( bulk_document{ ath, *oho } );
 
    // remove everything except current object from ath
    const auto &his_idx = db.get_index_type<account_transaction_history_index>();
@@ -232,10 +273,143 @@ void elasticsearch_plugin_impl::add_elasticsearch( const account_id_type account
    }
 }
 
-void elasticsearch_plugin_impl::createBulkLine(account_transaction_history_object ath, operation_history_struct os, int op_type, block_struct bs, visitor_struct vs)
+void elasticsearch_plugin_impl::start_export()
+{
+   if( _export_thread )
+      return;
+   if( _elasticsearch_spool_dir == fc::path() )
+      _elasticsearch_spool_dir = database().get_data_dir() / "elasticsearch-spool";
+   fc::create_directories( _elasticsearch_spool_dir );
+   load_spool();
+
+   _export_thread.reset( new fc::thread( "elasticsearch" ) );
+}
+
+void elasticsearch_plugin_impl::stop_export()
+{
+   if( !_export_thread )
+      return;
+
+   for( auto& f : _pending_batches )
+      f.wait();
+   _pending_batches.clear();
+
+   // whatever could not be delivered yet is kept in the spool for the next start
+   _export_thread->async( [this]() {
+      if( !bulk.empty() )
+      {
+         std::string bulking = boost::algorithm::join(bulk, "\n") + "\n";
+         bulk.clear();
+         spool( bulking );
+      }
+   }, "elasticsearch shutdown" ).wait();
+
+   _export_thread->quit();
+   _export_thread.reset();
+}
+
+void elasticsearch_plugin_impl::enqueue( std::shared_ptr<export_batch> batch )
+{
+   // blocks replayed at startup are applied before plugin_startup()
+   start_export();
+
+   while( !_pending_batches.empty() && _pending_batches.front().ready() )
+      _pending_batches.pop_front();
+
+   // the queue is bounded.  This runs from applied_block, halfway through applying the block, where waiting for the
+   // exporter would let other tasks of this thread see the half-applied state, so a batch which does not fit goes
+   // straight to the spool, which the exporter sends ahead of the bulks it builds itself
+   if( _queued_documents > 0 && _queued_documents + batch->documents.size() > _elasticsearch_queue_size )
+   {
+      vector<string> lines;
+      lines.reserve( batch->documents.size() * 2 );
+      for( const auto& doc : batch->documents )
+         createBulkLine( doc, *batch, lines );
+      spool( boost::algorithm::join( lines, "\n" ) + "\n" );
+      return;
+   }
+
+   _queued_documents += batch->documents.size();
+   _pending_batches.push_back( _export_thread->async( [this, batch]() { process_batch( *batch ); },
+                                                      "elasticsearch export" ) );
+}
+
+void elasticsearch_plugin_impl::report_export_stats()
 {
+   if( _elasticsearch_stats_interval == 0 || fc::time_point::now() < _next_stats_report )
+      return;
+   _next_stats_report = fc::time_point::now() + fc::seconds( _elasticsearch_stats_interval );
+
+   const export_stats stats = get_export_stats();
+   ilog( "Elasticsearch export: block ${b} exported, ${l} blocks behind, ${q} documents queued, ${s} bulks spooled, "
+         "${n} documents sent, ${f} failed requests",
+         ("b", stats.last_exported_block)("l", stats.block_lag)("q", stats.queued_documents)("s", stats.spooled_bulks)
+         ("n", stats.sent_documents)("f", stats.failed_requests) );
+}
+
+void elasticsearch_plugin_impl::process_batch( const export_batch& batch )
+{
+   for( const auto& doc : batch.documents )
+      createBulkLine( doc, batch, bulk );
+   _queued_documents -= batch.documents.size();
+   _buffered_block = batch.block_num;
+   _buffered_block_time = batch.block_time.sec_since_epoch();
+
+   // check if we are in replay or in sync and change number of bulk documents accordingly
+   uint32_t limit_documents = 0;
+   if((fc::time_point::now() - batch.block_time) < fc::seconds(30))
+      limit_documents = _elasticsearch_bulk_sync;
+   else
+      limit_documents = _elasticsearch_bulk_replay;
+
+   if (curl && bulk.size() >= limit_documents) { // we are in bulk time, ready to add data to elasticsearech
+      sendBulk();
+   }
+}
+
+void elasticsearch_plugin_impl::createBulkLine( const bulk_document& doc, const export_batch& batch, vector<string>& lines )const
+{
+   const operation_history_object& oho = doc.oho;
+
+   // operation_type
+   int op_type = -1;
+   if (!oho.id.is_null())
+      op_type = oho.op.which();
+
+   // operation history data
+   operation_history_struct os;
+   os.trx_in_block = oho.trx_in_block;
+   os.op_in_trx = oho.op_in_trx;
+   os.operation_result = fc::json::to_string(oho.result);
+   os.virtual_op = oho.virtual_op;
+   os.op = fc::json::to_string(oho.op);
+
+   // visitor data
+   visitor_struct vs;
+   if(_elasticsearch_visitor) {
+      operation_visitor o_v;
+      oho.op.visit(o_v);
+
+      vs.fee_data.asset = o_v.fee_asset;
+      vs.fee_data.amount = o_v.fee_amount;
+      vs.transfer_data.asset = o_v.transfer_asset_id;
+      vs.transfer_data.amount = o_v.transfer_amount;
+      vs.transfer_data.from = o_v.transfer_from;
+      vs.transfer_data.to = o_v.transfer_to;
+   }
+
+   // block data
+   std::string trx_id = "";
+   if(oho.trx_in_block < batch.transaction_ids.size()) {
+      trx_id = batch.transaction_ids[oho.trx_in_block].str();
+   }
+   block_struct bs;
+   bs.block_num = batch.block_num;
+   bs.block_time = batch.block_time;
+   bs.trx_id = trx_id;
+
    bulk_struct bulks;
-   bulks.account_history = ath;
+   bulks.account_history = doc.ath;
    bulks.operation_history = os;
    bulks.operation_type = op_type;
    bulks.block_data = bs;
@@ -249,78 +423,203 @@ void elasticsearch_plugin_impl::createBulkLine(account_transaction_history_objec
    std::string index_name = "graphene-" + parts[0] + "-" + parts[1];
 
    // bulk header before each line, op_type = create to avoid dups, index id will be ath id(2.9.X).
-   std::string _id = fc::json::to_string(ath.id);
-   bulk.push_back("{ \"index\" : { \"_index\" : \""+index_name+"\", \"_type\" : \"data\", \"op_type\" : \"create\", \"_id\" : "+_id+" } }"); // header
-   bulk.push_back(alltogether);
+   std::string _id = fc::json::to_string(doc.ath.id);
+   lines.push_back("{ \"index\" : { \"_index\" : \""+index_name+"\", \"_type\" : \"data\", \"op_type\" : \"create\", \"_id\" : "+_id+" } }"); // header
+   lines.push_back(alltogether);
 }
 
-void elasticsearch_plugin_impl::sendBulk(std::string _elasticsearch_node_url, bool _elasticsearch_logs)
+void elasticsearch_plugin_impl::sendBulk()
 {
-
-   // curl buffers to read
-   std::string readBuffer;
-   std::string readBuffer_logs;
-
    std::string bulking = "";
 
    bulking = boost::algorithm::join(bulk, "\n");
    bulking = bulking + "\n";
+   const uint64_t documents = bulk.size() / 2;
    bulk.clear();
 
    //wlog((bulking));
 
+   // older bulks go first, so documents are indexed in order
+   flush_spool();
+   bool spool_empty;
+   {
+      std::lock_guard<std::mutex> guard( _spool_mutex );
+      spool_empty = _spool.empty();
+   }
+   if( !spool_empty || !send_with_retry( bulking ) )
+      spool( bulking );
+   else
+      _sent_documents += documents;
+
+   _last_exported_block = _buffered_block;
+   _last_exported_block_time = _buffered_block_time;
+}
+
+/**
+ * @return true if the request is done with, false if it failed in a way that is worth retrying (connection
+ * failure, 429 Too Many Requests or a server error)
+ */
+bool elasticsearch_plugin_impl::post( const std::string& url, const std::string& body, std::string& response )
+{
    struct curl_slist *headers = NULL;
-   curl_slist_append(headers, "Content-Type: application/json");
-   std::string url = _elasticsearch_node_url + "_bulk";
+   headers = curl_slist_append(headers, "Content-Type: application/json");
    curl_easy_setopt(curl, CURLOPT_URL, url.c_str());
    curl_easy_setopt(curl, CURLOPT_POST, true);
    curl_easy_setopt(curl, CURLOPT_HTTPHEADER, headers);
-   curl_easy_setopt(curl, CURLOPT_POSTFIELDS, bulking.c_str());
+   curl_easy_setopt(curl, CURLOPT_POSTFIELDS, body.c_str());
+   curl_easy_setopt(curl, CURLOPT_POSTFIELDSIZE, (long)body.size());
    curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, WriteCallback);
-   curl_easy_setopt(curl, CURLOPT_WRITEDATA, (void *)&readBuffer);
+   curl_easy_setopt(curl, CURLOPT_WRITEDATA, (void *)&response);
    curl_easy_setopt(curl, CURLOPT_USERAGENT, "libcrp/0.1");
    //curl_easy_setopt(curl, CURLOPT_VERBOSE, true);
-   curl_easy_perform(curl);
+   CURLcode res = curl_easy_perform(curl);
+   curl_slist_free_all(headers);
 
    long http_code = 0;
    curl_easy_getinfo (curl, CURLINFO_RESPONSE_CODE, &http_code);
-   if(http_code == 200) {
-      // all good, do nothing
+   if( res == CURLE_OK && http_code >= 200 && http_code < 300 )
+      return true;
+
+   ++_failed_requests;
+   if( res != CURLE_OK || http_code == 429 || http_code >= 500 )
+   {
+      wlog( "Elasticsearch request to ${u} failed: ${e} (HTTP ${c})",
+            ("u", url)("e", std::string(curl_easy_strerror(res)))("c", http_code) );
+      return false;
    }
-   else if(http_code == 429) {
-      // repeat request?
-   }
-   else {
-      // exit everything ?
+
+   // the request itself is rejected, sending it again would not help
+   elog( "Elasticsearch rejected request to ${u} (HTTP ${c}): ${r}", ("u", url)("c", http_code)("r", response) );
+   return true;
+}
+
+bool elasticsearch_plugin_impl::send_with_retry( const std::string& body )
+{
+   const std::string url = _elasticsearch_node_url + "_bulk";
+   for( uint32_t attempt = 0; ; ++attempt )
+   {
+      std::string readBuffer;
+      if( post( url, body, readBuffer ) )
+      {
+         if(_elasticsearch_logs) {
+            std::string readBuffer_logs;
+            post( _elasticsearch_node_url + "logs/data/", readBuffer, readBuffer_logs );
+         }
+         return true;
+      }
+      if( attempt >= _elasticsearch_max_retries )
+         return false;
+      fc::usleep( backoff_delay( attempt ) );
    }
+}
 
-   if(_elasticsearch_logs) {
-      auto logs = readBuffer;
-      // do logs
-      std::string url_logs = _elasticsearch_node_url + "logs/data/";
-      curl_easy_setopt(curl, CURLOPT_URL, url_logs.c_str());
-      curl_easy_setopt(curl, CURLOPT_POST, true);
-      curl_easy_setopt(curl, CURLOPT_HTTPHEADER, headers);
-      curl_easy_setopt(curl, CURLOPT_POSTFIELDS, logs.c_str());
-      curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, WriteCallback);
-      curl_easy_setopt(curl, CURLOPT_WRITEDATA, (void *) &readBuffer_logs);
-      curl_easy_setopt(curl, CURLOPT_USERAGENT, "libcrp/0.1");
-      //curl_easy_setopt(curl, CURLOPT_VERBOSE, true);
-      //ilog("log here curl: ${output}", ("output", readBuffer_logs));
-      curl_easy_perform(curl);
-
-      http_code = 0;
-      curl_easy_getinfo (curl, CURLINFO_RESPONSE_CODE, &http_code);
-      if(http_code == 200) {
-         // all good, do nothing
+fc::microseconds elasticsearch_plugin_impl::backoff_delay( uint32_t attempt )const
+{
+   return fc::microseconds( int64_t(500000) << std::min<uint32_t>( attempt, 7 ) );
+}
+
+void elasticsearch_plugin_impl::flush_spool()
+{
+   // while the node is unreachable, spooled bulks are retried with growing delays rather than on every flush
+   if( fc::time_point::now() < _next_spool_attempt )
+      return;
+
+   const std::string url = _elasticsearch_node_url + "_bulk";
+   while( true )
+   {
+      // only this thread takes bulks off the spool, the chain thread may add to it meanwhile
+      fc::path front;
+      {
+         std::lock_guard<std::mutex> guard( _spool_mutex );
+         if( _spool.empty() )
+            return;
+         front = _spool.front();
       }
-      else if(http_code == 429) {
-         // repeat request?
+      std::string body;
+      fc::read_file_contents( front, body );
+
+      std::string readBuffer;
+      if( !post( url, body, readBuffer ) )
+      {
+         _next_spool_attempt = fc::time_point::now() + backoff_delay( _spool_failures++ );
+         return;
+      }
+      _spool_failures = 0;
+      _sent_documents += std::count( body.begin(), body.end(), '\n' ) / 2;
+      fc::remove( front );
+      {
+         std::lock_guard<std::mutex> guard( _spool_mutex );
+         _spool.pop_front();
       }
-      else {
-         // exit everything ?
+      --_spooled_batches;
+   }
+}
+
+void elasticsearch_plugin_impl::spool( const std::string& body )
+{
+   std::lock_guard<std::mutex> guard( _spool_mutex );
+   char name[32];
+   snprintf( name, sizeof(name), "%020llu.json", (unsigned long long)_next_spool_seq++ );
+   fc::path file = _elasticsearch_spool_dir / name;
+   fc::path tmp = _elasticsearch_spool_dir / ( std::string(name) + ".tmp" );
+   {
+      std::ofstream out( tmp.generic_string(), std::ofstream::binary | std::ofstream::out | std::ofstream::trunc );
+      FC_ASSERT( out, "Unable to write elasticsearch spool file ${f}", ("f", tmp) );
+      out.write( body.data(), body.size() );
+      out.flush();
+      FC_ASSERT( out, "Unable to write elasticsearch spool file ${f}", ("f", tmp) );
+   }
+   fc::rename( tmp, file );
+   _spool.push_back( file );
+   ++_spooled_batches;
+}
+
+void elasticsearch_plugin_impl::load_spool()
+{
+   vector<boost::filesystem::path> files;
+   for( boost::filesystem::directory_iterator it( _elasticsearch_spool_dir ); it != boost::filesystem::directory_iterator(); ++it )
+   {
+      if( it->path().extension() == ".json" )
+         files.push_back( it->path() );
+      else if( it->path().extension() == ".tmp" )
+         boost::filesystem::remove( it->path() ); // interrupted while writing, the bulk was never acknowledged
+   }
+   std::sort( files.begin(), files.end() );
+
+   for( const auto& f : files )
+   {
+      // only names written by spool() are ours, anything else is left alone
+      const std::string stem = f.stem().string();
+      uint64_t seq = 0;
+      try {
+         if( stem.size() != 20 || stem.find_first_not_of( "0123456789" ) != std::string::npos )
+            throw std::invalid_argument( stem );
+         seq = std::stoull( stem );
+      } catch( const std::exception& ) {
+         wlog( "Ignoring ${f} in the elasticsearch spool directory", ("f", f.string()) );
+         continue;
       }
+      _spool.push_back( f );
+      _next_spool_seq = std::max<uint64_t>( _next_spool_seq, seq + 1 );
    }
+   _spooled_batches = _spool.size();
+   if( !_spool.empty() )
+      ilog( "Found ${n} spooled elasticsearch bulks in ${d}", ("n", _spool.size())("d", _elasticsearch_spool_dir) );
+}
+
+export_stats elasticsearch_plugin_impl::get_export_stats()const
+{
+   export_stats result;
+   result.queued_documents = _queued_documents;
+   result.spooled_bulks = _spooled_batches;
+   result.last_enqueued_block = _last_enqueued_block;
+   result.last_exported_block = _last_exported_block;
+   result.block_lag = result.last_enqueued_block > result.last_exported_block ?
+                      result.last_enqueued_block - result.last_exported_block : 0;
+   result.last_exported_block_time = fc::time_point_sec( _last_exported_block_time );
+   result.sent_documents = _sent_documents;
+   result.failed_requests = _failed_requests;
+   return result;
 }
 
 } // end namespace detail
@@ -354,6 +653,10 @@ void elasticsearch_plugin::plugin_set_program_options(
          ("elasticsearch-bulk-sync", boost::program_options::value<uint32_t>(), "Number of bulk documents to index on a syncronied chain(10)")
          ("elasticsearch-logs", boost::program_options::value<bool>(), "Log bulk events to database")
          ("elasticsearch-visitor", boost::program_options::value<bool>(), "Use visitor to index additional data(slows down the replay)")
+         ("elasticsearch-queue-size", boost::program_options::value<uint32_t>(), "Number of documents waiting for export before further blocks are spooled to disk(100000)")
+         ("elasticsearch-max-retries", boost::program_options::value<uint32_t>(), "Number of times a failed bulk is retried before it is spooled to disk(5)")
+         ("elasticsearch-spool-dir", boost::program_options::value<boost::filesystem::path>(), "Directory keeping bulks that could not be delivered yet(blockchain/elasticsearch-spool)")
+         ("elasticsearch-stats-interval", boost::program_options::value<uint32_t>(), "Seconds between export progress reports in the log, 0 to disable(60)")
          ;
    cfg.add(cli);
 }
@@ -379,10 +682,33 @@ void elasticsearch_plugin::plugin_initialize(const boost::program_options::varia
    if (options.count("elasticsearch-visitor")) {
       my->_elasticsearch_visitor = options["elasticsearch-visitor"].as<bool>();
    }
+   if (options.count("elasticsearch-queue-size")) {
+      my->_elasticsearch_queue_size = options["elasticsearch-queue-size"].as<uint32_t>();
+   }
+   if (options.count("elasticsearch-max-retries")) {
+      my->_elasticsearch_max_retries = options["elasticsearch-max-retries"].as<uint32_t>();
+   }
+   if (options.count("elasticsearch-spool-dir")) {
+      my->_elasticsearch_spool_dir = options["elasticsearch-spool-dir"].as<boost::filesystem::path>();
+   }
+   if (options.count("elasticsearch-stats-interval")) {
+      my->_elasticsearch_stats_interval = options["elasticsearch-stats-interval"].as<uint32_t>();
+   }
 }
 
 void elasticsearch_plugin::plugin_startup()
 {
+   my->start_export();
+}
+
+void elasticsearch_plugin::plugin_shutdown()
+{
+   my->stop_export();
+}
+
+export_stats elasticsearch_plugin::get_export_stats()const
+{
+   return my->get_export_stats();
 }
 
 } }
@@ -58,6 +58,24 @@ namespace detail
     class elasticsearch_plugin_impl;
 }
 
+/**
+ * Progress of the export thread, see elasticsearch_plugin::get_export_stats()
+ */
+struct export_stats
+{
+   /// documents handed to the export thread which are not serialized yet
+   uint32_t           queued_documents = 0;
+   /// bulks waiting in the on-disk spool until the node accepts them
+   uint32_t           spooled_bulks = 0;
+   uint32_t           last_enqueued_block = 0;
+   uint32_t           last_exported_block = 0;
+   /// number of applied blocks whose documents were not sent yet
+   uint32_t           block_lag = 0;
+   fc::time_point_sec last_exported_block_time;
+   uint64_t           sent_documents = 0;
+   uint64_t           failed_requests = 0;
+};
+
 class elasticsearch_plugin : public graphene::app::plugin
 {
    public:
@@ -71,6 +89,9 @@ class elasticsearch_plugin : public graphene::app::plugin
          boost::program_options::options_description& cfg) override;
       virtual void plugin_initialize(const boost::program_options::variables_map& options) override;
       virtual void plugin_startup() override;
+      virtual void plugin_shutdown() override;
+
+      export_stats get_export_stats()const;
 
       friend class detail::elasticsearch_plugin_impl;
       std::unique_ptr<detail::elasticsearch_plugin_impl> my;
@@ -149,6 +170,7 @@ struct bulk_struct {
 
 } } //graphene::elasticsearch
 
+FC_REFLECT( graphene::elasticsearch::export_stats, (queued_documents)(spooled_bulks)(last_enqueued_block)(last_exported_block)(block_lag)(last_exported_block_time)(sent_documents)(failed_requests) )
 FC_REFLECT( graphene::elasticsearch::operation_history_struct, (trx_in_block)(op_in_trx)(operation_result)(virtual_op)(op) )
 FC_REFLECT( graphene::elasticsearch::block_struct, (block_num)(block_time)(trx_id) )
 FC_REFLECT( graphene::elasticsearch::fee_struct, (asset)(amount) )
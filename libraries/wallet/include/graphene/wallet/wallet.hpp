@@ -1502,6 +1502,24 @@ class wallet_api
        */
       signed_transaction sign_transaction(signed_transaction tx, bool broadcast = false);
 
+      /** Signs transactions without asking the node which keys are needed.
+       *
+       * When enabled, the wallet keeps the authorities of the accounts it signs for and the head block, refreshed
+       * whenever the node applies a block, and works out the required keys itself.  Signing then needs no remote
+       * call, at the price of signing with up to a block old authorities and reference block.
+       * @param enabled true to sign from the local cache, false to ask the node for every transaction
+       */
+      void set_local_signing(bool enabled);
+
+      /** Signs and broadcasts a batch of transactions.
+       *
+       * The transactions are signed like sign_transaction() does, then all broadcasts are sent before waiting for
+       * any reply.  Use set_local_signing() as well to avoid remote calls while signing.
+       * @param txs the unsigned transactions, with fees set
+       * @return the signed transactions, in the same order; throws listing the ones that failed to broadcast
+       */
+      vector<signed_transaction> sign_and_broadcast(vector<signed_transaction> txs);
+
       /** Returns an uninitialized object representing a given blockchain operation.
        *
        * This returns a default-initialized object of the given type; it can be used 
@@ -1742,6 +1760,8 @@ FC_API( graphene::wallet::wallet_api,
         (save_wallet_file)
         (serialize_transaction)
         (sign_transaction)
+        (set_local_signing)
+        (sign_and_broadcast)
         (get_prototype_operation)
         (propose_parameter_change)
         (propose_account_lock)
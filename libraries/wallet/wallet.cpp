@@ -384,6 +384,17 @@ private:
                                                                                                               boost::multi_index::member<recently_generated_transaction_record, fc::time_point_sec, &recently_generated_transaction_record::generation_time> > > > recently_generated_transaction_set_type;
    recently_generated_transaction_set_type _recently_generated_transactions;
 
+   // see set_local_signing(); refreshed after every block applied on the node
+   struct signing_authorities
+   {
+      authority active;
+      authority owner;
+   };
+   bool                                            _local_signing = false;
+   optional<dynamic_global_property_object>        _signing_dynamic_props;
+   uint32_t                                        _signing_max_authority_depth = GRAPHENE_MAX_SIG_CHECK_DEPTH;
+   map<account_id_type, signing_authorities>       _signing_authorities;
+
 public:
    wallet_api& self;
    wallet_api_impl( wallet_api& s, const wallet_data& initial_data, fc::api<login_api> rapi )
@@ -443,7 +454,106 @@ public:
 
    void on_block_applied( const variant& block_id )
    {
-      fc::async([this]{resync();}, "Resync after block");
+      fc::async([this]{
+         resync();
+         if( _local_signing )
+            refresh_signing_cache();
+      }, "Resync after block");
+   }
+
+   void set_local_signing( bool enabled )
+   {
+      _signing_authorities.clear();
+      _local_signing = enabled;
+      if( enabled )
+      {
+         _signing_max_authority_depth = _remote_db->get_global_properties().parameters.max_authority_depth;
+         _signing_dynamic_props = get_dynamic_global_properties();
+      }
+      else
+         _signing_dynamic_props.reset();
+   }
+
+   void refresh_signing_cache()
+   {
+      _signing_dynamic_props = get_dynamic_global_properties();
+      vector<account_id_type> ids;
+      ids.reserve( _signing_authorities.size() );
+      for( const auto& entry : _signing_authorities )
+         ids.push_back( entry.first );
+      fetch_signing_authorities( ids );
+   }
+
+   void fetch_signing_authorities( const vector<account_id_type>& ids )
+   {
+      if( ids.empty() )
+         return;
+      for( const optional<account_object>& account : _remote_db->get_accounts( ids ) )
+         if( account )
+            _signing_authorities[account->id] = signing_authorities{ account->active, account->owner };
+   }
+
+   /**
+    *  Copies the cached authorities of ids and of the accounts they name, down to the maximum authority depth,
+    *  fetching those not cached yet.  Fetching waits on the node, and the resync after a block may refresh the
+    *  cache meanwhile, so the signature check runs against the copy and never calls the node itself.
+    */
+   map<account_id_type, signing_authorities> resolve_signing_authorities( flat_set<account_id_type> ids )
+   {
+      map<account_id_type, signing_authorities> result;
+      for( uint32_t depth = 0; !ids.empty() && depth <= _signing_max_authority_depth; ++depth )
+      {
+         vector<account_id_type> missing;
+         for( const auto& id : ids )
+            if( !_signing_authorities.count( id ) )
+               missing.push_back( id );
+         fetch_signing_authorities( missing );
+
+         flat_set<account_id_type> nested;
+         for( const auto& id : ids )
+         {
+            auto itr = _signing_authorities.find( id );
+            FC_ASSERT( itr != _signing_authorities.end(), "Unknown account ${id}", ("id", id) );
+            result[id] = itr->second;
+            for( const authority* auth : { &itr->second.active, &itr->second.owner } )
+               for( const auto& account : auth->account_auths )
+                  if( !result.count( account.first ) )
+                     nested.insert( account.first );
+         }
+         ids = std::move( nested );
+      }
+      return result;
+   }
+
+   /** the keys of this wallet that have to sign tx, computed from the cached authorities without asking the node */
+   set<public_key_type> get_local_required_signatures( const signed_transaction& tx )
+   {
+      flat_set<account_id_type> active;
+      flat_set<account_id_type> owner;
+      vector<authority> other;
+      tx.get_required_authorities( active, owner, other );
+      flat_set<account_id_type> ids( active.begin(), active.end() );
+      ids.insert( owner.begin(), owner.end() );
+      for( const auto& auth : other )
+         for( const auto& account : auth.account_auths )
+            ids.insert( account.first );
+      const map<account_id_type, signing_authorities> authorities = resolve_signing_authorities( ids );
+
+      flat_set<public_key_type> available_keys;
+      available_keys.reserve( _keys.size() );
+      for( const auto& key : _keys )
+         available_keys.insert( key.first );
+      // accounts deeper than the check looks are not resolved, they are simply not satisfied
+      return tx.get_required_signatures( _chain_id, available_keys,
+                                         [&authorities]( account_id_type id ) -> const authority* {
+                                            auto itr = authorities.find( id );
+                                            return itr == authorities.end() ? nullptr : &itr->second.active;
+                                         },
+                                         [&authorities]( account_id_type id ) -> const authority* {
+                                            auto itr = authorities.find( id );
+                                            return itr == authorities.end() ? nullptr : &itr->second.owner;
+                                         },
+                                         _signing_max_authority_depth );
    }
 
    bool copy_wallet_file( string destination_filename )
@@ -2004,14 +2114,20 @@ public:
 
    signed_transaction sign_transaction(signed_transaction tx, bool broadcast = false)
    {
-      set<public_key_type> pks = _remote_db->get_potential_signatures( tx );
-      flat_set<public_key_type> owned_keys;
-      owned_keys.reserve( pks.size() );
-      std::copy_if( pks.begin(), pks.end(), std::inserter(owned_keys, owned_keys.end()),
-                    [this](const public_key_type& pk){ return _keys.find(pk) != _keys.end(); } );
-      set<public_key_type> approving_key_set = _remote_db->get_required_signatures( tx, owned_keys );
+      set<public_key_type> approving_key_set;
+      if( _local_signing )
+         approving_key_set = get_local_required_signatures( tx );
+      else
+      {
+         set<public_key_type> pks = _remote_db->get_potential_signatures( tx );
+         flat_set<public_key_type> owned_keys;
+         owned_keys.reserve( pks.size() );
+         std::copy_if( pks.begin(), pks.end(), std::inserter(owned_keys, owned_keys.end()),
+                       [this](const public_key_type& pk){ return _keys.find(pk) != _keys.end(); } );
+         approving_key_set = _remote_db->get_required_signatures( tx, owned_keys );
+      }
 
-      auto dyn_props = get_dynamic_global_properties();
+      auto dyn_props = _local_signing ? *_signing_dynamic_props : get_dynamic_global_properties();
       tx.set_reference_block( dyn_props.head_block_id );
 
       // first, some bookkeeping, expire old items from _recently_generated_transactions
@@ -2064,6 +2180,39 @@ public:
       return tx;
    }
 
+   vector<signed_transaction> sign_and_broadcast( vector<signed_transaction> txs )
+   {
+      for( auto& tx : txs )
+         tx = sign_transaction( tx, false );
+
+      // keep all of them in flight on the connection instead of waiting for each reply
+      vector< fc::future<void> > broadcasts;
+      broadcasts.reserve( txs.size() );
+      for( const auto& tx : txs )
+      {
+         auto net_broadcast = _remote_net_broadcast;
+         broadcasts.push_back( fc::async( [net_broadcast,tx]() {
+            net_broadcast->broadcast_transaction( tx );
+         }, "Broadcast transaction" ) );
+      }
+
+      vector<string> failures;
+      for( size_t i = 0; i < broadcasts.size(); ++i )
+      {
+         try
+         {
+            broadcasts[i].wait();
+         }
+         catch (const fc::exception& e)
+         {
+            elog("Caught exception while broadcasting tx ${id}:  ${e}", ("id", txs[i].id().str())("e", e.to_detail_string()) );
+            failures.push_back( txs[i].id().str() + ": " + e.to_string() );
+         }
+      }
+      FC_ASSERT( failures.empty(), "${n} of ${m} transactions were not broadcast", ("n", failures.size())("m", txs.size())("failures", failures) );
+      return txs;
+   }
+
    memo_data sign_memo(string from, string to, string memo)
    {
       FC_ASSERT( !self.is_locked() );
@@ -3616,6 +3765,16 @@ signed_transaction wallet_api::sign_transaction(signed_transaction tx, bool broa
    return my->sign_transaction( tx, broadcast);
 } FC_CAPTURE_AND_RETHROW( (tx) ) }
 
+void wallet_api::set_local_signing( bool enabled )
+{
+   my->set_local_signing( enabled );
+}
+
+vector<signed_transaction> wallet_api::sign_and_broadcast( vector<signed_transaction> txs )
+{ try {
+   return my->sign_and_broadcast( txs );
+} FC_CAPTURE_AND_RETHROW( (txs.size()) ) }
+
 operation wallet_api::get_prototype_operation(string operation_name)
 {
    return my->get_prototype_operation( operation_name );
@@ -29,12 +29,17 @@
 #include <graphene/utilities/tempdir.hpp>
 
 #include <graphene/account_history/account_history_plugin.hpp>
+#include <graphene/elasticsearch/elasticsearch_plugin.hpp>
 
+#include <fc/network/http/server.hpp>
 #include <fc/thread/thread.hpp>
 #include <fc/smart_ref_impl.hpp>
 
+#include <boost/filesystem/operations.hpp>
 #include <boost/filesystem/path.hpp>
 
+#include <fstream>
+
 #define BOOST_TEST_MODULE Test Application
 #include <boost/test/included/unit_test.hpp>
 
@@ -150,3 +155,205 @@ BOOST_AUTO_TEST_CASE( two_node_network )
       throw;
    }
 }
+
+BOOST_AUTO_TEST_CASE( compact_block_relay )
+{
+   using namespace graphene::chain;
+   using namespace graphene::app;
+   try {
+      fc::temp_directory app_dir( graphene::utilities::temp_directory_path() );
+      fc::temp_directory app2_dir( graphene::utilities::temp_directory_path() );
+
+      graphene::app::application app1;
+      boost::program_options::variables_map cfg;
+      cfg.emplace("p2p-endpoint", boost::program_options::variable_value(string("127.0.0.1:5050"), false));
+      app1.initialize(app_dir.path(), cfg);
+
+      graphene::app::application app2;
+      auto cfg2 = cfg;
+      cfg2.erase("p2p-endpoint");
+      cfg2.emplace("p2p-endpoint", boost::program_options::variable_value(string("127.0.0.1:5151"), false));
+      cfg2.emplace("seed-node", boost::program_options::variable_value(vector<string>{"127.0.0.1:5050"}, false));
+      app2.initialize(app2_dir.path(), cfg2);
+
+      app1.startup();
+      fc::usleep(fc::milliseconds(500));
+      app2.startup();
+      fc::usleep(fc::milliseconds(500));
+      BOOST_REQUIRE_EQUAL(app1.p2p_node()->get_connection_count(), 1);
+
+      std::shared_ptr<chain::database> db1 = app1.chain_database();
+      std::shared_ptr<chain::database> db2 = app2.chain_database();
+      account_id_type nathan_id = db2->get_index_type<account_index>().indices().get<by_name>().find( "nathan" )->id;
+      fc::ecc::private_key nathan_key = fc::ecc::private_key::regenerate(fc::sha256::hash(string("nathan")));
+
+      BOOST_TEST_MESSAGE( "Broadcasting a transaction both nodes will have" );
+      signed_transaction relayed_trx;
+      {
+         balance_claim_operation claim_op;
+         balance_id_type bid = balance_id_type();
+         claim_op.deposit_to_account = nathan_id;
+         claim_op.balance_to_claim = bid;
+         claim_op.balance_owner_key = nathan_key.get_public_key();
+         claim_op.total_claimed = bid(*db1).balance;
+         relayed_trx.operations.push_back( claim_op );
+         db1->current_fee_schedule().set_fee( relayed_trx.operations.back() );
+         relayed_trx.set_expiration( db1->get_slot_time( 10 ) );
+         relayed_trx.sign( nathan_key, db1->get_chain_id() );
+      }
+      db1->push_transaction(relayed_trx);
+      app1.p2p_node()->broadcast(graphene::net::trx_message(relayed_trx));
+      fc::usleep(fc::milliseconds(500));
+
+      BOOST_TEST_MESSAGE( "Pushing a transaction only the block producer has" );
+      signed_transaction local_trx;
+      {
+         transfer_operation xfer_op;
+         xfer_op.from = nathan_id;
+         xfer_op.to = GRAPHENE_NULL_ACCOUNT;
+         xfer_op.amount = asset( 1000000 );
+         local_trx.operations.push_back( xfer_op );
+         db2->current_fee_schedule().set_fee( local_trx.operations.back() );
+         local_trx.set_expiration( db2->get_slot_time( 10 ) );
+         local_trx.sign( nathan_key, db2->get_chain_id() );
+      }
+      db2->push_transaction(local_trx);
+      BOOST_CHECK_EQUAL( db1->get_balance( GRAPHENE_NULL_ACCOUNT, asset_id_type() ).amount.value, 0 );
+
+      fc::ecc::private_key committee_key = fc::ecc::private_key::regenerate(fc::sha256::hash(string("nathan")));
+      auto block_1 = db2->generate_block(
+         db2->get_slot_time(1),
+         db2->get_scheduled_witness(1),
+         committee_key,
+         database::skip_nothing);
+      BOOST_REQUIRE_EQUAL( block_1.transactions.size(), 2 );
+
+      app2.p2p_node()->broadcast(graphene::net::block_message( block_1 ));
+      fc::usleep(fc::milliseconds(500));
+
+      BOOST_CHECK_EQUAL(app1.p2p_node()->get_connection_count(), 1);
+      BOOST_CHECK_EQUAL(db1->head_block_num(), 1);
+      BOOST_CHECK( db1->head_block_id() == block_1.id() );
+      BOOST_CHECK_EQUAL( db1->get_balance( GRAPHENE_NULL_ACCOUNT, asset_id_type() ).amount.value, 1000000 );
+
+      fc::variant_object info1 = app1.p2p_node()->network_get_info();
+      fc::variant_object info2 = app2.p2p_node()->network_get_info();
+      BOOST_CHECK_EQUAL( info2["compact_blocks_sent"].as<uint32_t>(), 1 );
+      BOOST_CHECK_EQUAL( info1["compact_blocks_received"].as<uint32_t>(), 1 );
+      BOOST_CHECK_EQUAL( info1["compact_block_transactions_fetched"].as<uint32_t>(), 1 );
+      BOOST_CHECK_EQUAL( info1["compact_block_fallbacks"].as<uint32_t>(), 0 );
+   } catch( fc::exception& e ) {
+      edump((e.to_detail_string()));
+      throw;
+   }
+}
+
+BOOST_AUTO_TEST_CASE( elasticsearch_retry_and_spool )
+{
+   using namespace graphene::chain;
+   using namespace graphene::app;
+   try {
+      fc::temp_directory app_dir( graphene::utilities::temp_directory_path() );
+      fc::temp_directory spool_dir( graphene::utilities::temp_directory_path() );
+
+      // a file the exporter did not write must neither stop it nor be touched
+      fc::path stray = spool_dir.path() / "notes.json";
+      {
+         std::ofstream out( stray.generic_string() );
+         out << "{}";
+      }
+
+      BOOST_TEST_MESSAGE( "Starting a mock elasticsearch node" );
+      bool accepting = false;
+      vector<string> bodies;
+      fc::http::server mock_node;
+      mock_node.listen( fc::ip::endpoint::from_string( "127.0.0.1:9292" ) );
+      mock_node.on_request( [&]( const fc::http::request& req, const fc::http::server::response& resp ) {
+         bodies.emplace_back( req.body.begin(), req.body.end() );
+         const string reply = accepting ? "{\"errors\":false}" : "{}";
+         resp.add_header( "Content-Length", std::to_string( reply.size() ) );
+         resp.set_status( accepting ? fc::http::reply::OK : fc::http::reply::InternalServerError );
+         resp.write( reply.c_str(), reply.size() );
+      });
+
+      graphene::app::application app1;
+      auto es_plugin = app1.register_plugin<graphene::elasticsearch::elasticsearch_plugin>();
+      boost::program_options::variables_map cfg;
+      cfg.emplace("p2p-endpoint", boost::program_options::variable_value(string("127.0.0.1:5353"), false));
+      cfg.emplace("plugins", boost::program_options::variable_value(string("elasticsearch"), false));
+      cfg.emplace("elasticsearch-node-url", boost::program_options::variable_value(string("http://127.0.0.1:9292/"), false));
+      cfg.emplace("elasticsearch-bulk-sync", boost::program_options::variable_value(uint32_t(1), false));
+      cfg.emplace("elasticsearch-bulk-replay", boost::program_options::variable_value(uint32_t(1), false));
+      cfg.emplace("elasticsearch-logs", boost::program_options::variable_value(false, false));
+      cfg.emplace("elasticsearch-max-retries", boost::program_options::variable_value(uint32_t(1), false));
+      cfg.emplace("elasticsearch-spool-dir", boost::program_options::variable_value(boost::filesystem::path(spool_dir.path().generic_string()), false));
+      app1.initialize(app_dir.path(), cfg);
+      app1.initialize_plugins(cfg);
+      app1.startup();
+      app1.startup_plugins();
+
+      std::shared_ptr<chain::database> db = app1.chain_database();
+      account_id_type nathan_id = db->get_index_type<account_index>().indices().get<by_name>().find( "nathan" )->id;
+      fc::ecc::private_key nathan_key = fc::ecc::private_key::regenerate(fc::sha256::hash(string("nathan")));
+
+      auto push_and_generate = [&]( const operation& op ) {
+         signed_transaction trx;
+         trx.operations.push_back( op );
+         db->current_fee_schedule().set_fee( trx.operations.back() );
+         trx.set_expiration( db->get_slot_time( 10 ) );
+         trx.sign( nathan_key, db->get_chain_id() );
+         db->push_transaction( trx );
+         db->generate_block( db->get_slot_time(1), db->get_scheduled_witness(1), nathan_key, database::skip_nothing );
+      };
+      auto wait_for = [&]( const std::function<bool(const graphene::elasticsearch::export_stats&)>& done ) {
+         for( int i = 0; i < 100 && !done( es_plugin->get_export_stats() ); ++i )
+            fc::usleep( fc::milliseconds(100) );
+         return es_plugin->get_export_stats();
+      };
+
+      BOOST_TEST_MESSAGE( "Exporting while the node fails every request" );
+      balance_claim_operation claim_op;
+      claim_op.deposit_to_account = nathan_id;
+      claim_op.balance_to_claim = balance_id_type();
+      claim_op.balance_owner_key = nathan_key.get_public_key();
+      claim_op.total_claimed = balance_id_type()(*db).balance;
+      push_and_generate( claim_op );
+
+      auto stats = wait_for( []( const graphene::elasticsearch::export_stats& s ) { return s.spooled_bulks > 0; } );
+      BOOST_CHECK_EQUAL( stats.spooled_bulks, 1 );
+      BOOST_CHECK_EQUAL( stats.failed_requests, 2 ); // the first attempt and one retry
+      BOOST_CHECK_EQUAL( stats.sent_documents, 0 );
+      BOOST_CHECK_EQUAL( stats.last_exported_block, 1 );
+      BOOST_REQUIRE_EQUAL( bodies.size(), 2 );
+      BOOST_CHECK_EQUAL( bodies[0], bodies[1] );
+
+      BOOST_TEST_MESSAGE( "Exporting once the node accepts requests again" );
+      accepting = true;
+      transfer_operation xfer_op;
+      xfer_op.from = nathan_id;
+      xfer_op.to = GRAPHENE_NULL_ACCOUNT;
+      xfer_op.amount = asset( 1000 );
+      push_and_generate( xfer_op );
+
+      stats = wait_for( []( const graphene::elasticsearch::export_stats& s ) { return s.last_exported_block >= 2; } );
+      BOOST_CHECK_EQUAL( stats.spooled_bulks, 0 );
+      BOOST_CHECK_EQUAL( stats.failed_requests, 2 );
+      BOOST_CHECK_EQUAL( stats.block_lag, 0 );
+      // one document for nathan from the claim, one each for nathan and null-account from the transfer
+      BOOST_CHECK_EQUAL( stats.sent_documents, 3 );
+      BOOST_REQUIRE_EQUAL( bodies.size(), 4 );
+      BOOST_CHECK_EQUAL( bodies[2], bodies[0] ); // the spooled bulk goes first
+      BOOST_CHECK( bodies[3] != bodies[0] );
+
+      uint32_t spool_files = 0;
+      for( boost::filesystem::directory_iterator it( spool_dir.path().generic_string() ); it != boost::filesystem::directory_iterator(); ++it )
+         ++spool_files;
+      BOOST_CHECK_EQUAL( spool_files, 1 );
+      BOOST_CHECK( fc::exists( stray ) );
+
+      app1.shutdown_plugins();
+   } catch( fc::exception& e ) {
+      edump((e.to_detail_string()));
+      throw;
+   }
+}
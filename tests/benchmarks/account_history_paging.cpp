@@ -0,0 +1,128 @@
+/*
+ * Copyright (c) 2015 Cryptonomex, Inc., and contributors.
+ *
+ * The MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#include <graphene/app/api.hpp>
+#include <graphene/chain/operation_history_object.hpp>
+
+#include <fc/smart_ref_impl.hpp>
+
+#include <boost/test/auto_unit_test.hpp>
+
+#include "../common/database_fixture.hpp"
+
+using namespace graphene::chain;
+using namespace graphene::chain::test;
+using namespace graphene::app;
+
+BOOST_FIXTURE_TEST_CASE( account_history_paging_bench, database_fixture )
+{
+   try {
+      ACTORS( (alice) );
+      generate_block();
+
+      // 1M history entries for alice, every 10th one a limit order so the filtered queries have something to skip
+      const uint32_t num_ops = 1000000;
+      const auto& stats = alice.statistics( db );
+      uint32_t sequence = stats.total_ops;
+      account_transaction_history_id_type most_recent = stats.most_recent_op;
+      for( uint32_t i = 0; i < num_ops; ++i )
+      {
+         operation op = transfer_operation();
+         if( i % 10 == 0 )
+            op = limit_order_create_operation();
+         const auto& oho = db.create<operation_history_object>( [&]( operation_history_object& h ) {
+            h.op = op;
+            h.block_num = db.head_block_num();
+         });
+         most_recent = db.create<account_transaction_history_object>( [&]( account_transaction_history_object& obj ) {
+            obj.operation_id = oho.id;
+            obj.account = alice_id;
+            obj.sequence = ++sequence;
+            obj.next = most_recent;
+            obj.op_type = oho.op.which();
+         }).id;
+      }
+      db.modify( stats, [&]( account_statistics_object& obj ) {
+         obj.most_recent_op = most_recent;
+         obj.total_ops = sequence;
+      });
+
+      history_api hist_api( app );
+      const uint16_t limit_order_create = operation::tag<limit_order_create_operation>::value;
+      for( uint32_t depth : { 0u, 10000u, 100000u, 500000u, 900000u } )
+      {
+         // get_account_history() walks the linked list from the most recent operation down to its start
+         const uint32_t pages = 10;
+         const operation_history_id_type newest = most_recent( db ).operation_id;
+         operation_history_id_type start( newest.instance.value - depth );
+         auto begin = fc::time_point::now();
+         for( uint32_t p = 0; p < pages; ++p )
+         {
+            auto ops = hist_api.get_account_history( alice_id, operation_history_id_type(), 100, start );
+            BOOST_REQUIRE_EQUAL( ops.size(), 100 );
+            start = operation_history_id_type( ops.back().id.instance() - 1 );
+         }
+         auto linked = fc::time_point::now() - begin;
+
+         uint32_t cursor = sequence - depth;
+         begin = fc::time_point::now();
+         for( uint32_t p = 0; p < pages; ++p )
+         {
+            auto page = hist_api.get_account_history_by_sequence( alice_id, cursor, 100 );
+            BOOST_REQUIRE_EQUAL( page.operations.size(), 100 );
+            cursor = page.next;
+         }
+         auto indexed = fc::time_point::now() - begin;
+
+         cursor = sequence - depth;
+         begin = fc::time_point::now();
+         for( uint32_t p = 0; p < pages; ++p )
+         {
+            auto page = hist_api.get_account_history_by_sequence( alice_id, cursor, 100, { limit_order_create } );
+            BOOST_REQUIRE_EQUAL( page.operations.size(), 100 );
+            cursor = page.next;
+         }
+         auto filtered = fc::time_point::now() - begin;
+
+         ilog( "page of 100 at depth ${d}: ${l} us linked list, ${i} us by sequence, ${f} us filtered by type",
+               ("d", depth)("l", linked.count() / pages)("i", indexed.count() / pages)("f", filtered.count() / pages) );
+      }
+
+      // all of it, one page after the other
+      uint32_t cursor = 0;
+      uint32_t total = 0;
+      auto begin = fc::time_point::now();
+      do
+      {
+         auto page = hist_api.get_account_history_by_sequence( alice_id, cursor, 100 );
+         total += page.operations.size();
+         cursor = page.next;
+      } while( cursor != 0 );
+      auto elapsed = fc::time_point::now() - begin;
+      BOOST_CHECK_EQUAL( total, sequence );
+      ilog( "paged through ${n} operations in ${t} ms", ("n", total)("t", elapsed.count() / 1000) );
+   } catch( fc::exception& e ) {
+      edump((e.to_detail_string()));
+      throw;
+   }
+}
@@ -0,0 +1,104 @@
+/*
+ * Copyright (c) 2015 Cryptonomex, Inc., and contributors.
+ *
+ * The MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#include <graphene/app/api_thread_pool.hpp>
+#include <graphene/app/database_api.hpp>
+
+#include <fc/smart_ref_impl.hpp>
+#include <fc/thread/thread.hpp>
+
+#include <boost/test/auto_unit_test.hpp>
+
+#include <algorithm>
+#include <atomic>
+
+#include "../common/database_fixture.hpp"
+
+using namespace graphene::chain;
+using namespace graphene::chain::test;
+using namespace graphene::app;
+
+BOOST_FIXTURE_TEST_CASE( api_thread_pool_latency_bench, database_fixture )
+{
+   try {
+      ACTORS( (alice)(bob) );
+      fund( alice, asset( 100000000 ) );
+      generate_block();
+
+      auto pool = std::make_shared<api_thread_pool>( db, 4 );
+      fc::api<database_api> api( std::make_shared<database_api>( std::ref( db ) ) );
+      pool->wrap( api );
+
+      const uint32_t num_clients = 8;
+      const uint32_t num_blocks = 200;
+      std::atomic<bool> done( false );
+      std::vector< std::unique_ptr<fc::thread> > clients;
+      std::vector< fc::future< std::vector<int64_t> > > results;
+      for( uint32_t i = 0; i < num_clients; ++i )
+      {
+         clients.emplace_back( new fc::thread( "client " + fc::to_string( uint64_t(i) ) ) );
+         results.push_back( clients.back()->async( [&api,&done,alice_id,bob_id]() {
+            std::vector<int64_t> latencies;
+            while( !done )
+            {
+               auto start = fc::time_point::now();
+               if( latencies.size() % 2 )
+                  api->get_full_accounts( { "alice", "bob" }, false );
+               else
+                  api->get_objects( { alice_id, bob_id, object_id_type( dynamic_global_property_id_type() ) } );
+               latencies.push_back( ( fc::time_point::now() - start ).count() );
+            }
+            return latencies;
+         }) );
+      }
+
+      auto start = fc::time_point::now();
+      for( uint32_t b = 0; b < num_blocks; ++b )
+      {
+         for( uint32_t t = 0; t < 20; ++t )
+            transfer( alice, bob, asset( 1 ) );
+         generate_block();
+      }
+      auto elapsed = fc::time_point::now() - start;
+      done = true;
+
+      std::vector<int64_t> latencies;
+      for( auto& r : results )
+      {
+         auto l = r.wait();
+         latencies.insert( latencies.end(), l.begin(), l.end() );
+      }
+      for( auto& c : clients )
+         c->quit();
+
+      std::sort( latencies.begin(), latencies.end() );
+      BOOST_REQUIRE( !latencies.empty() );
+      ilog( "${n} calls from ${c} clients, p50 ${p50} us, p99 ${p99} us, ${bps} blocks/s",
+            ("n", latencies.size())("c", num_clients)
+            ("p50", latencies[ latencies.size() / 2 ])("p99", latencies[ latencies.size() * 99 / 100 ])
+            ("bps", num_blocks * 1000000.0 / elapsed.count()) );
+   } catch( fc::exception& e ) {
+      edump((e.to_detail_string()));
+      throw;
+   }
+}
@@ -0,0 +1,81 @@
+/*
+ * Copyright (c) 2015 Cryptonomex, Inc., and contributors.
+ *
+ * The MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#include <graphene/chain/account_object.hpp>
+#include <graphene/db/object_database.hpp>
+
+#include <fc/time.hpp>
+
+#include <boost/test/auto_unit_test.hpp>
+
+#include <random>
+
+using namespace graphene::chain;
+
+namespace {
+
+template<typename Index>
+void time_lookups( const char* name, uint32_t num_objects, uint32_t num_lookups )
+{
+   graphene::db::object_database db;
+   db.add_index< primary_index< Index > >();
+   for( uint32_t i = 0; i < num_objects; ++i )
+      db.create<account_balance_object>( [i]( account_balance_object& obj ) {
+         obj.owner = account_id_type( i );
+      });
+
+   std::mt19937 rng( num_objects );
+   std::uniform_int_distribution<uint32_t> pick( 0, num_objects - 1 );
+   std::vector<account_balance_id_type> ids;
+   ids.reserve( num_lookups );
+   for( uint32_t i = 0; i < num_lookups; ++i )
+      ids.push_back( account_balance_id_type( pick( rng ) ) );
+
+   uint64_t check = 0;
+   auto begin = fc::time_point::now();
+   for( const auto& id : ids )
+      check += id( db ).owner.instance.value;
+   auto elapsed = fc::time_point::now() - begin;
+   BOOST_CHECK( check > 0 );
+   ilog( "${name}: ${n} random lookups among ${o} objects in ${t} ms",
+         ("name", name)("n", num_lookups)("o", num_objects)("t", elapsed.count() / 1000) );
+}
+
+}
+
+BOOST_AUTO_TEST_CASE( object_lookup_bench )
+{
+   try {
+      typedef generic_index<account_balance_object, account_balance_object_multi_index_type> tree_index;
+      typedef dense_generic_index<account_balance_object, account_balance_object_multi_index_type> dense_index;
+      const uint32_t num_lookups = 10000000;
+      for( uint32_t num_objects : { 1000000u, 10000000u, 50000000u } )
+      {
+         time_lookups<tree_index>( "by_id tree", num_objects, num_lookups );
+         time_lookups<dense_index>( "dense table", num_objects, num_lookups );
+      }
+   } catch( fc::exception& e ) {
+      edump((e.to_detail_string()));
+      throw;
+   }
+}
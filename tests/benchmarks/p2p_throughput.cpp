@@ -0,0 +1,167 @@
+/*
+ * Copyright (c) 2015 Cryptonomex, Inc., and contributors.
+ *
+ * The MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#include <graphene/net/core_messages.hpp>
+#include <graphene/net/message_oriented_connection.hpp>
+
+#include <fc/network/ip.hpp>
+#include <fc/network/tcp_socket.hpp>
+#include <fc/thread/future.hpp>
+#include <fc/thread/thread.hpp>
+
+#include <boost/test/auto_unit_test.hpp>
+
+#include <algorithm>
+#include <thread>
+
+using namespace graphene::net;
+
+namespace {
+
+struct counting_delegate : message_oriented_connection_delegate
+{
+   uint64_t                 messages_expected = 0;
+   uint64_t                 messages_received = 0;
+   uint64_t                 bytes_received = 0;
+   fc::promise<void>::ptr   all_received = fc::promise<void>::ptr( new fc::promise<void>() );
+
+   void on_message( message_oriented_connection*, const message& received_message ) override
+   {
+      received_message.id(); // node_impl hashes every message it receives
+      bytes_received += received_message.size;
+      if( ++messages_received == messages_expected )
+         all_received->set_value();
+   }
+   void on_connection_closed( message_oriented_connection* ) override {}
+};
+
+/**
+ *  Sends messages_per_peer messages of message_size bytes over each of num_peers loopback connections, and returns
+ *  the time until the receiving side, whose delegate runs on a single thread like node_impl, has them all.
+ *  Both sides spread their connections over num_io_threads threads, 0 for none.
+ */
+fc::microseconds run_loopback( uint32_t num_peers, uint32_t num_io_threads, uint32_t messages_per_peer, uint32_t message_size )
+{
+   fc::thread node_thread( "bench node" );
+   fc::thread peers_thread( "bench peers" );
+   std::vector< std::unique_ptr<fc::thread> > node_io_threads;
+   std::vector< std::unique_ptr<fc::thread> > peer_io_threads;
+   for( uint32_t i = 0; i < num_io_threads; ++i )
+   {
+      node_io_threads.emplace_back( new fc::thread( "bench node io " + fc::to_string( uint64_t(i) ) ) );
+      peer_io_threads.emplace_back( new fc::thread( "bench peer io " + fc::to_string( uint64_t(i) ) ) );
+   }
+   auto io_thread = [&]( std::vector< std::unique_ptr<fc::thread> >& threads, uint32_t i ) -> fc::thread* {
+      return threads.empty() ? nullptr : threads[ i % threads.size() ].get();
+   };
+
+   counting_delegate node_delegate;
+   node_delegate.messages_expected = uint64_t( num_peers ) * messages_per_peer;
+   counting_delegate peer_delegate;
+
+   fc::tcp_server server;
+   server.listen( fc::ip::endpoint( fc::ip::address( "127.0.0.1" ), 0 ) );
+   fc::ip::endpoint server_endpoint( fc::ip::address( "127.0.0.1" ), server.get_port() );
+
+   std::vector< std::unique_ptr<message_oriented_connection> > node_connections;
+   std::vector< std::unique_ptr<message_oriented_connection> > peer_connections;
+   fc::future<void> accepted = node_thread.async( [&]() {
+      for( uint32_t i = 0; i < num_peers; ++i )
+      {
+         node_connections.emplace_back( new message_oriented_connection( &node_delegate, io_thread( node_io_threads, i ) ) );
+         server.accept( node_connections.back()->get_socket() );
+         node_connections.back()->accept();
+      }
+   }, "accept peers" );
+   peers_thread.async( [&]() {
+      for( uint32_t i = 0; i < num_peers; ++i )
+      {
+         peer_connections.emplace_back( new message_oriented_connection( &peer_delegate, io_thread( peer_io_threads, i ) ) );
+         peer_connections.back()->connect_to( server_endpoint );
+      }
+   }, "connect peers" ).wait();
+   accepted.wait();
+
+   message payload;
+   payload.msg_type = core_message_type_last + 1;
+   payload.data.resize( message_size, 'x' );
+   payload.size = message_size;
+
+   auto start = fc::time_point::now();
+   peers_thread.async( [&]() {
+      std::vector< fc::future<void> > senders;
+      for( auto& connection : peer_connections )
+      {
+         message_oriented_connection* c = connection.get();
+         senders.push_back( fc::async( [c,&payload,messages_per_peer]() {
+            for( uint32_t i = 0; i < messages_per_peer; ++i )
+               c->send_message( payload );
+         }, "send messages" ) );
+      }
+      for( auto& s : senders )
+         s.wait();
+   }, "send to node" ).wait();
+   fc::future<void>( node_delegate.all_received ).wait();
+   auto elapsed = fc::time_point::now() - start;
+
+   BOOST_CHECK_EQUAL( node_delegate.bytes_received, uint64_t( num_peers ) * messages_per_peer * message_size );
+
+   peers_thread.async( [&]() { peer_connections.clear(); }, "close peers" ).wait();
+   node_thread.async( [&]() { node_connections.clear(); }, "close node" ).wait();
+   server.close();
+   for( auto& t : node_io_threads )
+      t->quit();
+   for( auto& t : peer_io_threads )
+      t->quit();
+   node_thread.quit();
+   peers_thread.quit();
+   return elapsed;
+}
+
+} // anonymous namespace
+
+BOOST_AUTO_TEST_CASE( p2p_loopback_throughput_bench )
+{
+   try {
+      const uint32_t num_peers = 64;
+      const uint32_t messages_per_peer = 1000;
+      const uint32_t message_size = 2048;
+      const uint32_t max_threads = std::max( 1u, std::thread::hardware_concurrency() );
+
+      for( uint32_t num_io_threads : { 0u, 1u, 2u, 4u, max_threads } )
+      {
+         if( num_io_threads > max_threads )
+            continue;
+         fc::microseconds elapsed = run_loopback( num_peers, num_io_threads, messages_per_peer, message_size );
+         double seconds = elapsed.count() / 1000000.0;
+         uint64_t total_messages = uint64_t( num_peers ) * messages_per_peer;
+         ilog( "${p} peers, ${t} io threads: ${mbps} MB/s, ${mps} messages/s",
+               ("p", num_peers)("t", num_io_threads)
+               ("mbps", total_messages * message_size / seconds / ( 1024 * 1024 ))
+               ("mps", total_messages / seconds) );
+      }
+   } catch( fc::exception& e ) {
+      edump((e.to_detail_string()));
+      throw;
+   }
+}
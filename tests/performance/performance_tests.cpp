@@ -28,11 +28,16 @@
 
 #include <graphene/chain/account_object.hpp>
 #include <graphene/chain/asset_object.hpp>
+#include <graphene/chain/market_object.hpp>
 #include <graphene/chain/proposal_object.hpp>
 
 #include <graphene/db/simple_index.hpp>
 
 #include <fc/crypto/digest.hpp>
+#include <fc/thread/thread.hpp>
+
+#include <thread>
+
 #include "../common/database_fixture.hpp"
 
 using namespace graphene::chain;
@@ -44,13 +49,214 @@ BOOST_AUTO_TEST_CASE( sigcheck_benchmark )
    fc::ecc::private_key nathan_key = fc::ecc::private_key::generate();
    auto digest = fc::sha256::hash("hello");
    auto sig = nathan_key.sign_compact( digest );
+   const uint32_t count = 100000;
    auto start = fc::time_point::now();
-   for( uint32_t i = 0; i < 100000; ++i )
+   for( uint32_t i = 0; i < count; ++i )
       auto pub = fc::ecc::public_key( sig, digest );
    auto end = fc::time_point::now();
    auto elapsed = end-start;
-   wdump( ((100000.0*1000000.0) / elapsed.count()) );
+   wdump( ((count*1000000.0) / elapsed.count()) );
+
+   // the same recoveries spread over one thread per core, as database::precompute_signature_keys() does
+   const uint32_t num_threads = std::max( 1u, std::thread::hardware_concurrency() );
+   std::vector< std::unique_ptr<fc::thread> > threads;
+   for( uint32_t t = 0; t < num_threads; ++t )
+      threads.emplace_back( new fc::thread( "sigcheck " + fc::to_string( uint64_t(t) ) ) );
+   std::vector< fc::future<void> > results;
+   start = fc::time_point::now();
+   for( uint32_t t = 0; t < num_threads; ++t )
+      results.push_back( threads[t]->async( [&sig,&digest,t,num_threads,count]() {
+         for( uint32_t i = t; i < count; i += num_threads )
+            auto pub = fc::ecc::public_key( sig, digest );
+      } ) );
+   for( auto& r : results )
+      r.wait();
+   end = fc::time_point::now();
+   elapsed = end-start;
+   wdump( (num_threads)((count*1000000.0) / elapsed.count()) );
+   for( auto& t : threads )
+      t->quit();
+}
+BOOST_AUTO_TEST_CASE( undo_session_benchmark )
+{
+   // like applying blocks of transfers: a block session with a merged child session per transfer
+   database db;
+   db._undo_db.enable();
+   const uint32_t num_accounts = 10000;
+   std::vector<const account_balance_object*> balances;
+   for( uint32_t i = 0; i < num_accounts; ++i )
+      balances.push_back( &db.create<account_balance_object>( [&]( account_balance_object& obj ){
+         obj.owner = account_id_type( i );
+         obj.balance = 1000000;
+      }) );
+
+   const uint32_t num_blocks = 2000;
+   const uint32_t transfers_per_block = 200;
+   auto start = fc::time_point::now();
+   for( uint32_t b = 0; b < num_blocks; ++b )
+   {
+      auto block_session = db._undo_db.start_undo_session();
+      for( uint32_t t = 0; t < transfers_per_block; ++t )
+      {
+         auto trx_session = db._undo_db.start_undo_session();
+         const uint32_t from = ( b * transfers_per_block + t ) % num_accounts;
+         db.modify( *balances[from], []( account_balance_object& obj ){ obj.balance -= 1; } );
+         db.modify( *balances[(from + 1) % num_accounts], []( account_balance_object& obj ){ obj.balance += 1; } );
+         trx_session.merge();
+      }
+      block_session.undo();
+   }
+   auto end = fc::time_point::now();
+   auto elapsed = end-start;
+   wdump( ((num_blocks*(transfers_per_block+1)*1000000.0) / elapsed.count()) );
+}
+
+BOOST_AUTO_TEST_CASE( balance_transfer_benchmark )
+{
+   // transfers between 1M accounts holding 10 assets, as adjust_balance() applies them
+   database db;
+   const uint32_t num_accounts = 1000000;
+   const uint32_t num_assets = 10;
+   for( uint32_t i = 0; i < num_accounts; ++i )
+      for( uint32_t a = 0; a < num_assets; ++a )
+         db.adjust_balance( account_id_type( i ), asset( 1000000, asset_id_type( a ) ) );
+
+   const auto& bal_idx = dynamic_cast<const primary_index<account_balance_index>&>(
+                            db.get_index_type<account_balance_index>() );
+   const auto& holder_idx = bal_idx.get_secondary_index<asset_holder_index>();
+
+   const uint32_t num_transfers = 2000000;
+   auto run = [&]( const char* label ) {
+      auto start = fc::time_point::now();
+      for( uint32_t t = 0; t < num_transfers; ++t )
+      {
+         const uint32_t from = ( t * 7919 ) % num_accounts;
+         const asset amount( 1 + t % 100, asset_id_type( t % num_assets ) );
+         db.adjust_balance( account_id_type( from ), -amount );
+         db.adjust_balance( account_id_type( ( from + 1 ) % num_accounts ), amount );
+      }
+      auto elapsed = fc::time_point::now() - start;
+      ilog( "${l}: ${n} transfers per second", ("l", label)("n", num_transfers * 1000000.0 / elapsed.count()) );
+   };
+
+   run( "no holders kept" );
+   // keep the holders of one asset, as a top holders special authority would
+   holder_idx.holders( asset_id_type() );
+   run( "holders of one asset kept" );
+   auto start = fc::time_point::now();
+   BOOST_CHECK_EQUAL( holder_idx.holders( asset_id_type() ).size(), num_accounts );
+   ilog( "sorting in the changed balances took ${t} ms", ("t", (fc::time_point::now() - start).count() / 1000) );
 }
+
+BOOST_AUTO_TEST_CASE( limit_order_book_benchmark )
+{
+   // a book of 1M open orders on one market, every one of them with a memo as the telecom orders carry, then
+   // partial fills walking the book from the best price the way database::apply_order() does
+   database db;
+   db._undo_db.enable();
+   const auto key = fc::ecc::private_key::regenerate( fc::sha256::hash( "key" ) );
+   memo_data memo;
+   memo.set_message( key, key.get_public_key(), "order 1 of many, with some payload", 1 );
+
+   const uint32_t num_orders = 1000000;
+   const asset_id_type base( 1 );
+   const asset_id_type quote( 2 );
+   auto start = fc::time_point::now();
+   for( uint32_t i = 0; i < num_orders; ++i )
+      db.create<limit_order_object>( [&]( limit_order_object& o ) {
+         o.seller = account_id_type( i % 1000 );
+         o.for_sale = 1000;
+         o.sell_price = price( asset( 1000, base ), asset( 1000 + i % 5000, quote ) );
+         o.expiration = fc::time_point_sec( 1000000 + i );
+         o.request_id = i;
+         o.p_memo = memo;
+      });
+   auto created = fc::time_point::now() - start;
+   ilog( "${n} orders created in ${t} ms, ${s} bytes per order object and ${m} bytes per memo held out of line",
+         ("n", num_orders)("t", created.count() / 1000)
+         ("s", sizeof( limit_order_object ))("m", sizeof( memo_data ) + memo.message.size()) );
+
+   const auto& by_price_idx = db.get_index_type<limit_order_index>().indices().get<by_price>();
+   const uint32_t num_blocks = 100;
+   const uint32_t fills_per_block = 1000;
+   start = fc::time_point::now();
+   for( uint32_t b = 0; b < num_blocks; ++b )
+   {
+      auto block_session = db._undo_db.start_undo_session();
+      auto itr = by_price_idx.lower_bound( price::max( base, quote ) );
+      for( uint32_t f = 0; f < fills_per_block && itr != by_price_idx.end(); ++f, ++itr )
+      {
+         const limit_order_object& order = *itr;
+         BOOST_REQUIRE( order.sell_price.base.asset_id == base );
+         db.modify( order, []( limit_order_object& o ) { o.for_sale -= 1; } );
+      }
+      block_session.undo();
+   }
+   auto elapsed = fc::time_point::now() - start;
+   wdump( ((num_blocks * fills_per_block * 1000000.0) / elapsed.count()) );
+}
+
+BOOST_AUTO_TEST_CASE( block_hashing_benchmark )
+{
+   // a block of transfers, hashed the way applying and relaying it does: the block id at checkpoint, head block and
+   // block summary updates, and per transaction the id for the dupe check, the confirmation callbacks and the
+   // history plugins, the signature digest and the merkle digest
+   const chain_id_type chain_id = fc::sha256::hash( "chain" );
+   const auto key = fc::ecc::private_key::regenerate( fc::sha256::hash( "key" ) );
+   signed_block block;
+   for( uint32_t i = 0; i < 1000; ++i )
+   {
+      transfer_operation op;
+      op.from = account_id_type( i );
+      op.to = account_id_type( i + 1 );
+      op.amount = asset( i + 1 );
+      processed_transaction trx;
+      trx.operations.push_back( op );
+      trx.expiration = fc::time_point_sec( i );
+      trx.sign( key, chain_id );
+      trx.operation_results.push_back( void_result() );
+      block.transactions.push_back( trx );
+   }
+   block.transaction_merkle_root = block.calculate_merkle_root();
+   block.sign( key );
+
+   auto hash_block = [&]( const signed_block& b ) {
+      uint64_t sum = 0;
+      for( uint32_t n = 0; n < 3; ++n )
+         sum += b.id()._hash[1];
+      for( const auto& trx : b.transactions )
+      {
+         for( uint32_t n = 0; n < 3; ++n )
+            sum += trx.id()._hash[1];
+         sum += trx.sig_digest( chain_id )._hash[0];
+      }
+      sum += b.calculate_merkle_root()._hash[0];
+      return sum;
+   };
+
+   const uint32_t num_blocks = 100;
+   uint64_t uncached_sum = 0;
+   auto start = fc::time_point::now();
+   for( uint32_t i = 0; i < num_blocks; ++i )
+      uncached_sum += hash_block( block );
+   auto uncached = fc::time_point::now() - start;
+
+   uint64_t cached_sum = 0;
+   start = fc::time_point::now();
+   for( uint32_t i = 0; i < num_blocks; ++i )
+   {
+      signed_block copy = block; // as received, before cache_digests() is called on it
+      copy.cache_digests( chain_id );
+      cached_sum += hash_block( copy );
+   }
+   auto cached = fc::time_point::now() - start;
+
+   BOOST_CHECK_EQUAL( uncached_sum, cached_sum );
+   ilog( "hashing per block of ${n} transactions: ${u} us before caching, ${c} us with cache_digests()",
+         ("n", block.transactions.size())
+         ("u", uncached.count() / num_blocks)("c", cached.count() / num_blocks) );
+}
+
 /*
 BOOST_AUTO_TEST_CASE( transfer_benchmark )
 {
@@ -403,4 +403,56 @@ BOOST_AUTO_TEST_CASE( merkle_root )
    BOOST_CHECK( block.calculate_merkle_root() == c(dO) );
 }
 
+BOOST_AUTO_TEST_CASE( cached_digests )
+{
+   const chain_id_type chain_id = fc::sha256::hash( "chain" );
+   const auto key = fc::ecc::private_key::regenerate( fc::sha256::hash( "key" ) );
+
+   signed_block block;
+   processed_transaction trx;
+   trx.operations.push_back( transfer_operation() );
+   trx.sign( key, chain_id );
+   block.transactions.push_back( trx );
+   block.transaction_merkle_root = block.calculate_merkle_root();
+   block.sign( key );
+
+   const auto block_id = block.id();
+   const auto trx_id = trx.id();
+   const auto sig_digest = trx.sig_digest( chain_id );
+   block.cache_digests( chain_id );
+   BOOST_CHECK( block.id() == block_id );
+   BOOST_CHECK( block.transactions[0].id() == trx_id );
+   BOOST_CHECK( block.transactions[0].sig_digest( chain_id ) == sig_digest );
+   BOOST_CHECK( block.calculate_merkle_root() == block.transaction_merkle_root );
+   // a different chain id is hashed again
+   BOOST_CHECK( block.transactions[0].sig_digest( fc::sha256() ) != sig_digest );
+
+   // mutating members drop the kept values
+   signed_block copy = block;
+   copy.transactions[0].set_expiration( fc::time_point_sec( 1 ) );
+   BOOST_CHECK( copy.transactions[0].id() != trx_id );
+   copy.timestamp = fc::time_point_sec( 1 );
+   copy.sign( key );
+   BOOST_CHECK( copy.id() != block_id );
+
+   // a processed transaction built from a cached one has to hash its results
+   const signed_transaction& strx = block.transactions[0];
+   processed_transaction ptrx( strx );
+   ptrx.operation_results.push_back( void_result() );
+   BOOST_CHECK( ptrx.id() == trx_id );
+   BOOST_CHECK( ptrx.merkle_digest() != block.transactions[0].merkle_digest() );
+
+   // copies do not keep the values, so they may be changed through their fields
+   processed_transaction field_copy = block.transactions[0];
+   field_copy.expiration = fc::time_point_sec( 1 );
+   BOOST_CHECK( field_copy.id() != trx_id );
+   field_copy = block.transactions[0];
+   field_copy.operation_results.push_back( void_result() );
+   BOOST_CHECK( field_copy.id() == trx_id );
+   BOOST_CHECK( field_copy.merkle_digest() != block.transactions[0].merkle_digest() );
+   signed_block header_copy = block;
+   header_copy.timestamp = fc::time_point_sec( 1 );
+   BOOST_CHECK( header_copy.id() != block_id );
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -36,6 +36,8 @@
 #include <graphene/utilities/tempdir.hpp>
 
 #include <fc/crypto/digest.hpp>
+#include <fc/io/json.hpp>
+#include <fc/thread/thread.hpp>
 
 #include "../common/database_fixture.hpp"
 
@@ -125,6 +127,92 @@ BOOST_AUTO_TEST_CASE( block_database_test )
    }
 }
 
+BOOST_AUTO_TEST_CASE( block_database_packed_views_and_reopen )
+{
+   try {
+      fc::temp_directory data_dir( graphene::utilities::temp_directory_path() );
+      const fc::path blocks_file = data_dir.path() / "blocks";
+
+      block_database bdb;
+      bdb.open( data_dir.path() );
+
+      vector<signed_block> blocks;
+      uint64_t stored_bytes = 0;
+      signed_block b;
+      for( uint32_t i = 0; i < 5; ++i )
+      {
+         if( i > 0 ) b.previous = b.id();
+         b.witness = witness_id_type(i+1);
+         bdb.store( b.id(), b );
+         blocks.push_back( b );
+         stored_bytes += fc::raw::pack_size( b );
+      }
+      // the file is grown ahead of the blocks while open
+      BOOST_CHECK( fc::file_size( blocks_file ) > stored_bytes );
+
+      // views point at the stored bytes
+      auto view = bdb.fetch_packed_by_number( 3 );
+      BOOST_REQUIRE( view.valid() );
+      BOOST_CHECK( !view->owner );
+      const auto packed = fc::raw::pack( blocks[2] );
+      BOOST_REQUIRE_EQUAL( view->size, packed.size() );
+      BOOST_CHECK( std::equal( packed.begin(), packed.end(), view->data ) );
+      BOOST_CHECK( !bdb.fetch_packed_by_number( 6 ).valid() );
+
+      auto range = bdb.fetch_packed_range( 2, 100 );
+      BOOST_REQUIRE_EQUAL( range.size(), 4 );
+      for( uint32_t i = 0; i < range.size(); ++i )
+         BOOST_CHECK( fc::raw::unpack<signed_block>( vector<char>( range[i].data, range[i].data + range[i].size ) ).id()
+                      == blocks[i+1].id() );
+      BOOST_CHECK( bdb.fetch_packed_range( 6, 10 ).empty() );
+      BOOST_CHECK( bdb.fetch_packed_range( 3, 2 ).empty() );
+
+      // removing the head truncates to the block before it, another block may take its number
+      bdb.remove( blocks[4].id() );
+      BOOST_CHECK( !bdb.contains( blocks[4].id() ) );
+      BOOST_CHECK( !bdb.fetch_by_number( 5 ).valid() );
+      BOOST_REQUIRE( bdb.last_id().valid() );
+      BOOST_CHECK( *bdb.last_id() == blocks[3].id() );
+      BOOST_CHECK_EQUAL( bdb.fetch_packed_range( 1, 100 ).size(), 4 );
+
+      signed_block fork = blocks[4];
+      fork.witness = witness_id_type(10);
+      bdb.store( fork.id(), fork );
+      stored_bytes += fc::raw::pack_size( fork );
+      BOOST_REQUIRE( bdb.fetch_by_number( 5 ).valid() );
+      BOOST_CHECK( bdb.fetch_by_number( 5 )->witness == witness_id_type(10) );
+
+      // close() cuts the room off again, and everything is back after reopening
+      bdb.close();
+      BOOST_CHECK_EQUAL( fc::file_size( blocks_file ), stored_bytes );
+      bdb.open( data_dir.path() );
+      BOOST_REQUIRE( bdb.last_id().valid() );
+      BOOST_CHECK( *bdb.last_id() == fork.id() );
+      for( uint32_t i = 0; i < 4; ++i )
+         BOOST_CHECK( bdb.fetch_by_number( i+1 )->id() == blocks[i].id() );
+
+      // a node stopped without close() leaves the grown file behind, new blocks still follow the last one
+      bdb.close();
+      fc::resize_file( blocks_file, stored_bytes + 4096 );
+      bdb.open( data_dir.path() );
+      signed_block next;
+      next.previous = fork.id();
+      next.witness = witness_id_type(11);
+      bdb.store( next.id(), next );
+      stored_bytes += fc::raw::pack_size( next );
+      BOOST_REQUIRE( bdb.fetch_by_number( 6 ).valid() );
+      BOOST_CHECK( bdb.fetch_by_number( 6 )->id() == next.id() );
+      bdb.close();
+      BOOST_CHECK_EQUAL( fc::file_size( blocks_file ), stored_bytes );
+      bdb.open( data_dir.path() );
+      BOOST_CHECK( *bdb.last_id() == next.id() );
+      BOOST_CHECK( bdb.fetch_by_number( 5 )->id() == fork.id() );
+   } catch (fc::exception& e) {
+      edump((e.to_detail_string()));
+      throw;
+   }
+}
+
 BOOST_AUTO_TEST_CASE( generate_empty_blocks )
 {
    try {
@@ -553,6 +641,73 @@ BOOST_AUTO_TEST_CASE( duplicate_transactions )
    }
 }
 
+BOOST_AUTO_TEST_CASE( fee_pool_accumulation )
+{
+   try {
+      // db1 credits the fee pool once per block, db2 on every fee; applying the same blocks must give the same state
+      fc::temp_directory dir1( graphene::utilities::temp_directory_path() ),
+                         dir2( graphene::utilities::temp_directory_path() );
+      database db1,
+               db2;
+      db2.enable_fee_pool_accumulation( false );
+      auto genesis_with_fees = []() {
+         genesis_state_type genesis_state = make_genesis();
+         genesis_state.initial_parameters.current_fees = fee_schedule::get_default();
+         return genesis_state;
+      };
+      db1.open(dir1.path(), genesis_with_fees, "TEST");
+      db2.open(dir2.path(), genesis_with_fees, "TEST");
+
+      auto state_digest = []( const database& db ) {
+         digest_type::encoder enc;
+         for( uint8_t space : { uint8_t( protocol_ids ), uint8_t( implementation_ids ) } )
+            for( uint8_t type = 0; type < 32; ++type )
+            {
+               const graphene::db::index* idx = nullptr;
+               try {
+                  idx = &db.get_index( space, type );
+               } catch( const fc::exception& ) {
+                  continue;
+               }
+               idx->inspect_all_objects( [&]( const graphene::db::object& obj ) {
+                  fc::raw::pack( enc, fc::json::to_string( obj.to_variant() ) );
+               } );
+            }
+         return enc.result();
+      };
+
+      auto skip_sigs = database::skip_transaction_signatures | database::skip_authority_check;
+      auto init_account_priv_key  = fc::ecc::private_key::regenerate(fc::sha256::hash(string("null_key")) );
+      const auto& accounts_by_name = db1.get_index_type<account_index>().indices().get<by_name>();
+
+      for( uint32_t b = 0; b < 5; ++b )
+      {
+         for( uint32_t i = 0; i < 20; ++i )
+         {
+            signed_transaction trx;
+            set_expiration( db1, trx );
+            transfer_operation t;
+            t.to = accounts_by_name.find( "init" + fc::to_string( uint64_t( i % 10 ) ) )->id;
+            t.amount = asset( 1000 + b * 100 + i );
+            trx.operations.push_back( t );
+            db1.current_fee_schedule().set_fee( trx.operations.back() );
+            PUSH_TX( db1, trx, skip_sigs );
+         }
+         // the last block also runs the maintenance
+         const uint32_t slot = b < 4 ? 1 : db1.get_slot_at_time( db1.get_dynamic_global_properties().next_maintenance_time );
+         auto blk = db1.generate_block( db1.get_slot_time( slot ), db1.get_scheduled_witness( slot ), init_account_priv_key, skip_sigs );
+         PUSH_BLOCK( db2, blk, skip_sigs );
+         BOOST_CHECK( state_digest( db1 ) == state_digest( db2 ) );
+      }
+      BOOST_CHECK( db1.get_balance( GRAPHENE_UMT_FEE_POOL_ACCOUNT, asset_id_type() ).amount > 0 );
+      BOOST_CHECK( db1.get_balance( GRAPHENE_UMT_FEE_POOL_ACCOUNT, asset_id_type() ) ==
+                   db2.get_balance( GRAPHENE_UMT_FEE_POOL_ACCOUNT, asset_id_type() ) );
+   } catch (fc::exception& e) {
+      edump((e.to_detail_string()));
+      throw;
+   }
+}
+
 BOOST_AUTO_TEST_CASE( tapos )
 {
    try {
@@ -1194,6 +1349,113 @@ BOOST_FIXTURE_TEST_CASE( transaction_invalidated_in_cache, database_fixture )
    }
 }
 
+BOOST_FIXTURE_TEST_CASE( recent_transaction_cache, database_fixture )
+{
+   try {
+      ACTORS( (alice)(bob) );
+      fund( alice, asset( 1000000 ) );
+      generate_block();
+
+      signed_transaction trx;
+      transfer_operation op;
+      op.from = alice_id;
+      op.to = bob_id;
+      op.amount = asset( 1000 );
+      trx.operations.push_back( op );
+      set_expiration( db, trx );
+      trx.sign( alice_private_key, db.get_chain_id() );
+      PUSH_TX( db, trx );
+      const transaction_id_type trx_id = trx.id();
+
+      auto cached = db.get_recent_transaction( trx_id );
+      BOOST_REQUIRE( cached );
+      BOOST_CHECK( cached->id() == trx_id );
+
+      // dropping the body from the cache neither affects its holders nor the duplicate check
+      db.recent_transactions().set_max_bytes( 0 );
+      BOOST_CHECK_EQUAL( db.recent_transactions().size(), 0 );
+      GRAPHENE_CHECK_THROW( db.get_recent_transaction( trx_id ), fc::exception );
+      BOOST_CHECK( cached->id() == trx_id );
+      BOOST_CHECK( db.is_known_transaction( trx_id ) );
+      GRAPHENE_CHECK_THROW( PUSH_TX( db, trx ), fc::exception );
+
+      // only the newest transactions fit
+      db.recent_transactions().set_max_bytes( fc::raw::pack_size( trx ) * 3 / 2 );
+      for( int i = 0; i < 2; ++i )
+      {
+         trx.operations.front().get<transfer_operation>().amount = asset( 10 + i );
+         trx.signatures.clear();
+         trx.sign( alice_private_key, db.get_chain_id() );
+         PUSH_TX( db, trx );
+      }
+      BOOST_CHECK_EQUAL( db.recent_transactions().size(), 1 );
+      BOOST_CHECK( db.get_recent_transaction( trx.id() )->operations.front().get<transfer_operation>().amount
+                   == asset( 11 ) );
+
+      // a transaction whose operations fail is not kept
+      db.recent_transactions().set_max_bytes( 1024 * 1024 );
+      signed_transaction failing = trx;
+      failing.operations.front().get<transfer_operation>().amount = asset( 100000000 );
+      failing.signatures.clear();
+      failing.sign( alice_private_key, db.get_chain_id() );
+      GRAPHENE_CHECK_THROW( PUSH_TX( db, failing ), fc::exception );
+      GRAPHENE_CHECK_THROW( db.get_recent_transaction( failing.id() ), fc::exception );
+      BOOST_CHECK_EQUAL( db.recent_transactions().size(), 1 );
+
+      // and bodies expire with their transactions
+      generate_blocks( trx.expiration + db.get_global_properties().parameters.block_interval );
+      BOOST_CHECK_EQUAL( db.recent_transactions().size(), 0 );
+      BOOST_CHECK_EQUAL( db.recent_transactions().size_bytes(), 0 );
+   } FC_LOG_AND_RETHROW()
+}
+
+BOOST_FIXTURE_TEST_CASE( write_lock_holds_off_tasks_of_the_same_thread, database_fixture )
+{
+   try {
+      ACTORS( (alice)(bob) );
+      fund( alice, asset( 1000000 ) );
+      generate_block();
+
+      signed_transaction trx;
+      transfer_operation op;
+      op.from = alice_id;
+      op.to = bob_id;
+      op.amount = asset( 1000 );
+      trx.operations.push_back( op );
+      set_expiration( db, trx );
+      trx.sign( alice_private_key, db.get_chain_id() );
+
+      // the block waits halfway through, like a plugin which waits in applied_block
+      fc::promise<void>::ptr resume_block( new fc::promise<void>( "resume block" ) );
+      bool block_waiting = false;
+      bool trx_pushed = false;
+      boost::signals2::scoped_connection waiter = db.applied_block.connect( [&]( const signed_block& ) {
+         block_waiting = true;
+         fc::future<void>( resume_block ).wait();
+         block_waiting = false;
+      } );
+
+      fc::future<void> block_done = fc::async( [&]() { generate_block(); }, "push block" );
+      fc::usleep( fc::milliseconds( 100 ) );
+      BOOST_REQUIRE( block_waiting );
+
+      // a second task of this thread has to wait for the block instead of changing the state under it
+      fc::future<void> trx_done = fc::async( [&]() {
+         PUSH_TX( db, trx );
+         trx_pushed = true;
+      }, "push transaction" );
+      fc::usleep( fc::milliseconds( 100 ) );
+      BOOST_CHECK( !trx_pushed );
+      BOOST_CHECK_EQUAL( get_balance( bob_id, asset_id_type() ), 0 );
+
+      resume_block->set_value();
+      block_done.wait();
+      trx_done.wait();
+      BOOST_CHECK( trx_pushed );
+      BOOST_CHECK_EQUAL( get_balance( bob_id, asset_id_type() ), 1000 );
+   } FC_LOG_AND_RETHROW()
+}
+
 BOOST_AUTO_TEST_CASE( genesis_reserve_ids )
 {
    try
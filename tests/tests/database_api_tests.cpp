@@ -24,9 +24,12 @@
 
 #include <boost/test/unit_test.hpp>
 
+#include <graphene/app/api.hpp>
 #include <graphene/app/database_api.hpp>
+#include <graphene/chain/worker_object.hpp>
 
 #include <fc/crypto/digest.hpp>
+#include <fc/io/json.hpp>
 
 #include "../common/database_fixture.hpp"
 
@@ -124,4 +127,189 @@ BOOST_AUTO_TEST_CASE( get_potential_signatures_other ) {
    } FC_LOG_AND_RETHROW()
 }
 
+BOOST_AUTO_TEST_CASE( get_asset_holders ) {
+   try {
+      ACTORS( (alice)(bob)(carol) );
+      const asset_id_type hold = create_user_issued_asset( "HOLD" ).id;
+      issue_uia( alice, asset( 300, hold ) );
+      issue_uia( bob, asset( 200, hold ) );
+      issue_uia( carol, asset( 100, hold ) );
+      generate_block();
+
+      graphene::app::asset_api ast_api( db );
+      BOOST_CHECK_EQUAL( ast_api.get_asset_holders_count( hold ), 3 );
+      auto holders = ast_api.get_asset_holders( hold, 0, 100 );
+      BOOST_REQUIRE_EQUAL( holders.size(), 3 );
+      BOOST_CHECK( holders[0].account_id == alice_id );
+      BOOST_CHECK( holders[1].account_id == bob_id );
+      BOOST_CHECK( holders[2].account_id == carol_id );
+      BOOST_CHECK_EQUAL( holders[2].amount.value, 100 );
+
+      // offset pages
+      holders = ast_api.get_asset_holders( hold, 1, 1 );
+      BOOST_REQUIRE_EQUAL( holders.size(), 1 );
+      BOOST_CHECK( holders[0].account_id == bob_id );
+      BOOST_CHECK( ast_api.get_asset_holders( hold, 3, 100 ).empty() );
+
+      // an emptied balance is no holder anymore, and an undone block restores it
+      transfer( carol_id, alice_id, asset( 100, hold ) );
+      transfer( alice_id, bob_id, asset( 250, hold ) );
+      generate_block();
+      BOOST_CHECK_EQUAL( ast_api.get_asset_holders_count( hold ), 2 );
+      holders = ast_api.get_asset_holders( hold, 0, 100 );
+      BOOST_REQUIRE_EQUAL( holders.size(), 2 );
+      BOOST_CHECK( holders[0].account_id == bob_id );
+      BOOST_CHECK_EQUAL( holders[0].amount.value, 450 );
+      BOOST_CHECK( holders[1].account_id == alice_id );
+
+      db.pop_block();
+      BOOST_CHECK_EQUAL( ast_api.get_asset_holders_count( hold ), 3 );
+      holders = ast_api.get_asset_holders( hold, 0, 100 );
+      BOOST_REQUIRE_EQUAL( holders.size(), 3 );
+      BOOST_CHECK( holders[0].account_id == alice_id );
+      BOOST_CHECK( holders[2].account_id == carol_id );
+
+      bool found = false;
+      for( const auto& h : ast_api.get_all_asset_holders() )
+         if( h.asset_id == hold )
+         {
+            found = true;
+            BOOST_CHECK_EQUAL( h.count, 3 );
+         }
+      BOOST_CHECK( found );
+
+   } FC_LOG_AND_RETHROW()
+}
+
+BOOST_AUTO_TEST_CASE( get_full_accounts_fields ) {
+   try {
+      ACTORS( (alice)(bob) );
+      fund( alice, asset( 1000 ) );
+      generate_block();
+
+      graphene::app::database_api db_api( db );
+      auto page = db_api.get_full_accounts_fields( { "alice", "nobody", string( object_id_type( bob_id ) ) },
+                                                   graphene::app::full_account_balances | graphene::app::full_account_limit_orders );
+      BOOST_CHECK( page.remaining.empty() );
+      BOOST_REQUIRE_EQUAL( page.accounts.size(), 2 );
+      const auto& alice_fields = page.accounts["alice"];
+      BOOST_CHECK_EQUAL( alice_fields.size(), 2 );
+      BOOST_CHECK( alice_fields.contains( "balances" ) );
+      BOOST_CHECK( alice_fields.contains( "limit_orders" ) );
+      BOOST_CHECK( !alice_fields.contains( "account" ) );
+      const auto balances = alice_fields["balances"].as<vector<account_balance_object>>();
+      BOOST_REQUIRE_EQUAL( balances.size(), 1 );
+      BOOST_CHECK_EQUAL( balances[0].balance.value, 1000 );
+      BOOST_CHECK( page.accounts.count( string( object_id_type( bob_id ) ) ) );
+
+      // the same members as get_full_accounts()
+      auto full = db_api.get_full_accounts( { "alice" }, false );
+      page = db_api.get_full_accounts_fields( { "alice" } );
+      BOOST_CHECK_EQUAL( fc::json::to_string( page.accounts["alice"] ), fc::json::to_string( fc::variant( full["alice"] ) ) );
+
+      // a tiny cap still returns one account, and the rest for the next call
+      page = db_api.get_full_accounts_fields( { "alice", "bob" }, graphene::app::full_account_all, 1 );
+      BOOST_CHECK_EQUAL( page.accounts.size(), 1 );
+      BOOST_CHECK( page.accounts.count( "alice" ) );
+      BOOST_REQUIRE_EQUAL( page.remaining.size(), 1 );
+      BOOST_CHECK_EQUAL( page.remaining[0], "bob" );
+
+   } FC_LOG_AND_RETHROW()
+}
+
+BOOST_AUTO_TEST_CASE( list_bid_requests_paged ) {
+   try {
+      ACTORS( (alice)(bob)(carol) );
+      const asset_id_type ua = create_user_issued_asset( "UAA" ).id;
+      const asset_id_type ub = create_user_issued_asset( "UBB" ).id;
+      const asset_id_type uc = create_user_issued_asset( "UCC" ).id;
+
+      // names run against the id order, so that name and id ordering can be told apart
+      auto create_request = [&]( const string& name, flat_set<account_id_type> providers, flat_set<asset_id_type> assets ) {
+         return db.create<bid_request_object>( [&]( bid_request_object& r ) {
+            r.owner = carol_id;
+            r.name = name;
+            r.providers = providers;
+            r.assets = assets;
+            r.expiration = db.head_block_time() + fc::days(1);
+         }).get_id();
+      };
+      const bid_request_id_type r0 = create_request( "d", { alice_id }, { ua } );
+      const bid_request_id_type r1 = create_request( "c", { alice_id, bob_id }, { ua, ub } );
+      const bid_request_id_type r2 = create_request( "b", { bob_id }, { ub } );
+      const bid_request_id_type r3 = create_request( "a", { alice_id }, {} );
+
+      graphene::app::database_api db_api( db );
+
+      // by provider, ordered by id
+      auto page = db_api.list_bid_requests_by_provider_paged( alice_id, bid_request_id_type(), 100 );
+      BOOST_REQUIRE_EQUAL( page.size(), 3 );
+      BOOST_CHECK( page[0].id == r0 );
+      BOOST_CHECK( page[1].id == r1 );
+      BOOST_CHECK( page[2].id == r3 );
+      page = db_api.list_bid_requests_by_provider_paged( alice_id, bid_request_id_type(), 2 );
+      BOOST_REQUIRE_EQUAL( page.size(), 2 );
+      BOOST_CHECK( page[1].id == r1 );
+      page = db_api.list_bid_requests_by_provider_paged( alice_id, bid_request_id_type( r1.instance.value + 1 ), 2 );
+      BOOST_REQUIRE_EQUAL( page.size(), 1 );
+      BOOST_CHECK( page[0].id == r3 );
+      page = db_api.list_bid_requests_by_provider_paged( alice_id, r3, 2 );
+      BOOST_REQUIRE_EQUAL( page.size(), 1 );
+      BOOST_CHECK( page[0].id == r3 );
+      BOOST_CHECK( db_api.list_bid_requests_by_provider_paged( alice_id, bid_request_id_type( r3.instance.value + 1 ), 2 ).empty() );
+      BOOST_CHECK( db_api.list_bid_requests_by_provider_paged( alice_id, bid_request_id_type(), 0 ).empty() );
+      BOOST_CHECK( db_api.list_bid_requests_by_provider_paged( carol_id, bid_request_id_type(), 100 ).empty() );
+      GRAPHENE_REQUIRE_THROW( db_api.list_bid_requests_by_provider_paged( alice_id, bid_request_id_type(), 1001 ), fc::exception );
+
+      // by asset, ordered by id
+      page = db_api.list_bid_requests_by_asset( ub, bid_request_id_type(), 100 );
+      BOOST_REQUIRE_EQUAL( page.size(), 2 );
+      BOOST_CHECK( page[0].id == r1 );
+      BOOST_CHECK( page[1].id == r2 );
+      page = db_api.list_bid_requests_by_asset( ub, r2, 100 );
+      BOOST_REQUIRE_EQUAL( page.size(), 1 );
+      BOOST_CHECK( page[0].id == r2 );
+      BOOST_CHECK( db_api.list_bid_requests_by_asset( ub, bid_request_id_type( r2.instance.value + 1 ), 100 ).empty() );
+      BOOST_CHECK( db_api.list_bid_requests_by_asset( uc, bid_request_id_type(), 100 ).empty() );
+      GRAPHENE_REQUIRE_THROW( db_api.list_bid_requests_by_asset( ua, bid_request_id_type(), 1001 ), fc::exception );
+
+      // by name with an assets filter; r1 is listed under both assets but returned once
+      page = db_api.list_bid_requests( "", vector<asset_id_type>{ ua, ub, uc }, 100 );
+      BOOST_REQUIRE_EQUAL( page.size(), 3 );
+      BOOST_CHECK( page[0].id == r2 );
+      BOOST_CHECK( page[1].id == r1 );
+      BOOST_CHECK( page[2].id == r0 );
+      page = db_api.list_bid_requests( "c", vector<asset_id_type>{ ub, ua }, 1 );
+      BOOST_REQUIRE_EQUAL( page.size(), 1 );
+      BOOST_CHECK( page[0].id == r1 );
+      page = db_api.list_bid_requests( "ca", vector<asset_id_type>{ ub, ua }, 100 );
+      BOOST_REQUIRE_EQUAL( page.size(), 1 );
+      BOOST_CHECK( page[0].id == r0 );
+      BOOST_CHECK( db_api.list_bid_requests( "e", vector<asset_id_type>{ ua, ub }, 100 ).empty() );
+      BOOST_CHECK( db_api.list_bid_requests( "", vector<asset_id_type>{ uc }, 100 ).empty() );
+      BOOST_CHECK( db_api.list_bid_requests( "", vector<asset_id_type>(), 100 ).empty() );
+
+      // the reverse indexes follow renames and membership changes
+      db.modify( r1(db), [&]( bid_request_object& r ) {
+         r.name = "e";
+         r.providers = { bob_id };
+         r.assets = { ub };
+      });
+      page = db_api.list_bid_requests_by_provider_paged( alice_id, bid_request_id_type(), 100 );
+      BOOST_REQUIRE_EQUAL( page.size(), 2 );
+      BOOST_CHECK( page[1].id == r3 );
+      BOOST_CHECK_EQUAL( db_api.list_bid_requests_by_asset( ua, bid_request_id_type(), 100 ).size(), 1 );
+      page = db_api.list_bid_requests( "", vector<asset_id_type>{ ua, ub }, 100 );
+      BOOST_REQUIRE_EQUAL( page.size(), 3 );
+      BOOST_CHECK( page[0].id == r2 );
+      BOOST_CHECK( page[1].id == r0 );
+      BOOST_CHECK( page[2].id == r1 );
+
+      db.remove( r0(db) );
+      BOOST_CHECK( db_api.list_bid_requests_by_asset( ua, bid_request_id_type(), 100 ).empty() );
+      BOOST_CHECK_EQUAL( db_api.list_bid_requests( "", vector<asset_id_type>{ ua, ub }, 100 ).size(), 2 );
+
+   } FC_LOG_AND_RETHROW()
+}
+
 BOOST_AUTO_TEST_SUITE_END()
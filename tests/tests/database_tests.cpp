@@ -27,9 +27,15 @@
 #include <graphene/chain/database.hpp>
 
 #include <graphene/chain/account_object.hpp>
+#include <graphene/chain/market_object.hpp>
+#include <graphene/chain/worker_object.hpp>
+
+#include <graphene/utilities/tempdir.hpp>
 
 #include <fc/crypto/digest.hpp>
 
+#include <fstream>
+
 #include "../common/database_fixture.hpp"
 
 using namespace graphene::chain;
@@ -81,4 +87,277 @@ BOOST_AUTO_TEST_CASE( merge_test )
    }
 }
 
+BOOST_AUTO_TEST_CASE( undo_merge_test )
+{
+   try {
+      database db;
+      db._undo_db.enable();
+      vector<account_balance_id_type> ids;
+      for( int i = 0; i < 100; ++i )
+         ids.push_back( account_balance_id_type( db.create<account_balance_object>( [&]( account_balance_object& obj ){
+            obj.owner = account_id_type( i );
+            obj.balance = i;
+         }).id ) );
+
+      {
+         auto block_session = db._undo_db.start_undo_session();
+         for( int i = 0; i < 100; ++i )
+         {
+            auto trx_session = db._undo_db.start_undo_session();
+            db.modify( ids[i](db), []( account_balance_object& obj ){ obj.balance += 1000; } );
+            if( i % 3 == 0 )
+               db.remove( ids[i](db) );
+            db.create<account_balance_object>( [&]( account_balance_object& obj ){
+               obj.owner = account_id_type( 1000 + i );
+               obj.balance = 7;
+            });
+            trx_session.merge();
+         }
+         BOOST_CHECK_EQUAL( db.get_index_type<account_balance_index>().indices().size(), 100 + 100 - 34 );
+         block_session.undo();
+      }
+
+      BOOST_CHECK_EQUAL( db.get_index_type<account_balance_index>().indices().size(), 100 );
+      for( int i = 0; i < 100; ++i )
+         BOOST_CHECK_EQUAL( ids[i](db).balance.value, i );
+   } catch ( const fc::exception& e )
+   {
+      edump( (e.to_detail_string()) );
+      throw;
+   }
+}
+
+BOOST_AUTO_TEST_CASE( snapshot_test )
+{
+   try {
+      fc::temp_directory dir( graphene::utilities::temp_directory_path() );
+      fc::path file = dir.path() / "balances";
+
+      database db;
+      for( int i = 0; i < 1000; ++i )
+         db.create<account_balance_object>( [&]( account_balance_object& obj ){
+            obj.owner = account_id_type( i );
+            obj.balance = i;
+         });
+      const_cast<account_balance_index&>( db.get_index_type<account_balance_index>() ).save( file );
+
+      database db2;
+      const_cast<account_balance_index&>( db2.get_index_type<account_balance_index>() ).open( file );
+      BOOST_CHECK_EQUAL( db2.get_index_type<account_balance_index>().indices().size(), 1000 );
+      BOOST_CHECK_EQUAL( db2.get_balance( account_id_type(999), asset_id_type() ).amount.value, 999 );
+      BOOST_CHECK( db2.get_index_type<account_balance_index>().get_next_id() == db.get_index_type<account_balance_index>().get_next_id() );
+
+      // a truncated file must not look like a smaller, complete one
+      fc::resize_file( file, fc::file_size( file ) - 10 );
+      database db3;
+      GRAPHENE_REQUIRE_THROW( const_cast<account_balance_index&>( db3.get_index_type<account_balance_index>() ).open( file ),
+                              fc::exception );
+
+      // an object count the file cannot hold is rejected before anything is allocated for it
+      const_cast<account_balance_index&>( db.get_index_type<account_balance_index>() ).save( file );
+      {
+         std::fstream f( file.generic_string(), std::ios::in | std::ios::out | std::ios::binary );
+         graphene::db::snapshot_header header;
+         fc::raw::unpack( f, header );
+         header.object_count = std::numeric_limits<uint64_t>::max() / 2;
+         f.seekp( 0 );
+         fc::raw::pack( f, header );
+      }
+      database db4;
+      GRAPHENE_REQUIRE_THROW( const_cast<account_balance_index&>( db4.get_index_type<account_balance_index>() ).open( file ),
+                              fc::exception );
+   } catch ( const fc::exception& e )
+   {
+      edump( (e.to_detail_string()) );
+      throw;
+   }
+}
+
+BOOST_AUTO_TEST_CASE( profiler_test )
+{
+   try {
+      ACTOR(nathan);
+      generate_block();
+
+      db.enable_profiling( true );
+      transfer( account_id_type()(db), nathan, asset(1000) );
+      generate_block();
+      db.enable_profiling( false );
+      transfer( account_id_type()(db), nathan, asset(1000) );
+      generate_block();
+
+      chain_profile profile = db.profiler().report();
+      BOOST_REQUIRE( profile.operations.count( "transfer" ) );
+      const operation_profile& transfers = profile.operations["transfer"];
+      // applied when pushed as pending transaction and again with the block
+      BOOST_CHECK( transfers.evaluate.count >= 2 );
+      BOOST_CHECK_EQUAL( transfers.apply.count, transfers.evaluate.count );
+      BOOST_CHECK( transfers.objects_modified > 0 );
+      BOOST_CHECK_EQUAL( profile.blocks.total.count, 1 );
+      BOOST_CHECK_EQUAL( profile.blocks.transactions.count, 1 );
+      BOOST_CHECK_EQUAL( profile.first_block_num, db.head_block_num() - 1 );
+
+      db.profiler().reset();
+      BOOST_CHECK( db.profiler().report().operations.empty() );
+   } catch ( const fc::exception& e )
+   {
+      edump( (e.to_detail_string()) );
+      throw;
+   }
+}
+
+BOOST_AUTO_TEST_CASE( dense_index_find_test )
+{
+   try {
+      database db;
+      // enough balances for several segments of the instance table
+      const uint32_t count = 10000;
+      vector<account_balance_id_type> ids;
+      for( uint32_t i = 0; i < count; ++i )
+         ids.push_back( db.create<account_balance_object>( [&]( account_balance_object& obj ){
+            obj.owner = account_id_type( i );
+         }).id );
+      for( uint32_t i = 0; i < count; ++i )
+         BOOST_CHECK( ids[i](db).owner == account_id_type( i ) );
+      BOOST_CHECK( db.find( account_balance_id_type( count ) ) == nullptr );
+
+      // removed objects are gone, also when a whole segment of them is
+      for( uint32_t i = 0; i < 5000; ++i )
+         db.remove( ids[i](db) );
+      for( uint32_t i = 0; i < count; ++i )
+         BOOST_CHECK( ( db.find( ids[i] ) == nullptr ) == ( i < 5000 ) );
+
+      // and undo brings back removed objects and takes created ones out
+      {
+         auto ses = db._undo_db.start_undo_session();
+         for( uint32_t i = 5000; i < count; ++i )
+            db.remove( ids[i](db) );
+         const auto& created = db.create<account_balance_object>( [&]( account_balance_object& obj ){
+            obj.owner = account_id_type( count );
+         });
+         BOOST_CHECK( db.find( created.id ) == &created );
+         BOOST_CHECK( db.find( ids[count - 1] ) == nullptr );
+         ses.undo();
+      }
+      for( uint32_t i = 5000; i < count; ++i )
+         BOOST_CHECK( ids[i](db).owner == account_id_type( i ) );
+      BOOST_CHECK( db.find( account_balance_id_type( count ) ) == nullptr );
+      BOOST_CHECK( db.find( ids[0] ) == nullptr );
+   } catch ( const fc::exception& e )
+   {
+      edump( (e.to_detail_string()) );
+      throw;
+   }
+}
+
+BOOST_AUTO_TEST_CASE( asset_holders_follow_balances )
+{
+   try {
+      ACTORS( (alice)(bob)(carol) );
+      const asset_object& coin = create_user_issued_asset( "COIN" );
+      const auto& bal_idx = dynamic_cast<const primary_index<account_balance_index>&>(
+                               db.get_index_type<account_balance_index>() );
+      const auto& holder_idx = bal_idx.get_secondary_index<asset_holder_index>();
+
+      issue_uia( alice, coin.amount( 300 ) );
+      // the holders are built from the balances when first asked for
+      BOOST_REQUIRE_EQUAL( holder_idx.holders( coin.id ).size(), 1 );
+
+      // and changes after that are sorted in when asked for again
+      issue_uia( bob, coin.amount( 200 ) );
+      issue_uia( carol, coin.amount( 100 ) );
+      transfer( alice_id, carol_id, coin.amount( 250 ) );
+      {
+         const auto& holders = holder_idx.holders( coin.id );
+         BOOST_REQUIRE_EQUAL( holders.size(), 3 );
+         auto itr = holders.begin();
+         BOOST_CHECK( itr->owner == carol_id && itr->balance == 350 );
+         ++itr;
+         BOOST_CHECK( itr->owner == bob_id && itr->balance == 200 );
+         ++itr;
+         BOOST_CHECK( itr->owner == alice_id && itr->balance == 50 );
+      }
+
+      // emptied balances are no holders, also when changed back by undo
+      {
+         auto ses = db._undo_db.start_undo_session();
+         transfer( bob_id, carol_id, coin.amount( 200 ) );
+         BOOST_CHECK_EQUAL( holder_idx.holders( coin.id ).size(), 2 );
+         BOOST_CHECK( holder_idx.holders( coin.id ).begin()->balance == 550 );
+         ses.undo();
+      }
+      BOOST_CHECK_EQUAL( holder_idx.holders( coin.id ).size(), 3 );
+      BOOST_CHECK( holder_idx.holders( coin.id ).nth( 1 )->owner == bob_id );
+   } catch ( const fc::exception& e )
+   {
+      edump( (e.to_detail_string()) );
+      throw;
+   }
+}
+
+BOOST_AUTO_TEST_CASE( bid_expiry_tracking_survives_undo_of_removal )
+{
+   try {
+      const auto& request_expiry = dynamic_cast<const primary_index<bid_request_index>&>(
+                                      db.get_index_type<bid_request_index>() ).get_secondary_index< expiry_index<bid_request_object> >();
+      const auto& bid_expiry = dynamic_cast<const primary_index<bid_index>&>(
+                                  db.get_index_type<bid_index>() ).get_secondary_index< expiry_index<bid_object> >();
+      const fc::time_point_sec expiration = db.head_block_time() + fc::days(1);
+
+      // a request with one bid on it, and one limit order accepting that bid, next to an unreferenced request
+      bid_request_id_type request_id = db.create<bid_request_object>( [&]( bid_request_object& r ) {
+         r.name = "request";
+         r.expiration = expiration;
+      }).id;
+      bid_request_id_type lone_request_id = db.create<bid_request_object>( [&]( bid_request_object& r ) {
+         r.name = "lone request";
+         r.expiration = expiration + 1;
+      }).id;
+      bid_id_type bid_id = db.create<bid_object>( [&]( bid_object& b ) {
+         b.name = "bid";
+         b.request = request_id;
+         b.expiration = expiration;
+      }).id;
+      limit_order_id_type order_id = db.create<limit_order_object>( [&]( limit_order_object& o ) {
+         o.expiration = expiration;
+         o.bid_id = bid_id;
+      }).id;
+
+      const auto requests_before = request_expiry.unreferenced;
+      const auto bids_before = bid_expiry.unreferenced;
+      BOOST_CHECK_EQUAL( request_expiry.ref_count( request_id ), 1 );
+      BOOST_CHECK_EQUAL( request_expiry.ref_count( lone_request_id ), 0 );
+      BOOST_CHECK_EQUAL( bid_expiry.ref_count( bid_id ), 1 );
+      BOOST_CHECK( requests_before.count( std::make_pair( expiration + 1, lone_request_id ) ) );
+      BOOST_CHECK( !requests_before.count( std::make_pair( expiration, request_id ) ) );
+      BOOST_CHECK( !bids_before.count( std::make_pair( expiration, bid_id ) ) );
+
+      {
+         auto ses = db._undo_db.start_undo_session();
+         db.remove( order_id(db) );
+         BOOST_CHECK_EQUAL( bid_expiry.ref_count( bid_id ), 0 );
+         BOOST_CHECK( bid_expiry.unreferenced.count( std::make_pair( expiration, bid_id ) ) );
+         db.remove( bid_id(db) );
+         db.remove( request_id(db) );
+         db.remove( lone_request_id(db) );
+         BOOST_CHECK_EQUAL( request_expiry.ref_count( request_id ), 0 );
+         BOOST_CHECK( !request_expiry.unreferenced.count( std::make_pair( expiration + 1, lone_request_id ) ) );
+         BOOST_CHECK( !bid_expiry.unreferenced.count( std::make_pair( expiration, bid_id ) ) );
+         ses.undo();
+      }
+
+      // undo re-inserts the removed objects, which must be reported to the secondary indexes again
+      BOOST_CHECK( request_expiry.unreferenced == requests_before );
+      BOOST_CHECK( bid_expiry.unreferenced == bids_before );
+      BOOST_CHECK_EQUAL( request_expiry.ref_count( request_id ), 1 );
+      BOOST_CHECK_EQUAL( request_expiry.ref_count( lone_request_id ), 0 );
+      BOOST_CHECK_EQUAL( bid_expiry.ref_count( bid_id ), 1 );
+      BOOST_CHECK( order_id(db).bid_id == bid_id );
+   } catch ( const fc::exception& e )
+   {
+      edump( (e.to_detail_string()) );
+      throw;
+   }
+}
+
 BOOST_AUTO_TEST_SUITE_END()
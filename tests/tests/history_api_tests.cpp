@@ -36,6 +36,7 @@
 
 #include <graphene/utilities/tempdir.hpp>
 
+#include <fc/crypto/base64.hpp>
 #include <fc/crypto/digest.hpp>
 
 #include "../common/database_fixture.hpp"
@@ -132,4 +133,146 @@ BOOST_AUTO_TEST_CASE(get_account_history_operations) {
    }
 }
 
+BOOST_AUTO_TEST_CASE(get_account_history_by_sequence) {
+   try {
+      graphene::app::history_api hist_api(app);
+
+      //account_id_type() do 3 ops
+      create_account("carol");
+      create_account("dave");
+
+      generate_block();
+      fc::usleep(fc::milliseconds(2000));
+
+      uint16_t asset_create_op_id = operation::tag<asset_create_operation>::value;
+      uint16_t account_create_op_id = operation::tag<account_create_operation>::value;
+
+      // the whole history in one page
+      account_history_page page = hist_api.get_account_history_by_sequence(account_id_type(), 0, 100);
+      BOOST_CHECK_EQUAL(page.operations.size(), 3);
+      BOOST_CHECK_EQUAL(page.next, 0);
+      BOOST_CHECK_EQUAL(page.operations[2].id.instance(), 0);
+      BOOST_CHECK_EQUAL(page.operations[2].op.which(), asset_create_op_id);
+
+      // the same operations one page at a time
+      vector<operation_history_object> paged;
+      uint32_t start = 0;
+      do
+      {
+         page = hist_api.get_account_history_by_sequence(account_id_type(), start, 1);
+         BOOST_REQUIRE_EQUAL(page.operations.size(), 1);
+         paged.push_back(page.operations[0]);
+         start = page.next;
+      } while( start != 0 );
+      BOOST_REQUIRE_EQUAL(paged.size(), 3);
+      for( size_t i = 0; i < paged.size(); ++i )
+         BOOST_CHECK(paged[i].id == hist_api.get_account_history_by_sequence(account_id_type(), 0, 100).operations[i].id);
+
+      // only the 2 account_create ops
+      page = hist_api.get_account_history_by_sequence(account_id_type(), 0, 100, { account_create_op_id });
+      BOOST_CHECK_EQUAL(page.operations.size(), 2);
+      BOOST_CHECK_EQUAL(page.operations[0].op.which(), account_create_op_id);
+      BOOST_CHECK_EQUAL(page.operations[1].op.which(), account_create_op_id);
+      BOOST_CHECK(page.operations[0].id.instance() > page.operations[1].id.instance());
+
+      // several types are merged from the most recent on
+      page = hist_api.get_account_history_by_sequence(account_id_type(), 0, 2, { asset_create_op_id, account_create_op_id });
+      BOOST_CHECK_EQUAL(page.operations.size(), 2);
+      BOOST_CHECK_EQUAL(page.operations[1].op.which(), account_create_op_id);
+      BOOST_CHECK_EQUAL(page.next, 1);
+      page = hist_api.get_account_history_by_sequence(account_id_type(), page.next, 2, { asset_create_op_id, account_create_op_id });
+      BOOST_CHECK_EQUAL(page.operations.size(), 1);
+      BOOST_CHECK_EQUAL(page.operations[0].op.which(), asset_create_op_id);
+      BOOST_CHECK_EQUAL(page.next, 0);
+
+      // dave has 1 op, and no transfer
+      page = hist_api.get_account_history_by_sequence(get_account("dave").id, 0, 100);
+      BOOST_CHECK_EQUAL(page.operations.size(), 1);
+      page = hist_api.get_account_history_by_sequence(get_account("dave").id, 0, 100, { uint16_t(operation::tag<transfer_operation>::value) });
+      BOOST_CHECK_EQUAL(page.operations.size(), 0);
+
+   } catch (fc::exception &e) {
+      edump((e.to_detail_string()));
+      throw;
+   }
+}
+
+BOOST_AUTO_TEST_CASE(stream_blocks) {
+   try {
+      ACTORS((alice));
+      for( int i = 0; i < 20; ++i )
+      {
+         transfer(account_id_type(), alice_id, asset(10));
+         generate_block();
+      }
+      const uint32_t head = db.head_block_num();
+
+      graphene::app::block_api blk_api(db);
+      vector<block_stream_chunk> chunks;
+      bool done = false;
+      auto collect = [&]( const variant& v ) {
+         chunks.push_back( v.as<block_stream_chunk>() );
+         done = chunks.back().next_block_num == 0;
+         return true;
+      };
+      auto wait_done = [&]() {
+         for( int i = 0; i < 500 && !done; ++i )
+            fc::usleep(fc::milliseconds(10));
+         BOOST_REQUIRE( done );
+      };
+
+      // chunks of 3 blocks, packed, with their operations
+      block_stream_options options;
+      options.encoding = "base64";
+      options.include_operations = true;
+      options.max_chunk_blocks = 3;
+      blk_api.stream_blocks( collect, 2, head + 10, options );
+      wait_done();
+      uint32_t block_num = 2;
+      uint32_t transfers = 0;
+      for( const auto& chunk : chunks )
+      {
+         BOOST_CHECK_EQUAL( chunk.first_block_num, block_num );
+         BOOST_CHECK( chunk.blocks.size() <= 3 );
+         BOOST_REQUIRE_EQUAL( chunk.operations.size(), chunk.blocks.size() );
+         BOOST_CHECK( !chunk.error.valid() );
+         for( size_t i = 0; i < chunk.blocks.size(); ++i, ++block_num )
+         {
+            const string packed = fc::base64_decode( chunk.blocks[i].as_string() );
+            const auto block = fc::raw::unpack<signed_block>( vector<char>( packed.begin(), packed.end() ) );
+            BOOST_CHECK( block.id() == db.fetch_block_by_number( block_num )->id() );
+            for( const auto& op : chunk.operations[i] )
+            {
+               BOOST_CHECK_EQUAL( op.block_num, block_num );
+               if( op.op.which() == operation::tag<transfer_operation>::value )
+                  ++transfers;
+            }
+         }
+      }
+      BOOST_CHECK_EQUAL( block_num, head + 1 );
+      BOOST_CHECK_EQUAL( transfers, 20 );
+
+      // the client stops it after the first chunk, as objects
+      chunks.clear();
+      done = false;
+      options = block_stream_options();
+      options.max_chunk_blocks = 5;
+      blk_api.stream_blocks( [&]( const variant& v ) {
+         chunks.push_back( v.as<block_stream_chunk>() );
+         done = true;
+         return false;
+      }, 1, head, options );
+      wait_done();
+      fc::usleep(fc::milliseconds(100));
+      BOOST_REQUIRE_EQUAL( chunks.size(), 1 );
+      BOOST_REQUIRE_EQUAL( chunks[0].blocks.size(), 5 );
+      BOOST_CHECK( chunks[0].blocks[4].as<signed_block>().id() == db.fetch_block_by_number( 5 )->id() );
+      BOOST_CHECK_EQUAL( chunks[0].next_block_num, 6 );
+
+   } catch (fc::exception &e) {
+      edump((e.to_detail_string()));
+      throw;
+   }
+}
+
 BOOST_AUTO_TEST_SUITE_END()
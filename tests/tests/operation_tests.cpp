@@ -460,6 +460,58 @@ BOOST_AUTO_TEST_CASE( create_buy_uia_multiple_match_new )
  }
 }
 
+BOOST_AUTO_TEST_CASE( create_buy_uia_tagged_match )
+{ try {
+   INVOKE( issue_uia );
+   const asset_object&   core_asset     = get_asset( UIA_TEST_SYMBOL );
+   const asset_object&   test_asset     = get_asset( GRAPHENE_SYMBOL );
+   const account_object& nathan_account = get_account( "nathan" );
+   const account_object& buyer_account  = create_account( "buyer" );
+   const account_object& seller_account = create_account( "seller" );
+
+   transfer( committee_account(db), buyer_account, test_asset.amount( 10000 ) );
+   transfer( nathan_account, seller_account, core_asset.amount(10000) );
+
+   auto create_tagged_order = [&]( const account_object& user, const asset& amount, const asset& recv,
+                                   optional<uint64_t> request_id, optional<uint64_t> user_id ) {
+      limit_order_create_operation op;
+      op.seller = user.id;
+      op.amount_to_sell = amount;
+      op.min_to_receive = recv;
+      op.request_id = request_id;
+      op.user_id = user_id;
+      trx.operations.push_back(op);
+      for( auto& o : trx.operations ) db.current_fee_schedule().set_fee(o);
+      trx.validate();
+      auto processed = db.push_transaction(trx, ~0);
+      trx.operations.clear();
+      return processed.operation_results[0].get<object_id_type>();
+   };
+
+   limit_order_id_type untagged_id = create_sell_order( buyer_account, test_asset.amount(100), core_asset.amount(100) )->id;
+   limit_order_id_type other_id    = create_tagged_order( buyer_account, test_asset.amount(100), core_asset.amount(100), 2, 7 );
+   limit_order_id_type tagged_id   = create_tagged_order( buyer_account, test_asset.amount(100), core_asset.amount(200), 1, 7 );
+
+   // only the order carrying the same (request_id, user_id) is matched, even though the others are priced better
+   object_id_type taker_id = create_tagged_order( seller_account, core_asset.amount(200), test_asset.amount(100), 1, 7 );
+   BOOST_CHECK( !db.find( tagged_id ) );
+   BOOST_CHECK( !db.find<limit_order_object>( taker_id ) );
+   BOOST_CHECK( db.find( untagged_id ) );
+   BOOST_CHECK( db.find( other_id ) );
+
+   // an untagged order never crosses a tagged one
+   auto unmatched = create_sell_order( seller_account, core_asset.amount(100), test_asset.amount(100) );
+   BOOST_CHECK( !unmatched );
+   BOOST_CHECK( !db.find( untagged_id ) );
+   BOOST_CHECK( db.find( other_id ) );
+ }
+ catch ( const fc::exception& e )
+ {
+    elog( "${e}", ("e", e.to_detail_string() ) );
+    throw;
+ }
+}
+
 BOOST_AUTO_TEST_CASE( create_buy_exact_match_uia )
 { try {
    INVOKE( issue_uia );
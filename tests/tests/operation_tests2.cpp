@@ -1075,7 +1075,7 @@ BOOST_AUTO_TEST_CASE(transfer_with_memo) {
       BOOST_CHECK_EQUAL(get_balance(alice_id, asset_id_type()), 500);
       BOOST_CHECK_EQUAL(get_balance(bob_id, asset_id_type()), 500);
 
-      auto memo = db.get_recent_transaction(trx.id()).operations.front().get<transfer_operation>().memo;
+      auto memo = db.get_recent_transaction(trx.id())->operations.front().get<transfer_operation>().memo;
       BOOST_CHECK(memo);
       BOOST_CHECK_EQUAL(memo->get_message(bob_private_key, alice_public_key), "Dear Bob,\n\nMoney!\n\nLove, Alice");
    } FC_LOG_AND_RETHROW()